@@ -202,6 +202,14 @@ typedef enum BKNoteType {
     BKNoteTypeNil,
 } BKNoteType;
 
+// The sets of sounds that share one synth's voices
+typedef enum BKSoundSet {
+    MainSoundSet = 0,
+    HammerSoundSet,
+    ResonanceSoundSet,
+    BKSoundSetNil,
+} BKSoundSet;
+
 typedef enum BKPreparationType {
     PreparationTypeDirect = 0,
     PreparationTypeSynchronic,
@@ -711,6 +719,7 @@ typedef enum BKSampleLoadType
     BKLoadLite,
     BKLoadMedium,
     BKLoadHeavy,
+    BKLoadTest,     // tones made in code, not from the samples folder; for renders that have to match (see BKGolden)
     BKLoadNil
     
 }BKSampleLoadType;
@@ -719,7 +728,8 @@ static const std::vector<std::string> cBKSampleLoadTypes = {
     "Load Very Light",
     "Load Light",
     "Load Medium",
-    "Load Heavy"
+    "Load Heavy",
+    "Load Test Tones"
 };
 
 
@@ -0,0 +1,196 @@
+/*
+  ==============================================================================
+
+    BKBlackBox.cpp
+    Created: 19 Oct 2026 11:02:18am
+    Author:
+
+  ==============================================================================
+*/
+
+#include "BKBlackBox.h"
+
+static const char* const stageNames[BlackBoxStageNil] = { "preparations", "midi", "synth", "output" };
+
+static inline float ticksToMs(int64 ticks)
+{
+    return (float) (Time::highResolutionTicksToSeconds(ticks) * 1000.0);
+}
+
+BKBlackBox::BKBlackBox(void):
+Thread("black_box"),
+events(capacity, true),
+written(0),
+dumpAt(-1),
+numOverruns(0),
+numDumps(0),
+blockNumber(0),
+blockSamples(0),
+blockStart(0),
+stageStart(0),
+deadline(0)
+{
+    for (int i = 0; i < BlackBoxStageNil; i++) stageMs[i] = 0.0f;
+}
+
+BKBlackBox::~BKBlackBox(void)
+{
+    stopThread(1000);
+}
+
+void BKBlackBox::record(BKBlackBoxEventType type, int a, int b, float value)
+{
+    const int64 index = written.get();
+
+    BKBlackBoxEvent& event = events[(int) (index % capacity)];
+    event.type = type;
+    event.block = blockNumber;
+    event.ticks = Time::getHighResolutionTicks();
+    event.a = a;
+    event.b = b;
+    event.value = value;
+
+    // Published only once it's all there
+    written.set(index + 1);
+}
+
+void BKBlackBox::blockStarted(double sampleRate, int numSamples)
+{
+    ++blockNumber;
+    blockSamples = numSamples;
+
+    blockStart = stageStart = Time::getHighResolutionTicks();
+    deadline = (sampleRate > 0.0) ? (int64) (numSamples / sampleRate * Time::getHighResolutionTicksPerSecond()) : 0;
+
+    for (int i = 0; i < BlackBoxStageNil; i++) stageMs[i] = 0.0f;
+}
+
+void BKBlackBox::stageFinished(BKBlackBoxStage stage)
+{
+    const int64 now = Time::getHighResolutionTicks();
+
+    stageMs[stage] = ticksToMs(now - stageStart);
+    stageStart = now;
+}
+
+void BKBlackBox::blockFinished(int busyVoices)
+{
+    const int64 taken = Time::getHighResolutionTicks() - blockStart;
+
+    // The slot record() is about to fill in; the stages are the one part it leaves alone
+    BKBlackBoxEvent& event = events[(int) (written.get() % capacity)];
+    for (int i = 0; i < BlackBoxStageNil; i++) event.stages[i] = stageMs[i];
+
+    record(BlackBoxBlock, blockSamples, busyVoices, ticksToMs(deadline));
+
+    if (deadline > 0 && taken > deadline)
+    {
+        numOverruns.set(numOverruns.get() + 1);
+
+        record(BlackBoxOverrun, blockSamples, 0, ticksToMs(taken));
+
+        // One dump at a time; overruns while one is waiting end up in it anyway
+        dumpAt.compareAndSetBool(written.get(), -1);
+    }
+}
+
+void BKBlackBox::run(void)
+{
+    while (!threadShouldExit())
+    {
+        wait(100);
+
+        const int64 end = dumpAt.get();
+
+        if (end < 0) continue;
+
+        if (numDumps < maxDumps)
+        {
+            dump(end);
+            ++numDumps;
+        }
+
+        dumpAt.set(-1);
+    }
+}
+
+void BKBlackBox::dump(int64 end)
+{
+    const int64 first = jmax((int64) 0, end - capacity);
+
+    Array<BKBlackBoxEvent> copy;
+    copy.ensureStorageAllocated(capacity);
+
+    for (int64 i = first; i < end; i++) copy.add(events[(int) (i % capacity)]);
+
+    // Anything the audio thread may have written over while we copied
+    const int64 overwritten = written.get() - capacity + 1;
+
+    if (first < overwritten)
+    {
+        const int numLost = (int) jmin((int64) copy.size(), overwritten - first);
+
+        copy.removeRange(0, numLost);
+    }
+
+    if (copy.size() == 0) return;
+
+    const BKBlackBoxEvent& overrun = copy.getReference(copy.size() - 1);
+    float deadlineMs = 0.0f;
+
+    for (int i = copy.size(); --i >= 0;)
+    {
+        if (copy.getReference(i).type == BlackBoxBlock) { deadlineMs = copy.getReference(i).value; break; }
+    }
+
+    String text;
+
+    text << "bitKlavier overrun, " << Time::getCurrentTime().toString(true, true, true, true) << newLine;
+    text << "block " << (int) overrun.block << " took " << String(overrun.value, 3) << " ms for " << overrun.a
+         << " samples (deadline " << String(deadlineMs, 3) << " ms)" << newLine;
+    text << copy.size() << " events leading up to it, ms before the end of the block:" << newLine << newLine;
+
+    for (auto& event : copy)
+    {
+        text << String(ticksToMs(event.ticks - overrun.ticks), 3).paddedLeft(' ', 12) << "  "
+             << String((int) event.block).paddedLeft(' ', 8) << "  " << describe(event) << newLine;
+    }
+
+    if (!folder.createDirectory())
+    {
+        DBG("black box: couldn't create " + folder.getFullPathName());
+        return;
+    }
+
+    File file = folder.getChildFile("overrun " + Time::getCurrentTime().formatted("%Y-%m-%d %H-%M-%S") + ".txt")
+                      .getNonexistentSibling();
+
+    if (file.replaceWithText(text))     DBG("black box: overrun written to " + file.getFullPathName());
+    else                                DBG("black box: couldn't write " + file.getFullPathName());
+}
+
+String BKBlackBox::describe(const BKBlackBoxEvent& event)
+{
+    switch (event.type)
+    {
+        case BlackBoxNoteOn:            return "note on " + String(event.a) + " (" + String(event.value, 2) + ")";
+        case BlackBoxNoteOff:           return "note off " + String(event.a);
+        case BlackBoxPulse:             return "synchronic " + String(event.a) + " beat " + String(event.b);
+        case BlackBoxModification:      return (event.b ? "resets on " : "modifications on ") + String(event.a);
+        case BlackBoxPianoSwitch:       return "piano " + String(event.a);
+        case BlackBoxSetlistAdvance:    return "setlist to piano " + String(event.a);
+        case BlackBoxSustain:           return event.a ? "sustain pressed" : "sustain released";
+        case BlackBoxOverrun:           return "OVERRUN " + String(event.value, 3) + " ms";
+        case BlackBoxBlock:
+        {
+            String text;
+
+            text << "block " << event.a << " samples, " << event.b << " voices:";
+
+            for (int i = 0; i < BlackBoxStageNil; i++) text << " " << stageNames[i] << " " << String(event.stages[i], 3);
+
+            return text;
+        }
+        default:                        return "?";
+    }
+}
@@ -0,0 +1,114 @@
+/*
+  ==============================================================================
+
+    BKBlackBox.h
+    Created: 19 Oct 2026 11:02:18am
+    Author:
+
+    A flight recorder for the audio thread. processBlock records what the
+    engine does (notes, synchronic pulses, modifications, piano switches,
+    setlist steps, the pedal) into a fixed ring, and closes every block
+    with how long each of its stages took and how many voices were busy.
+
+    The watchdog part compares each block against its deadline (its length
+    in samples at the current sample rate). When a block runs over, the
+    events that led up to it are written to a text file in the overruns
+    folder by the recorder's own thread. The audio thread only ever writes
+    into the ring and sets a couple of atomics, so nothing is logged and
+    nothing waits while blocks are on time.
+
+    Only the audio thread records. The dump copies the ring while it keeps
+    being written and throws away whatever may have been overwritten under
+    it, so a dump never holds a half-written event.
+
+  ==============================================================================
+*/
+
+#ifndef BKBLACKBOX_H_INCLUDED
+#define BKBLACKBOX_H_INCLUDED
+
+#include "BKUtilities.h"
+
+typedef enum BKBlackBoxEventType
+{
+    BlackBoxNoteOn = 0,         // a: note, b: channel, value: velocity
+    BlackBoxNoteOff,            // a: note, b: channel, value: velocity
+    BlackBoxPulse,              // a: synchronic Id, b: beat
+    BlackBoxModification,       // a: note, b: 1 for resets, value: how many
+    BlackBoxPianoSwitch,        // a: piano Id
+    BlackBoxSetlistAdvance,     // a: piano Id
+    BlackBoxSustain,            // a: 1 pressed, 0 released
+    BlackBoxBlock,              // a: samples, b: busy voices, value: deadline ms, stages: ms
+    BlackBoxOverrun,            // a: samples, value: ms taken
+    BlackBoxEventNil
+} BKBlackBoxEventType;
+
+typedef enum BKBlackBoxStage
+{
+    BlackBoxStagePreparations = 0,  // prep maps' processBlock
+    BlackBoxStageMidi,              // notes, pedals, modifications
+    BlackBoxStageSynth,             // rendering voices
+    BlackBoxStageOutput,            // gain and metering
+    BlackBoxStageNil
+} BKBlackBoxStage;
+
+struct BKBlackBoxEvent
+{
+    BKBlackBoxEventType type;
+    uint32 block;
+    int64 ticks;                        // Time::getHighResolutionTicks()
+    int a, b;
+    float value;
+    float stages[BlackBoxStageNil];     // block events only
+};
+
+class BKBlackBox : public Thread
+{
+public:
+    BKBlackBox(void);
+    ~BKBlackBox(void);
+
+    // Where overrun dumps are written. Set before starting the thread.
+    inline void setFolder(const File& f) { folder = f; }
+
+    // Audio thread. Never waits or allocates.
+    void record(BKBlackBoxEventType type, int a = 0, int b = 0, float value = 0.0f);
+
+    // Audio thread, around and within processBlock.
+    void blockStarted(double sampleRate, int numSamples);
+    void stageFinished(BKBlackBoxStage stage);
+    void blockFinished(int busyVoices);
+
+    inline int getNumOverruns(void) const noexcept { return numOverruns.get(); }
+
+    enum
+    {
+        capacity = 1024,
+        maxDumps = 32       // per session, so a machine that can't keep up doesn't fill the disk
+    };
+
+private:
+    File folder;
+
+    HeapBlock<BKBlackBoxEvent> events;
+    Atomic<int64> written;      // events ever recorded; the next goes in written % capacity
+    Atomic<int64> dumpAt;       // the overrun's end in the ring, -1 when no dump is waiting
+    Atomic<int> numOverruns;
+    int numDumps;
+
+    // Audio thread only
+    uint32 blockNumber;
+    int blockSamples;
+    int64 blockStart, stageStart, deadline;
+    float stageMs[BlackBoxStageNil];
+
+    void run(void) override;
+    void dump(int64 end);
+
+    static String describe(const BKBlackBoxEvent& event);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BKBlackBox)
+};
+
+
+#endif  // BKBLACKBOX_H_INCLUDED
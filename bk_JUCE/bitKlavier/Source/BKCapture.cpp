@@ -0,0 +1,390 @@
+/*
+  ==============================================================================
+
+    BKCapture.cpp
+    Created: 19 Oct 2026 1:47:05pm
+    Author:
+
+  ==============================================================================
+*/
+
+#include "BKCapture.h"
+
+#include "PluginProcessor.h"
+
+BKCapture::BKCapture(BKAudioProcessor& p):
+processor(p),
+fifo(fifoSize),
+pending(fifoSize),
+capturing(0),
+numDropped(0),
+position(0)
+{
+
+}
+
+BKCapture::~BKCapture(void)
+{
+    stopTimer();
+}
+
+void BKCapture::start(void)
+{
+    if (isCapturing()) return;
+
+    // Only the message thread edits the gallery, so it can be saved without holding up the audio thread
+    snapshot = new XmlElement("capture");
+    snapshot->addChildElement(processor.gallery->getState().createXml());
+
+    XmlElement* adaptive = snapshot->createNewChildElement("adaptive");
+
+    const ScopedLock sl (processor.configurationLock);
+
+    snapshot->setAttribute("sampleRate", processor.getSampleRate());
+    snapshot->setAttribute("blockSize", processor.getBlockSize());
+    snapshot->setAttribute("sampleType", (int) processor.currentSampleType);
+    snapshot->setAttribute("piano", processor.currentPiano->getId());
+    snapshot->setAttribute("invertSustain", (int) processor.getSustainInversion());
+    snapshot->setAttribute("sustainPressed", (int) (processor.getSustainIsDown() != processor.getSustainInversion()));
+    snapshot->setAttribute("voicePoolSize", processor.getVoicePoolSize());
+
+    for (auto tuning : processor.currentPiano->getTuningProcessors())
+    {
+        XmlElement* t = adaptive->createNewChildElement("tuning");
+
+        t->setAttribute("Id", tuning->getId());
+        t->setAttribute("fundamentalNote", tuning->getAdaptiveFundamentalNote());
+        t->setAttribute("fundamentalFreq", tuning->getAdaptiveFundamentalFreq());
+        t->setAttribute("historyCounter", tuning->getAdaptiveHistoryCounter());
+    }
+
+    for (auto tempo : processor.currentPiano->getTempoProcessors())
+    {
+        XmlElement* t = adaptive->createNewChildElement("tempo");
+
+        t->setAttribute("Id", tempo->getId());
+        t->setAttribute("timer", String((int64) tempo->getAtTimer()));
+        t->setAttribute("lastTime", String((int64) tempo->getAtLastTime()));
+        t->setAttribute("periodMultiplier", tempo->getAdaptiveTempoPeriodMultiplier());
+
+        String history;
+        for (auto delta : tempo->getAtDeltaHistory()) history << delta << " ";
+
+        t->setAttribute("deltaHistory", history.trim());
+    }
+
+    messages.clearQuick();
+    fifo.reset();
+    numDropped.set(0);
+    position = 0;
+
+    capturing.set(1);
+
+    startTimer(50);
+}
+
+File BKCapture::stop(void)
+{
+    if (!isCapturing()) return File();
+
+    int64 length;
+
+    {
+        const ScopedLock sl (processor.configurationLock);
+
+        capturing.set(0);
+        length = position;
+    }
+
+    stopTimer();
+    drain();
+
+    snapshot->setAttribute("length", String(length));
+    snapshot->setAttribute("peakVoices", processor.getPeakVoiceUsage());
+    snapshot->setAttribute("dropped", numDropped.get());
+
+    XmlElement* midi = snapshot->createNewChildElement("midi");
+
+    for (auto& message : messages)
+    {
+        XmlElement* e = midi->createNewChildElement("e");
+
+        e->setAttribute("t", String(message.time));
+        e->setAttribute("m", String::toHexString(message.data, message.size));
+    }
+
+    DBG("capture: " + String(messages.size()) + " messages over " + String(length) + " samples, "
+        + String(numDropped.get()) + " dropped");
+
+    File folder = File::getSpecialLocation(File::userDocumentsDirectory).getChildFile("bitKlavier resources").getChildFile("captures");
+
+    File file = folder.getChildFile("capture " + Time::getCurrentTime().formatted("%Y-%m-%d %H-%M-%S") + ".bkcapture")
+                      .getNonexistentSibling();
+
+    const bool written = folder.createDirectory() && snapshot->writeToFile(file, String());
+
+    snapshot = nullptr;
+    messages.clear();
+
+    if (!written)
+    {
+        DBG("capture: couldn't write " + file.getFullPathName());
+        return File();
+    }
+
+    return file;
+}
+
+void BKCapture::addMessage(const MidiMessage& m, int sampleInBlock)
+{
+    if (capturing.get() == 0) return;
+
+    const int size = m.getRawDataSize();
+
+    if (size > 3) return;
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    if (size1 == 0)
+    {
+        numDropped.set(numDropped.get() + 1);
+        return;
+    }
+
+    BKCapturedMessage& message = pending[start1];
+    message.time = position + sampleInBlock;
+    message.size = (uint8) size;
+    memcpy(message.data, m.getRawData(), (size_t) size);
+
+    fifo.finishedWrite(1);
+}
+
+void BKCapture::blockDone(int numSamples)
+{
+    if (capturing.get() != 0) position += numSamples;
+}
+
+void BKCapture::timerCallback(void)
+{
+    drain();
+}
+
+void BKCapture::drain(void)
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(fifo.getNumReady(), start1, size1, start2, size2);
+
+    for (int i = 0; i < size1; i++) messages.add(pending[start1 + i]);
+    for (int i = 0; i < size2; i++) messages.add(pending[start2 + i]);
+
+    fifo.finishedRead(size1 + size2);
+}
+
+//==============================================================================
+BKReplay::BKReplay(const File& c, int bs, const File& r):
+BKHeadlessRun("replay", bs, r),
+captureFile(c),
+length(0),
+numBlocks(0),
+totalMs(0.0),
+maxMs(0.0),
+checksum(14695981039346656037ULL)
+{
+
+}
+
+BKReplay::~BKReplay(void)
+{
+    stopRun();
+}
+
+BKReplay* BKReplay::fromCommandLine(const StringArray& args)
+{
+    String capturePath, reportPath;
+    int blockSize = 0;
+
+    for (auto arg : args)
+    {
+        const String value = arg.fromFirstOccurrenceOf("=", false, false).unquoted();
+
+        if      (arg.startsWith("--replay-report="))    reportPath = value;
+        else if (arg.startsWith("--replay="))           capturePath = value;
+        else if (arg.startsWith("--block-size="))       blockSize = value.getIntValue();
+    }
+
+    if (capturePath.isEmpty()) return nullptr;
+
+    return new BKReplay(getArgumentFile(capturePath), blockSize, getArgumentFile(reportPath));
+}
+
+bool BKReplay::prepare(void)
+{
+    capture = XmlDocument::parse(captureFile);
+
+    if (capture == nullptr || !capture->hasTagName("capture"))
+    {
+        error = "couldn't read " + captureFile.getFullPathName();
+        return false;
+    }
+
+    XmlElement* gallery = capture->getChildByName(vtagGallery);
+
+    if (gallery == nullptr)
+    {
+        error = captureFile.getFullPathName() + " has no gallery";
+        return false;
+    }
+
+    sampleRate = capture->getDoubleAttribute("sampleRate", 44100.0);
+    if (sampleRate <= 0.0) sampleRate = 44100.0;
+
+    // Any block size replays; the one it was captured at unless asked otherwise
+    if (blockSize <= 0) blockSize = capture->getIntAttribute("blockSize", 512);
+    if (blockSize <= 0) blockSize = 512;
+
+    length = capture->getStringAttribute("length").getLargeIntValue();
+
+    // A pedal held down when the capture started is pressed again before anything else
+    if (capture->getIntAttribute("sustainPressed") != 0)
+    {
+        BKCapturedMessage pedal = { 0, { 0xb0, 64, 127 }, 3 };
+        messages.add(pedal);
+    }
+
+    if (XmlElement* midi = capture->getChildByName("midi"))
+    {
+        forEachXmlChildElementWithTagName (*midi, e, "e")
+        {
+            StringArray bytes;
+            bytes.addTokens(e->getStringAttribute("m"), " ", "");
+
+            if (bytes.size() == 0 || bytes.size() > 3) continue;
+
+            BKCapturedMessage message;
+            message.time = e->getStringAttribute("t").getLargeIntValue();
+            message.size = (uint8) bytes.size();
+
+            for (int i = 0; i < bytes.size(); i++) message.data[i] = (uint8) bytes[i].getHexValue32();
+
+            messages.add(message);
+        }
+    }
+
+    return true;
+}
+
+void BKReplay::setUp(void)
+{
+    processor->loadGalleryFromXml(new XmlElement(*capture->getChildByName(vtagGallery)));
+
+    processor->loadPianoSamples((BKSampleLoadType) capture->getIntAttribute("sampleType", BKLoadHeavy));
+
+    const int piano = capture->getIntAttribute("piano");
+    if (processor->gallery->getPiano(piano) != nullptr) processor->setCurrentPiano(piano);
+
+    processor->setSustainInversion(capture->getIntAttribute("invertSustain") != 0);
+
+    // A pool that grows while we time it doesn't replay the same way twice, so it starts as big as it got
+    int voices = capture->getIntAttribute("voicePoolSize");
+    if (voices == 0) voices = capture->getIntAttribute("peakVoices");
+    processor->setVoicePoolSize(voices);
+
+    if (XmlElement* adaptive = capture->getChildByName("adaptive"))
+    {
+        forEachXmlChildElementWithTagName (*adaptive, t, "tuning")
+        {
+            for (auto tuning : processor->currentPiano->getTuningProcessors())
+            {
+                if (tuning->getId() != t->getIntAttribute("Id")) continue;
+
+                tuning->setAdaptiveFundamentalNote(t->getIntAttribute("fundamentalNote"));
+                tuning->setAdaptiveFundamentalFreq((float) t->getDoubleAttribute("fundamentalFreq"));
+                tuning->setAdaptiveHistoryCounter(t->getIntAttribute("historyCounter"));
+            }
+        }
+
+        forEachXmlChildElementWithTagName (*adaptive, t, "tempo")
+        {
+            for (auto tempo : processor->currentPiano->getTempoProcessors())
+            {
+                if (tempo->getId() != t->getIntAttribute("Id")) continue;
+
+                Array<int> history;
+                for (auto delta : StringArray::fromTokens(t->getStringAttribute("deltaHistory"), " ", "")) history.add(delta.getIntValue());
+
+                tempo->setAtTimer((uint64) t->getStringAttribute("timer").getLargeIntValue());
+                tempo->setAtLastTime((uint64) t->getStringAttribute("lastTime").getLargeIntValue());
+                tempo->setAtDeltaHistory(history);
+                tempo->setAdaptiveTempoPeriodMultiplier((float) t->getDoubleAttribute("periodMultiplier", 1.0));
+            }
+        }
+    }
+
+    DBG("replay: " + String(messages.size()) + " messages over " + String(length) + " samples in blocks of " + String(blockSize));
+}
+
+void BKReplay::runRenders(void)
+{
+    AudioSampleBuffer buffer(2, blockSize);
+    MidiBuffer midi;
+
+    int next = 0;
+
+    for (int64 position = 0; position < length && !threadShouldExit(); position += blockSize)
+    {
+        midi.clear();
+
+        while (next < messages.size() && messages.getReference(next).time < position + blockSize)
+        {
+            const BKCapturedMessage& message = messages.getReference(next++);
+
+            midi.addEvent(message.data, message.size, (int) jmax((int64) 0, message.time - position));
+        }
+
+        const int64 start = Time::getHighResolutionTicks();
+
+        processor->processBlock(buffer, midi);
+
+        const double ms = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start) * 1000.0;
+
+        totalMs += ms;
+        maxMs = jmax(maxMs, ms);
+        ++numBlocks;
+
+        // FNV-1a over the output, so a replay can be checked against another
+        for (int c = 0; c < buffer.getNumChannels(); c++)
+        {
+            const uint8* bytes = (const uint8*) buffer.getReadPointer(c);
+            const size_t numBytes = (size_t) buffer.getNumSamples() * sizeof(float);
+
+            for (size_t i = 0; i < numBytes; i++) checksum = (checksum ^ bytes[i]) * 1099511628211ULL;
+        }
+    }
+}
+
+bool BKReplay::report(String& text, DynamicObject& json)
+{
+    if (error.isNotEmpty())
+    {
+        text = "replay: " + error;
+        return false;
+    }
+
+    const double audioMs = length / sampleRate * 1000.0;
+
+    text << "replay: " << captureFile.getFileName() << ", " << numBlocks << " blocks of " << blockSize
+         << ", mean " << String(totalMs / jmax(1, numBlocks), 4) << " ms, max " << String(maxMs, 4)
+         << " ms, " << String(audioMs / jmax(totalMs, 0.001), 1) << "x realtime, checksum "
+         << String::toHexString((int64) checksum);
+
+    json.setProperty("capture", captureFile.getFullPathName());
+    json.setProperty("blockSize", blockSize);
+    json.setProperty("blocks", numBlocks);
+    json.setProperty("meanMs", totalMs / jmax(1, numBlocks));
+    json.setProperty("maxMs", maxMs);
+    json.setProperty("realtime", audioMs / jmax(totalMs, 0.001));
+    json.setProperty("checksum", String::toHexString((int64) checksum));
+
+    return true;
+}
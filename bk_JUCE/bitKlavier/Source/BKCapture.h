@@ -0,0 +1,124 @@
+/*
+  ==============================================================================
+
+    BKCapture.h
+    Created: 19 Oct 2026 1:47:05pm
+    Author:
+
+    Turns "it glitches here" into something we can run again.
+
+    BKCapture records what reaches processBlock (MIDI from the host or the
+    device, and notes from the on-screen keyboard) with the sample it
+    arrived at, counted from the start of the capture. Starting a capture
+    also snapshots the whole gallery, the current piano, the processor
+    settings and the adaptive tuning and tempo state, so the capture file
+    holds everything the engine's output depends on.
+
+    BKReplay loads a capture into a processor of its own, off the audio
+    device, and feeds the messages back through processBlock in blocks of
+    whatever size it's asked for, timing every block. Two replays of the
+    same capture at the same block size render the same samples (the
+    output checksum says so), so it can be run under a profiler or before
+    and after a change and compared.
+
+    The standalone app replays from the command line:
+
+        bitKlavier --replay=<capture> [--block-size=<n>] [--replay-report=<file>]
+
+    and quits when it's done.
+
+  ==============================================================================
+*/
+
+#ifndef BKCAPTURE_H_INCLUDED
+#define BKCAPTURE_H_INCLUDED
+
+#include "BKUtilities.h"
+
+#include "BKHeadlessRun.h"
+
+class BKAudioProcessor;
+
+struct BKCapturedMessage
+{
+    int64 time;         // samples since the capture started
+    uint8 data[3];
+    uint8 size;
+};
+
+class BKCapture : private Timer
+{
+public:
+    BKCapture(BKAudioProcessor& p);
+    ~BKCapture(void);
+
+    // Message thread. start() takes the processor's configuration lock while it snapshots,
+    // so the capture begins at a block boundary with the state the snapshot describes.
+    void start(void);
+
+    // Writes the capture to the captures folder and returns the file (File() if it couldn't).
+    File stop(void);
+
+    inline bool isCapturing(void) const noexcept { return capturing.get() != 0; }
+
+    // Audio thread. Messages longer than three bytes (sysex) aren't kept.
+    void addMessage(const MidiMessage& m, int sampleInBlock);
+    void blockDone(int numSamples);
+
+    enum
+    {
+        fifoSize = 4096     // about a second of a very busy controller between timer callbacks
+    };
+
+private:
+    BKAudioProcessor& processor;
+
+    ScopedPointer<XmlElement> snapshot;
+    Array<BKCapturedMessage> messages;
+
+    AbstractFifo fifo;
+    HeapBlock<BKCapturedMessage> pending;
+
+    Atomic<int> capturing;
+    Atomic<int> numDropped;
+    int64 position;         // audio thread, and start()/stop() under the configuration lock
+
+    void timerCallback(void) override;
+    void drain(void);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BKCapture)
+};
+
+class BKReplay : public BKHeadlessRun
+{
+public:
+    BKReplay(const File& capture, int blockSize, const File& report);
+    ~BKReplay(void);
+
+    // Looks for --replay on the command line and, if it's there, starts one. Standalone app only.
+    static BKReplay* fromCommandLine(const StringArray& args);
+
+private:
+    File captureFile;
+
+    ScopedPointer<XmlElement> capture;
+
+    Array<BKCapturedMessage> messages;
+    int64 length;
+
+    // Results, written by run() and read once it's done
+    int numBlocks;
+    double totalMs, maxMs;
+    uint64 checksum;
+    String error;
+
+    bool prepare(void) override;            // reads the capture
+    void setUp(void) override;              // puts the processor in the captured state
+    void runRenders(void) override;
+    bool report(String& text, DynamicObject& json) override;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BKReplay)
+};
+
+
+#endif  // BKCAPTURE_H_INCLUDED
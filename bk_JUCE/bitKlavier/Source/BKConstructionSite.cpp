@@ -57,9 +57,14 @@ void BKConstructionSite::paint(Graphics& g)
         
     }
     
+    g.setColour(Colours::goldenrod);
+    
+    // Drags only repaint around what moved, so most lines are outside the clip
+    const Rectangle<int> clip = g.getClipBounds();
+    
     for (auto line : graph->getLines())
     {
-        g.setColour(Colours::goldenrod);
+        if (!clip.intersects(Rectangle<int>(line.getStart(), line.getEnd()).expanded(2))) continue;
 
         g.drawLine(line.getStartX(), line.getStartY(), line.getEndX(), line.getEndY(), (processor.platform == BKIOS) ? 1 : 2);
     }
@@ -72,15 +77,9 @@ void BKConstructionSite::paint(Graphics& g)
 
 bool BKConstructionSite::itemOutsideBounds(Rectangle<int> bounds)
 {
-    for (auto item : graph->getItems())
-    {
-        juce::Point<int> xy = item->getPosition();
-        DBG("XY TEST: " + String(xy.x) + " " + String(xy.y));
-        
-        DBG("bounds: " + String(bounds.getX()) + " " + String(bounds.getHeight()));
-        if ((xy.x > bounds.getWidth()) || (xy.y > bounds.getHeight())) return true;
-    }
-    return false;
+    juce::Point<int> xy = graph->getMaxItemPosition();
+    
+    return (xy.x > bounds.getWidth()) || (xy.y > bounds.getHeight());
 }
 
 void BKConstructionSite::redraw(void)
@@ -109,10 +108,14 @@ void BKConstructionSite::move(int which, bool fine)
     else if (which == 3) // Left
         changeX = fine ? -2 : -10;
     
-    for (auto item : graph->getSelectedItems())
+    BKItem::PtrArr selectedItems = graph->getSelectedItems();
+    
+    Rectangle<int> dirty = graph->getAreaAround(selectedItems);
+    
+    for (auto item : selectedItems)
         item->setTopLeftPosition(item->getX() + changeX, item->getY() + changeY);
     
-    repaint();
+    repaint(dirty.getUnion(graph->getAreaAround(selectedItems)).expanded(4));
 }
 
 void BKConstructionSite::selectAll(void)
@@ -178,12 +181,19 @@ void BKConstructionSite::align(int which)
 
 void BKConstructionSite::itemIsBeingDragged(BKItem* thisItem, const MouseEvent& e)
 {
-    repaint();
+    BKItem::PtrArr draggedItems;
+    draggedItems.add(thisItem);
+    
+    repaint(graph->getAreaAround(draggedItems).expanded(4));
 }
 
 void BKConstructionSite::pianoMapDidChange(BKItem* thisItem)
 {
-    processor.currentPiano->configure();
+    processor.currentPiano->configurePianoMaps();
+    
+#if TRY_UNDO
+    processor.updateHistory();
+#endif
 }
 
 void BKConstructionSite::draw(void)
@@ -349,6 +359,9 @@ BKItem::PtrArr BKConstructionSite::duplicate(BKItem::PtrArr these)
     
     BKItem::PtrArr clipboard;
     
+    // The copies by type and Id, so connections can be found without searching the clipboard
+    HashMap<int64, BKItem*> clipboardItems;
+    
     for (auto item : these)
     {
         BKItem* newItem = new BKItem(item->getType(), item->getId(), processor);
@@ -368,6 +381,7 @@ BKItem::PtrArr BKConstructionSite::duplicate(BKItem::PtrArr these)
         }
         
         clipboard.add(newItem);
+        clipboardItems.set(newItem->getKey(), newItem);
     }
     
     for (int i = 0; i < these.size(); i++)
@@ -377,15 +391,7 @@ BKItem::PtrArr BKConstructionSite::duplicate(BKItem::PtrArr these)
         
         for (auto connection : thisItem->getConnections())
         {
-            BKPreparationType connectionType = connection->getType();
-            int connectionId = connection->getId();
-            
-            BKItem* connectionItem = nullptr;
-            
-            for (auto item : clipboard)
-            {
-                if (item->getType() == connectionType && item->getId() == connectionId) connectionItem = item;
-            }
+            BKItem* connectionItem = clipboardItems[connection->getKey()];
             
             if (connectionItem != nullptr)
             {
@@ -438,12 +444,8 @@ void BKConstructionSite::paste(void)
         item->setTopLeftPosition((item->getX()-offsetX) + lastEX, (item->getY()-offsetY) + lastEY);
         
         processor.currentPiano->add(item);
-        
-        newItems.add(item);
     }
     
-    processor.currentPiano->configure();
-    
     redraw();
     
     getParentComponent()->grabKeyboardFocus();
@@ -489,24 +491,8 @@ void BKConstructionSite::editMenuCallback(int result, BKConstructionSite* vc)
     BKAudioProcessor& processor = vc->processor;
     
 #if TRY_UNDO
-    if (result == CUT_ID ||
-        result == PASTE_ID ||
-        result == ALIGN_VERTICAL ||
-        result == ALIGN_HORIZONTAL ||
-        result == DELETE_ID ||
-        result == KEYMAP_ID ||
-        result == DIRECT_ID ||
-        result == NOSTALGIC_ID ||
-        result == SYNCHRONIC_ID ||
-        result == TEMPO_ID ||
-        result == TUNING_ID||
-        result == MODIFICATION_ID||
-        result == PIANOMAP_ID||
-        result == RESET_ID)
-    {
-        processor.updateHistory();
-    }
-    
+    // Anything done before the menu opened is its own step
+    processor.updateHistory();
 #endif
     
     
@@ -644,6 +630,10 @@ void BKConstructionSite::editMenuCallback(int result, BKConstructionSite* vc)
     {
         processor.updateState->setCurrentDisplay(PreparationTypeTempoMod);
     }
+    
+#if TRY_UNDO
+    processor.updateHistory();
+#endif
 }
 
 void BKConstructionSite::mouseDoubleClick(const MouseEvent& eo)
@@ -710,6 +700,10 @@ void BKConstructionSite::mouseDown (const MouseEvent& eo)
     
     MouseEvent e = eo.getEventRelativeTo(this);
     
+#if TRY_UNDO
+    processor.updateHistory();
+#endif
+    
 #if JUCE_IOS
     TouchEvent* t = getTouchEvent(e.source);
     
@@ -870,6 +864,11 @@ void BKConstructionSite::mouseUp (const MouseEvent& eo)
     
     repaint();
     
+#if TRY_UNDO
+    // Drags and connections finish here
+    processor.updateHistory();
+#endif
+    
     getParentComponent()->grabKeyboardFocus();
     
 }
@@ -899,18 +898,31 @@ void BKConstructionSite::mouseDrag (const MouseEvent& e)
     
     if (itemToSelect == nullptr) lasso->dragLasso(e);
     
+    // Only what moves is repainted: the dragged items with their lines, or the line being connected
+    Rectangle<int> dirty;
+    
+    if (connect) dirty = Rectangle<int>(juce::Point<int>(lineOX, lineOY), juce::Point<int>(lineEX, lineEY));
+    
     if (!connect && !e.mods.isShiftDown())
     {
-        for (auto item : graph->getSelectedItems())
+        BKItem::PtrArr selectedItems = graph->getSelectedItems();
+        
+        dirty = dirty.getUnion(graph->getAreaAround(selectedItems));
+        
+        for (auto item : selectedItems)
         {
             item->performDrag(e);
         }
+        
+        dirty = dirty.getUnion(graph->getAreaAround(selectedItems));
     }
     
     lineEX = e.getEventRelativeTo(this).x;
     lineEY = e.getEventRelativeTo(this).y;
     
-    repaint();
+    if (connect) dirty = dirty.getUnion(Rectangle<int>(juce::Point<int>(lineOX, lineOY), juce::Point<int>(lineEX, lineEY)));
+    
+    if (!dirty.isEmpty()) repaint(dirty.expanded(4));
 
 }
 
@@ -936,53 +948,29 @@ void BKConstructionSite::idDidChange(void)
     else if (type == PreparationTypeTuningMod)      newId = processor.updateState->currentModTuningId;
     else if (type == PreparationTypeTempoMod)       newId = processor.updateState->currentModTempoId;
     
+    processor.currentPiano->deconfigureItem(currentItem);
+    
     currentItem->setId(newId);
 
-    processor.currentPiano->configure();
+    processor.currentPiano->configureItem(currentItem);
+    
+#if TRY_UNDO
+    processor.updateHistory();
+#endif
 }
 
 BKItem* BKConstructionSite::getItemAtPoint(const int X, const int Y)
 {
-    BKItem* theItem = nullptr;
-    
-    if (itemSource != nullptr)
-    {
-        int which = 0;
-        
-        for (auto item : graph->getItems())
-        {
-            int left = item->getX(); int right = left + item->getWidth();
-            int top = item->getY(); int bottom = top + item->getHeight();
-            
-            if (X >= left && X <= right && Y >= top && Y <= bottom) // is in item
-            {
-                theItem = dynamic_cast<BKItem*> (item);
-                break;
-            }
-            
-            which++;
-        }
-    }
+    if (itemSource == nullptr) return nullptr;
     
-    return theItem;
+    return graph->getItemAt(juce::Point<int>(X, Y));
 }
 
 void BKConstructionSite::findLassoItemsInArea (Array <BKItem*>& itemsFound,
                                   const Rectangle<int>& area)
 {
-    int areaX = area.getX(); int areaY = area.getY(); int areaWidth = area.getWidth(); int areaHeight = area.getHeight();
-    
     // psuedocode determine if collide: if (x1 + w1) - x2 >= 0 and (x2 + w2) - x1 >= 0
-    
-    for (auto item : graph->getItems())
-    {
-        int itemX = item->getX(); int itemWidth = item->getWidth();
-        int itemY = item->getY(); int itemHeight = item->getHeight();
-        
-        if (((itemX + itemWidth - areaX) >= 0) && ((areaX + areaWidth - itemX) >= 0) &&
-            ((itemY + itemHeight - areaY) >= 0) && ((areaY + areaHeight - itemY) >= 0))
-            itemsFound.add(item);
-    }
+    graph->getItemsInArea(area, itemsFound);
     
     /*
     for (int x = area.getX(); x < area.getRight(); x++)
@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+    BKEditorEvents.cpp
+    Created: 19 Oct 2026 8:35:12am
+    Author:
+
+  ==============================================================================
+*/
+
+#include "BKEditorEvents.h"
+
+BKEditorEventQueue::BKEditorEventQueue(void):
+fifo(capacity),
+events(capacity)
+{
+
+}
+
+BKEditorEventQueue::~BKEditorEventQueue(void)
+{
+
+}
+
+void BKEditorEventQueue::push(BKEditorEventType type, BKPreparationType preparation, int value)
+{
+    // The fifo takes one writer; a second one drops its event rather than wait
+    if (!writeLock.tryEnter())
+    {
+        dropped.set(1);
+        return;
+    }
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    if (size1 > 0)
+    {
+        BKEditorEvent& event = events[start1];
+        event.type = type;
+        event.preparation = preparation;
+        event.value = value;
+
+        fifo.finishedWrite(1);
+    }
+    else
+    {
+        dropped.set(1);
+    }
+
+    writeLock.exit();
+}
+
+bool BKEditorEventQueue::pop(BKEditorEvent& event)
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(1, start1, size1, start2, size2);
+
+    if (size1 == 0) return false;
+
+    event = events[start1];
+
+    fifo.finishedRead(1);
+
+    return true;
+}
+
+bool BKEditorEventQueue::didDropEvents(void)
+{
+    return dropped.exchange(0) != 0;
+}
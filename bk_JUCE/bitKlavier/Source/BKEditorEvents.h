@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    BKEditorEvents.h
+    Created: 19 Oct 2026 8:35:12am
+    Author:
+
+    Changes made on the audio thread that the editors show (notes going on
+    and off, synchronic counters stepping, a tempo or tuning adapting,
+    nostalgic notes starting to play), queued for the message thread.
+    Writing an event never blocks or allocates: it goes into a fixed ring,
+    and if the ring is full (or another thread is writing) it is dropped
+    and the reader is told to refresh everything instead.
+
+    MainViewController drains the queue and passes each event on to the
+    one editor or key it concerns, so nothing polls the processors.
+
+  ==============================================================================
+*/
+
+#ifndef BKEDITOREVENTS_H_INCLUDED
+#define BKEDITOREVENTS_H_INCLUDED
+
+#include "BKUtilities.h"
+
+typedef enum BKEditorEventType
+{
+    EditorEventNoteOn = 0,
+    EditorEventNoteOff,
+    EditorEventCountersMoved,       // a synchronic stepped its counters
+    EditorEventPreparationChanged,  // a tempo or tuning adapted, a nostalgic started playing
+    EditorEventNil
+} BKEditorEventType;
+
+struct BKEditorEvent
+{
+    BKEditorEventType type;
+    BKPreparationType preparation;  // BKPreparationTypeNil for notes
+    int value;                      // the note number, or the preparation's Id
+};
+
+class BKEditorEventQueue
+{
+public:
+    BKEditorEventQueue(void);
+    ~BKEditorEventQueue(void);
+
+    // Audio thread (any thread, really). Never waits.
+    void push(BKEditorEventType type, BKPreparationType preparation, int value);
+
+    inline void pushNote(bool on, int noteNumber)
+    {
+        push(on ? EditorEventNoteOn : EditorEventNoteOff, BKPreparationTypeNil, noteNumber);
+    }
+
+    // Message thread. False once there's nothing left.
+    bool pop(BKEditorEvent& event);
+
+    // Message thread. True, once, if events were dropped since the last time it was asked.
+    bool didDropEvents(void);
+
+    enum { capacity = 1024 };
+
+private:
+    AbstractFifo fifo;
+    HeapBlock<BKEditorEvent> events;
+
+    SpinLock writeLock;
+    Atomic<int> dropped;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BKEditorEventQueue)
+};
+
+
+#endif  // BKEDITOREVENTS_H_INCLUDED
@@ -0,0 +1,464 @@
+/*
+  ==============================================================================
+
+    BKGolden.cpp
+    Created: 19 Oct 2026 5:08:52pm
+    Author:
+
+  ==============================================================================
+*/
+
+#include "BKGolden.h"
+
+#include "PluginProcessor.h"
+
+// start, length, note, velocity
+
+// Direct 1 leaves C, D and E4 out of its keymap
+static const BKGoldenNote directChords[] =
+{
+    { 0.0f, 0.8f, 48, 90 }, { 0.0f, 0.8f, 52, 80 }, { 0.0f, 0.8f, 55, 80 },
+    { 1.0f, 0.8f, 53, 70 }, { 1.0f, 0.8f, 57, 70 }, { 1.0f, 0.8f, 72, 100 },
+    { 2.0f, 0.5f, 43, 110 }, { 2.0f, 0.5f, 59, 60 }, { 2.0f, 0.5f, 65, 60 }, { 2.0f, 0.5f, 71, 60 },
+    { 2.6f, 1.4f, 36, 120 }, { 2.6f, 1.4f, 48, 90 }, { 2.6f, 1.4f, 67, 90 }, { 2.6f, 1.4f, 76, 127 }
+};
+
+static const BKGoldenNote synchronicPattern[] =
+{
+    { 0.0f, 2.0f, 60, 90 },
+    { 2.5f, 1.0f, 67, 70 },
+    { 3.0f, 1.5f, 55, 110 }, { 3.0f, 1.5f, 64, 110 }
+};
+
+static const BKGoldenNote nostalgicReverses[] =
+{
+    { 0.0f, 0.6f, 60, 100 },
+    { 1.0f, 1.0f, 64, 80 },
+    { 2.5f, 0.4f, 67, 120 },
+    { 3.5f, 0.8f, 48, 90 }, { 3.5f, 0.8f, 55, 90 }, { 3.5f, 0.8f, 72, 90 }
+};
+
+static const BKGoldenNote adaptiveTuningRun[] =
+{
+    { 0.00f, 0.12f, 60, 90 }, { 0.15f, 0.12f, 62, 90 }, { 0.30f, 0.12f, 64, 90 }, { 0.45f, 0.12f, 65, 90 },
+    { 0.60f, 0.12f, 67, 90 }, { 0.75f, 0.12f, 69, 90 }, { 0.90f, 0.12f, 71, 90 }, { 1.05f, 0.60f, 72, 90 },
+    { 2.00f, 0.30f, 67, 80 }, { 2.05f, 0.30f, 63, 80 }, { 2.10f, 0.30f, 70, 80 }, { 2.40f, 1.00f, 58, 100 }
+};
+
+// Taps on C4 set the tempo; the rest is played to it
+static const BKGoldenNote adaptiveTempoTaps[] =
+{
+    { 0.0f, 0.1f, 60, 90 }, { 0.5f, 0.1f, 60, 90 }, { 1.0f, 0.1f, 60, 90 }, { 1.5f, 0.1f, 60, 90 },
+    { 1.8f, 1.5f, 64, 80 },
+    { 2.2f, 0.1f, 60, 90 }, { 2.6f, 0.1f, 60, 90 }, { 3.0f, 0.1f, 60, 90 },
+    { 3.1f, 1.5f, 67, 80 }
+};
+
+static const BKGoldenPerformance performances[] =
+{
+    { "direct chords",          "21. Direct 1",         directChords,       numElementsInArray(directChords),       6.0f  },
+    { "synchronic pattern",     "1. Synchronic 1",      synchronicPattern,  numElementsInArray(synchronicPattern),  8.0f  },
+    { "nostalgic reverses",     "10. Nostalgic 1",      nostalgicReverses,  numElementsInArray(nostalgicReverses),  8.0f  },
+    { "adaptive tuning run",    "17. Tuning 2",         adaptiveTuningRun,  numElementsInArray(adaptiveTuningRun),  6.0f  },
+    { "adaptive tempo taps",    "23. Adaptive Tempo 1", adaptiveTempoTaps,  numElementsInArray(adaptiveTempoTaps),  7.0f  }
+};
+
+BKGolden::BKGolden(const File& f, bool r, int bs, float toleranceDecibels, const File& report):
+BKHeadlessRun("golden", bs, report),
+folder(f),
+recording(r),
+tolerance(Decibels::decibelsToGain(toleranceDecibels))
+{
+
+}
+
+BKGolden::~BKGolden(void)
+{
+    stopRun();
+}
+
+BKGolden* BKGolden::fromCommandLine(const StringArray& args)
+{
+    bool shouldCheck = false, shouldRecord = false;
+    String folderPath, reportPath;
+    int blockSize = 512;
+    float toleranceDecibels = -80.0f;
+
+    for (auto arg : args)
+    {
+        const String value = arg.fromFirstOccurrenceOf("=", false, false).unquoted();
+
+        if      (arg == "--golden-record")                  shouldRecord = true;
+        else if (arg.startsWith("--golden-tolerance="))     toleranceDecibels = value.getFloatValue();
+        else if (arg.startsWith("--golden-report="))        reportPath = value;
+        else if (arg.startsWith("--block-size="))           blockSize = value.getIntValue();
+        else if (arg == "--golden" || arg.startsWith("--golden="))
+        {
+            shouldCheck = true;
+            folderPath = value;
+        }
+    }
+
+    if (!shouldCheck && !shouldRecord) return nullptr;
+
+    const File folder = folderPath.isNotEmpty() ? getArgumentFile(folderPath) : findGoldenFolder();
+
+    return new BKGolden(folder, shouldRecord, jmax(16, blockSize), toleranceDecibels, getArgumentFile(reportPath));
+}
+
+bool BKGolden::prepare(void)
+{
+    if (folder == File())
+    {
+        problem = "no golden folder in the source tree above here, give one with --golden=<folder>";
+        return false;
+    }
+
+    if (recording) return true;
+
+    const File manifestFile = folder.getChildFile("golden.json");
+
+    if (!manifestFile.existsAsFile())
+    {
+        problem = "no " + manifestFile.getFullPathName() + ", make the goldens with --golden-record";
+        return false;
+    }
+
+    manifest = JSON::parse(manifestFile);
+
+    // Renders of another sample set or sample rate can't match, however little the render path changed
+    const String sampleType = manifest["sampleType"].toString();
+
+    if (sampleType != String(cBKSampleLoadTypes[BKLoadTest]))
+    {
+        problem = "goldens were made with \"" + sampleType + "\", not \"" + String(cBKSampleLoadTypes[BKLoadTest]) + "\"; record them again";
+        return false;
+    }
+
+    if ((double) manifest.getProperty("sampleRate", 0.0) != sampleRate)
+    {
+        problem = "goldens were made at " + manifest["sampleRate"].toString() + " Hz, not " + String(sampleRate) + "; record them again";
+        return false;
+    }
+
+    // Goldens are checked at the block size they were made at
+    const int goldenBlockSize = manifest.getProperty("blockSize", 0);
+    if (goldenBlockSize > 0) blockSize = goldenBlockSize;
+
+    return true;
+}
+
+void BKGolden::setUp(void)
+{
+    // Samples that are the same everywhere and a fixed voice pool, so nothing but the render path changes the sound
+    processor->loadPianoSamples(BKLoadTest);
+    processor->setVoicePoolSize(64);
+}
+
+void BKGolden::runRenders(void)
+{
+    if (recording && !folder.createDirectory())
+    {
+        DBG("golden: couldn't create " + folder.getFullPathName());
+    }
+
+    var timings;
+
+    for (auto& performance : performances)
+    {
+        if (threadShouldExit()) break;
+
+        Result result;
+        result.name = performance.name;
+        result.passed = true;
+        result.maxDiff = result.rmsDiff = 0.0f;
+        result.meanMs = result.maxMs = result.realtime = result.goldenMeanMs = 0.0;
+
+        for (int i = 0; i < manifest["performances"].size(); i++)
+        {
+            const var& timing = manifest["performances"][i];
+            if (timing["name"].toString() == result.name) result.goldenMeanMs = timing["meanMs"];
+        }
+
+        AudioSampleBuffer output;
+
+        render(performance, output, result);
+
+        const File golden = folder.getChildFile(result.name + ".wav");
+
+        if (!result.passed)
+        {
+            // couldn't render it; render() says why
+        }
+        else if (recording)
+        {
+            WavAudioFormat wavFormat;
+
+            golden.deleteFile();
+
+            ScopedPointer<FileOutputStream> stream = golden.createOutputStream();
+            ScopedPointer<AudioFormatWriter> writer = (stream != nullptr) ? wavFormat.createWriterFor(stream, sampleRate, 2, 32, StringPairArray(), 0) : nullptr;
+
+            if (writer != nullptr)
+            {
+                stream.release();
+                writer->writeFromAudioSampleBuffer(output, 0, output.getNumSamples());
+                result.detail = "recorded";
+            }
+            else
+            {
+                result.passed = false;
+                result.detail = "couldn't write " + golden.getFullPathName();
+            }
+
+            DynamicObject::Ptr timing = new DynamicObject();
+            timing->setProperty("name", result.name);
+            timing->setProperty("meanMs", result.meanMs);
+            timings.append(var(timing.get()));
+        }
+        else
+        {
+            compare(output, golden, result);
+        }
+
+        results.add(result);
+    }
+
+    if (recording)
+    {
+        DynamicObject::Ptr obj = new DynamicObject();
+
+        obj->setProperty("blockSize", blockSize);
+        obj->setProperty("sampleRate", sampleRate);
+        obj->setProperty("sampleType", String(cBKSampleLoadTypes[BKLoadTest]));
+        obj->setProperty("recorded", Time::getCurrentTime().toISO8601(true));
+        obj->setProperty("performances", timings);
+
+        folder.getChildFile("golden.json").replaceWithText(JSON::toString(var(obj.get())));
+    }
+}
+
+void BKGolden::render(const BKGoldenPerformance& performance, AudioSampleBuffer& output, Result& result)
+{
+    const String xmlData = findGallery(performance.gallery);
+
+    if (xmlData.isEmpty())
+    {
+        result.passed = false;
+        result.detail = "no bundled gallery named " + String(performance.gallery);
+        return;
+    }
+
+    // Nothing else plays on this processor, so the gallery can be swapped in between blocks
+    processor->loadGalleryFromXml(XmlDocument::parse(xmlData));
+    processor->mainPianoSynth.allNotesOff(0, false);
+
+    const int numBlocks = (int) std::ceil(performance.seconds * sampleRate / blockSize);
+
+    output.setSize(2, numBlocks * blockSize);
+    output.clear();
+
+    AudioSampleBuffer block(2, blockSize);
+    MidiBuffer midi;
+
+    double totalMs = 0.0;
+
+    for (int b = 0; b < numBlocks && !threadShouldExit(); b++)
+    {
+        const int64 start = (int64) b * blockSize;
+        const int64 end = start + blockSize;
+
+        midi.clear();
+
+        for (int n = 0; n < performance.numNotes; n++)
+        {
+            const BKGoldenNote& note = performance.notes[n];
+
+            const int64 on = (int64) (note.start * sampleRate);
+            const int64 off = (int64) ((note.start + note.length) * sampleRate);
+
+            if (on >= start && on < end)    midi.addEvent(MidiMessage::noteOn(1, note.note, (uint8) note.velocity), (int) (on - start));
+            if (off >= start && off < end)  midi.addEvent(MidiMessage::noteOff(1, note.note), (int) (off - start));
+        }
+
+        const int64 ticks = Time::getHighResolutionTicks();
+
+        processor->processBlock(block, midi);
+
+        const double ms = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - ticks) * 1000.0;
+
+        totalMs += ms;
+        result.maxMs = jmax(result.maxMs, ms);
+
+        for (int c = 0; c < 2; c++) output.copyFrom(c, (int) start, block, c, 0, blockSize);
+    }
+
+    result.meanMs = totalMs / jmax(1, numBlocks);
+    result.realtime = (numBlocks * blockSize / sampleRate * 1000.0) / jmax(totalMs, 0.001);
+}
+
+void BKGolden::compare(const AudioSampleBuffer& output, const File& golden, Result& result)
+{
+    if (!golden.existsAsFile())
+    {
+        result.passed = false;
+        result.detail = "no golden render, make one with --golden-record";
+        return;
+    }
+
+    WavAudioFormat wavFormat;
+
+    ScopedPointer<AudioFormatReader> reader = wavFormat.createReaderFor(new FileInputStream(golden), true);
+
+    if (reader == nullptr)
+    {
+        result.passed = false;
+        result.detail = "couldn't read " + golden.getFullPathName();
+        return;
+    }
+
+    const int numSamples = output.getNumSamples();
+
+    if (reader->lengthInSamples != numSamples || reader->numChannels != 2)
+    {
+        result.passed = false;
+        result.detail = "golden is " + String(reader->lengthInSamples) + " samples long, the render " + String(numSamples);
+        return;
+    }
+
+    AudioSampleBuffer expected(2, numSamples);
+    reader->read(&expected, 0, numSamples, 0, true, true);
+
+    AudioSampleBuffer difference(2, numSamples);
+
+    double sumOfSquares = 0.0;
+    int maxAt = 0, firstOver = -1;
+
+    for (int c = 0; c < 2; c++)
+    {
+        const float* rendered = output.getReadPointer(c);
+        const float* wanted = expected.getReadPointer(c);
+        float* diff = difference.getWritePointer(c);
+
+        for (int i = 0; i < numSamples; i++)
+        {
+            diff[i] = rendered[i] - wanted[i];
+
+            const float magnitude = std::abs(diff[i]);
+
+            sumOfSquares += magnitude * magnitude;
+
+            if (magnitude > result.maxDiff) { result.maxDiff = magnitude; maxAt = i; }
+            if (magnitude > tolerance && (firstOver < 0 || i < firstOver)) firstOver = i;
+        }
+    }
+
+    result.rmsDiff = (float) std::sqrt(sumOfSquares / (2.0 * numSamples));
+
+    if (firstOver < 0) return;
+
+    result.passed = false;
+    result.detail << "differs by up to " << String(Decibels::gainToDecibels(result.maxDiff), 1) << " dB at "
+                  << String(maxAt / sampleRate, 3) << " s, first past the tolerance at " << String(firstOver / sampleRate, 3)
+                  << " s, rms difference " << String(Decibels::gainToDecibels(result.rmsDiff), 1) << " dB";
+
+    // What changed, to listen to or load next to the golden
+    const File diffFile = folder.getChildFile(result.name + " diff.wav");
+    diffFile.deleteFile();
+
+    ScopedPointer<FileOutputStream> stream = diffFile.createOutputStream();
+    ScopedPointer<AudioFormatWriter> writer = (stream != nullptr) ? wavFormat.createWriterFor(stream, sampleRate, 2, 32, StringPairArray(), 0) : nullptr;
+
+    if (writer != nullptr)
+    {
+        stream.release();
+        writer->writeFromAudioSampleBuffer(difference, 0, numSamples);
+        result.detail << " (" << diffFile.getFileName() << ")";
+    }
+}
+
+String BKGolden::findGallery(const String& name)
+{
+    for (int i = 0; i < BinaryData::namedResourceListSize; i++)
+    {
+        const String resource = BinaryData::namedResourceList[i];
+
+        if (!resource.contains("_xml")) continue;
+
+        int size;
+        String data = CharPointer_UTF8 (BinaryData::getNamedResource(resource.toUTF8(), size));
+
+        if (data.fromFirstOccurrenceOf("<gallery name=\"", false, true).upToFirstOccurrenceOf("\"", false, true) == name) return data;
+    }
+
+    return String();
+}
+
+File BKGolden::findGoldenFolder(void)
+{
+    const File starts[] = { File::getCurrentWorkingDirectory(), File::getSpecialLocation(File::currentExecutableFile) };
+
+    for (auto dir : starts)
+    {
+        // Up to the root, which is its own parent
+        for (; dir != dir.getParentDirectory(); dir = dir.getParentDirectory())
+        {
+            if (dir.getChildFile("bitKlavier.jucer").existsAsFile())                    return dir.getChildFile("golden");
+            if (dir.getChildFile("bk_JUCE/bitKlavier/bitKlavier.jucer").existsAsFile()) return dir.getChildFile("bk_JUCE/bitKlavier/golden");
+        }
+    }
+
+    return File();
+}
+
+bool BKGolden::report(String& text, DynamicObject& json)
+{
+    int numFailed = 0;
+
+    text << "golden: " << (recording ? "recorded " : "checked ") << results.size() << " renders in " << folder.getFullPathName()
+         << ", blocks of " << blockSize;
+
+    if (problem.isNotEmpty()) text << newLine << "    " << problem;
+
+    var resultVars;
+
+    for (auto& result : results)
+    {
+        if (!result.passed) ++numFailed;
+
+        text << newLine << "    " << result.name.paddedRight(' ', 24) << (result.passed ? (recording ? "recorded" : "ok      ") : "FAILED  ")
+             << " mean " << String(result.meanMs, 4) << " ms, max " << String(result.maxMs, 4) << " ms, "
+             << String(result.realtime, 1) << "x realtime";
+
+        if (result.goldenMeanMs > 0.0 && result.meanMs > 0.0)
+            text << ", " << String(result.goldenMeanMs / result.meanMs, 2) << "x the golden's speed";
+
+        if (!recording && result.passed && result.maxDiff > 0.0f)
+            text << ", max difference " << String(Decibels::gainToDecibels(result.maxDiff), 1) << " dB";
+
+        if (!result.passed) text << newLine << "        " << result.detail;
+
+        DynamicObject::Ptr obj = new DynamicObject();
+
+        obj->setProperty("name", result.name);
+        obj->setProperty("passed", result.passed);
+        obj->setProperty("detail", result.detail);
+        obj->setProperty("maxDiff", result.maxDiff);
+        obj->setProperty("rmsDiff", result.rmsDiff);
+        obj->setProperty("meanMs", result.meanMs);
+        obj->setProperty("maxMs", result.maxMs);
+        obj->setProperty("realtime", result.realtime);
+        obj->setProperty("goldenMeanMs", result.goldenMeanMs);
+
+        resultVars.append(var(obj.get()));
+    }
+
+    json.setProperty("folder", folder.getFullPathName());
+    json.setProperty("problem", problem);
+    json.setProperty("recording", recording);
+    json.setProperty("blockSize", blockSize);
+    json.setProperty("toleranceDb", Decibels::gainToDecibels(tolerance));
+    json.setProperty("results", resultVars);
+
+    return numFailed == 0 && results.size() > 0;
+}
@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+
+    BKGolden.h
+    Created: 19 Oct 2026 5:08:52pm
+    Author:
+
+    Golden renders: the check that a change to the render path (the
+    sampler voices, the synth, preparation timing) didn't change the
+    sound. Renders play the test tones (BKLoadTest), which are made in
+    code rather than read from the samples folder, so they come out the
+    same on every machine and the goldens live with the source, in
+    bk_JUCE/bitKlavier/golden. A change that means to change the sound
+    records them again and commits them with it.
+
+    A handful of short canned performances, each on one of the bundled
+    example galleries (Direct chords, a Synchronic pattern, Nostalgic
+    reverses, an adaptive tuning run, adaptive tempo), are rendered
+    offline through processBlock on a processor of our own. Recording
+    writes each render to the golden folder as a float WAV along with the
+    block size, sample set and render times it was made with. Checking
+    renders them again and compares sample by sample: anything further
+    from the golden than the tolerance fails, and leaves a WAV of the
+    difference next to it. The same run times every block, so the report
+    shows a speed-up and whether the sound held in one go.
+
+    The standalone app does both from the command line:
+
+        bitKlavier --golden-record [--golden=<folder>] [--block-size=<n>]
+        bitKlavier --golden[=<folder>] [--golden-tolerance=<dB>] [--golden-report=<file>]
+
+    and quits, with 1 if anything failed. The folder defaults to the one
+    in the source tree, looked for above where the app was started and
+    above the app itself. Goldens made with another sample set, sample
+    rate or block size are refused rather than compared.
+
+  ==============================================================================
+*/
+
+#ifndef BKGOLDEN_H_INCLUDED
+#define BKGOLDEN_H_INCLUDED
+
+#include "BKUtilities.h"
+
+#include "BKHeadlessRun.h"
+
+struct BKGoldenNote
+{
+    float start, length;    // seconds
+    int note, velocity;
+};
+
+struct BKGoldenPerformance
+{
+    const char* name;
+    const char* gallery;    // bundled gallery, by name
+    const BKGoldenNote* notes;
+    int numNotes;
+    float seconds;          // including the tail after the last note
+};
+
+class BKGolden : public BKHeadlessRun
+{
+public:
+    BKGolden(const File& folder, bool record, int blockSize, float toleranceDecibels, const File& report);
+    ~BKGolden(void);
+
+    // Looks for --golden or --golden-record on the command line and, if there, starts one. Standalone app only.
+    static BKGolden* fromCommandLine(const StringArray& args);
+
+private:
+    struct Result
+    {
+        String name;
+        bool passed;
+        String detail;
+        float maxDiff, rmsDiff;
+        double meanMs, maxMs, realtime;
+        double goldenMeanMs;    // what it took when the golden was recorded, 0 if unknown
+    };
+
+    File folder;
+    bool recording;
+    float tolerance;            // largest difference from the golden allowed, as gain
+
+    var manifest;               // golden.json: how the goldens were made
+    String problem;             // why nothing was rendered, if prepare() gave up
+
+    Array<Result> results;
+
+    bool prepare(void) override;            // reads the manifest, and gives up if the goldens don't match this run
+    void setUp(void) override;
+    void runRenders(void) override;
+    bool report(String& text, DynamicObject& json) override;
+
+    void render(const BKGoldenPerformance& performance, AudioSampleBuffer& output, Result& result);
+    void compare(const AudioSampleBuffer& output, const File& golden, Result& result);
+
+    static String findGallery(const String& name);
+    static File findGoldenFolder(void);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BKGolden)
+};
+
+
+#endif  // BKGOLDEN_H_INCLUDED
@@ -16,10 +16,17 @@
 #include "BKConstructionSite.h"
 
 // ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ BKItem ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~
+Atomic<int> BKItem::structureRevision;
+Atomic<int> BKItem::geometryRevision;
+Atomic<int> BKItem::identityRevision;
+Atomic<int> BKItem::settingsRevision;
+
 BKItem::BKItem(BKPreparationType type, int Id, BKAudioProcessor& p):
 ItemMapper(type, Id),
 BKDraggableComponent(true,false,true, 50, 50, 50, 50),
 processor(p),
+adjacent(7),
+indexed(false),
 wasJustDragged(false),
 constrain(new ComponentBoundsConstrainer()),
 resizer(new ResizableCornerComponent (this, constrain))
@@ -114,12 +121,16 @@ resizer(new ResizableCornerComponent (this, constrain))
         
         comment.setName("Comment");
     }
-    startTimerHz(10);
+    time = Time::getMillisecondCounter();
+    
+    ++structureRevision;
 }
 
 BKItem::~BKItem()
 {
     exitComment();
+    
+    ++structureRevision;
 }
 
 BKItem* BKItem::duplicate(void)
@@ -165,6 +176,7 @@ void BKItem::bkTextFieldDidChange(TextEditor& tf)
     if (name == comment.getName())
     {
         DBG(text);
+        ++settingsRevision;
         unfocusAllComponents();
         exitComment();
     }
@@ -203,7 +215,7 @@ void BKItem::configurePianoCB(void)
     if (!targetExists)
     {
         setPianoTarget(processor.currentPiano->getId());
-        processor.currentPiano->configure();
+        processor.currentPiano->configurePianoMaps();
     }
     
     menu.setSelectedId(getPianoTarget(), NotificationType::dontSendNotification);
@@ -247,6 +259,9 @@ void BKItem::setItemType(BKPreparationType newType, bool create)
     
     type = newType;
     
+    ++structureRevision;
+    identityDidChange();
+    
     if (type == PreparationTypeGenericMod)
     {
         setImage(ImageCache::getFromMemory(BinaryData::mod_unassigned_icon_png, BinaryData::mod_unassigned_icon_pngSize));
@@ -338,6 +353,13 @@ void BKItem::resized(void)
     }
     
     fullChild.setBounds(0,0,getWidth(),getHeight());
+    
+    ++geometryRevision;
+}
+
+void BKItem::moved(void)
+{
+    ++geometryRevision;
 }
 
 
@@ -348,6 +370,7 @@ void BKItem::copy(BKItem::Ptr itemToCopy)
     position = itemToCopy->getPosition();
     type = itemToCopy->getType();
     Id = itemToCopy->getId();
+    identityDidChange();
 }
 
 void BKItem::bkComboBoxDidChange    (ComboBox* cb)
@@ -361,7 +384,7 @@ void BKItem::bkComboBoxDidChange    (ComboBox* cb)
         {
             setPianoTarget(pianoId);
             
-            processor.currentPiano->configure();
+            processor.currentPiano->configurePianoMaps();
         }
     }
 }
@@ -415,8 +438,7 @@ void BKItem::enterComment(void)
 }
 
 
-#define RESET 0
-#define PHATNESS 10
+static const uint32 doubleClickMs = 1000;
 
 void BKItem::mouseDown(const MouseEvent& e)
 {
@@ -428,7 +450,7 @@ void BKItem::mouseDown(const MouseEvent& e)
 
     if ((current == this) && !wasJustDragged)
     {
-        if (time < PHATNESS)
+        if ((Time::getMillisecondCounter() - time) < doubleClickMs)
         {
             if (type == PreparationTypePianoMap)
             {
@@ -441,13 +463,13 @@ void BKItem::mouseDown(const MouseEvent& e)
         }
         else
         {
-            time = RESET;
+            time = Time::getMillisecondCounter();
         }
     }
     else
     {
         wasJustDragged = false;
-        time = RESET;
+        time = Time::getMillisecondCounter();
     }
     
     cs->setCurrentItem(this);
@@ -520,6 +542,8 @@ void BKItem::setState(XmlElement* e)
         setActive(b);
     }
     
+    identityDidChange();
+    
     i = e->getStringAttribute( "X" ).getIntValue();
     int x = i;
     
@@ -550,7 +574,14 @@ void BKItem::setState(XmlElement* e)
 // ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ BKGraph ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~ ~
 
 BKItemGraph::BKItemGraph(BKAudioProcessor& p):
-processor(p)
+processor(p),
+cachedPiano(nullptr),
+cachedNumItems(0),
+cachedStructure(-1),
+cachedGeometry(-1),
+gridIsStale(true),
+gridColumns(0),
+gridRows(0)
 {
     
 }
@@ -581,6 +612,9 @@ void BKItemGraph::removeItem(BKItem* item)
         BKItem* connectionItem = connections[i];
         
         connectionItem->removeConnection(item->getType(), item->getId());
+        item->removeConnection(connectionItem);
+        
+        processor.currentPiano->deconfigureConnection(item, connectionItem);
     }
     
     item->clearConnections();
@@ -593,53 +627,23 @@ void BKItemGraph::removeItem(BKItem* item)
 }
 
 
+// Lookups by type and Id go through the piano's item index (see Piano::updateItemIndex)
 bool BKItemGraph::contains(BKItem* thisItem)
 {
-    bool alreadyThere = false;
-    for (auto item : getItems())
-    {
-        if (item->getType() == BKPreparationTypeNil) continue;
-        
-        if ((item->getType() == thisItem->getType()) && (item->getId() == thisItem->getId()))
-        {
-            alreadyThere = true;
-            break;
-        }
-    }
+    if (thisItem->getType() == BKPreparationTypeNil) return false;
     
-    return alreadyThere;
+    return processor.currentPiano->contains(thisItem->getType(), thisItem->getId());
 }
 
 
 bool BKItemGraph::contains(BKPreparationType type, int Id)
 {
-    bool alreadyThere = false;
-    for (auto item : getItems())
-    {
-        if ((item->getType() == type) && (item->getId() == Id))
-        {
-            alreadyThere = true;
-            break;
-        }
-    }
-    
-    return alreadyThere;
+    return processor.currentPiano->contains(type, Id);
 }
 
 BKItem::Ptr BKItemGraph::get(BKPreparationType type, int Id)
 {
-    BKItem::Ptr thisItem = nullptr;
-
-    for (auto item : getItems())
-    {
-        if (item->getType() == type && item->getId() == Id)
-        {
-            thisItem = item;
-            break;
-        }
-    }
-
-    return thisItem;
+    return processor.currentPiano->itemWithTypeAndId(type, Id);
 }
 
 void BKItemGraph::clearItems(void)
@@ -760,7 +764,7 @@ void BKItemGraph::connect(BKItem* item1, BKItem* item2)
     item1->addConnection(item2);
     item2->addConnection(item1);
 
-    processor.currentPiano->configure();
+    processor.currentPiano->configureConnection(item1, item2);
 }
 
 void BKItemGraph::disconnect(BKItem* item1, BKItem* item2)
@@ -771,6 +775,8 @@ void BKItemGraph::disconnect(BKItem* item1, BKItem* item2)
     item1->removeConnection(item2);
     item2->removeConnection(item1);
     
+    processor.currentPiano->deconfigureConnection(item1, item2);
+    
     if (item1Type == PreparationTypeGenericMod)
     {
         if (!item1->isConnectedToAnyPreparation())
@@ -787,100 +793,211 @@ void BKItemGraph::disconnect(BKItem* item1, BKItem* item2)
     }
 }
 
-Array<Line<int>> BKItemGraph::getLines(void)
+bool BKItemGraph::isDrawnConnection(BKPreparationType fromType, BKPreparationType toType)
 {
-    Array<Line<int>> lines;
+    // Each connection is drawn once, from the item it's listed under here
+    if (fromType == PreparationTypeKeymap)
+        return true;
     
-    for (auto item : getItems())
-    {
-        BKPreparationType type = item->getType();
+    if (fromType == PreparationTypeTuning)      // synchronic, direct, and nostalgic targets
+        return toType >= PreparationTypeDirect && toType <= PreparationTypeNostalgic;
+    
+    if (fromType == PreparationTypeTempo)       // synchronic targets
+        return toType == PreparationTypeSynchronic;
+    
+    if (fromType == PreparationTypeSynchronic)  // nostalgic targets
+        return toType == PreparationTypeNostalgic;
     
-        if (type == PreparationTypeKeymap)
+    if ((fromType >= PreparationTypeDirectMod && fromType <= PreparationTypeTempoMod) || fromType == PreparationTypeReset)
+        return toType != PreparationTypeKeymap;
+    
+    return false;
+}
+
+Line<int> BKItemGraph::getLineBetween(BKItem* from, BKItem* to)
+{
+    Rectangle<int> otherBounds = to->getBounds();
+    
+    return Line<int>(from->getX() + from->getWidth()/2.0f,
+                     from->getY() + from->getHeight()/2.0f,
+                     otherBounds.getX() + otherBounds.getWidth()/2.0f,
+                     otherBounds.getY() + otherBounds.getHeight()/2.0f);
+}
+
+void BKItemGraph::updateLines(void)
+{
+    Piano* piano = processor.currentPiano.get();
+    
+    const bool structureChanged = (piano != cachedPiano ||
+                                   piano->getNumItems() != cachedNumItems ||
+                                   BKItem::structureRevision.get() != cachedStructure);
+    
+    if (!structureChanged && BKItem::geometryRevision.get() == cachedGeometry) return;
+    
+    if (structureChanged)
+    {
+        lines.clearQuick();
+        lineStarts.clearQuick();
+        lineEnds.clearQuick();
+        
+        for (auto item : piano->getItems())
         {
             for (auto target : item->getConnections())
             {
-                Rectangle<int> otherBounds = target->getBounds();
+                if (!isDrawnConnection(item->getType(), target->getType())) continue;
                 
-                lines.add(Line<int>(item->getX() + item->getWidth()/2.0f,
-                                    item->getY() + item->getHeight()/2.0f,
-                                    otherBounds.getX() + otherBounds.getWidth()/2.0f,
-                                    otherBounds.getY() + otherBounds.getHeight()/2.0f));
+                lines.add(getLineBetween(item, target));
+                lineStarts.add(item);
+                lineEnds.add(target);
             }
         }
-        else if (type == PreparationTypeTuning)
+    }
+    else
+    {
+        // Only moved: same lines, new ends
+        for (int i = 0; i < lines.size(); i++)
+            lines.setUnchecked(i, getLineBetween(lineStarts.getUnchecked(i), lineEnds.getUnchecked(i)));
+    }
+    
+    cachedPiano = piano;
+    cachedNumItems = piano->getNumItems();
+    cachedStructure = BKItem::structureRevision.get();
+    cachedGeometry = BKItem::geometryRevision.get();
+    
+    gridIsStale = true;
+}
+
+const Array<Line<int>>& BKItemGraph::getLines(void)
+{
+    updateLines();
+    
+    return lines;
+}
+
+Rectangle<int> BKItemGraph::getAreaAround(const BKItem::PtrArr& theseItems)
+{
+    updateLines();
+    
+    Rectangle<int> area;
+    
+    for (auto item : theseItems) area = area.getUnion(item->getBounds());
+    
+    for (int i = 0; i < lines.size(); i++)
+    {
+        if (theseItems.contains(lineStarts.getUnchecked(i)) || theseItems.contains(lineEnds.getUnchecked(i)))
         {
-            // Look for synchronic, direct, and nostalgic targets
-            for (auto target : item->getConnections())
-            {
-                BKPreparationType targetType = target->getType();
-                
-                if (targetType >= PreparationTypeDirect && targetType <= PreparationTypeNostalgic)
-                {
-                    Rectangle<int> otherBounds = target->getBounds();
-                    
-                    lines.add(Line<int>(item->getX() + item->getWidth()/2.0f,
-                                        item->getY() + item->getHeight()/2.0f,
-                                        otherBounds.getX() + otherBounds.getWidth()/2.0f,
-                                        otherBounds.getY() + otherBounds.getHeight()/2.0f));
-                }
-            }
+            const Line<int>& line = lines.getReference(i);
+            
+            area = area.getUnion(Rectangle<int>(line.getStart(), line.getEnd()));
         }
-        else if (type == PreparationTypeTempo)
+    }
+    
+    return area;
+}
+
+void BKItemGraph::updateGrid(void)
+{
+    updateLines();
+    
+    if (!gridIsStale) return;
+    
+    BKItem::PtrArr items = getItems();
+    
+    gridArea = Rectangle<int>();
+    maxItemPosition = juce::Point<int>();
+    
+    for (auto item : items)
+    {
+        gridArea = gridArea.getUnion(item->getBounds());
+        
+        maxItemPosition.x = jmax(maxItemPosition.x, item->getX());
+        maxItemPosition.y = jmax(maxItemPosition.y, item->getY());
+    }
+    
+    gridColumns = gridArea.getWidth() / gridCellSize + 1;
+    gridRows = gridArea.getHeight() / gridCellSize + 1;
+    
+    while (gridCells.size() < gridColumns * gridRows) gridCells.add(new Array<BKItem*>());
+    
+    for (auto cell : gridCells) cell->clearQuick();
+    
+    // Cells keep the items in piano order, so lookups find the same item a linear search would
+    for (auto item : items)
+    {
+        const Rectangle<int> cells = getGridCells(item->getBounds());
+        
+        for (int y = cells.getY(); y < cells.getBottom(); y++)
+            for (int x = cells.getX(); x < cells.getRight(); x++)
+                gridCells.getUnchecked(y * gridColumns + x)->add(item);
+    }
+    
+    gridIsStale = false;
+}
+
+Rectangle<int> BKItemGraph::getGridCells(const Rectangle<int>& area)
+{
+    // Edges count as inside, so an area touching an item's edge finds it
+    const int left   = jlimit(0, gridColumns - 1, (area.getX() - gridArea.getX()) / gridCellSize);
+    const int top    = jlimit(0, gridRows - 1, (area.getY() - gridArea.getY()) / gridCellSize);
+    const int right  = jlimit(0, gridColumns - 1, (area.getRight() - gridArea.getX()) / gridCellSize);
+    const int bottom = jlimit(0, gridRows - 1, (area.getBottom() - gridArea.getY()) / gridCellSize);
+    
+    return Rectangle<int>(left, top, right - left + 1, bottom - top + 1);
+}
+
+BKItem* BKItemGraph::getItemAt(juce::Point<int> position)
+{
+    updateGrid();
+    
+    if (gridCells.size() == 0) return nullptr;
+    
+    const Rectangle<int> cell = getGridCells(Rectangle<int>(position.x, position.y, 0, 0));
+    
+    for (auto item : *gridCells.getUnchecked(cell.getY() * gridColumns + cell.getX()))
+    {
+        int left = item->getX(); int right = left + item->getWidth();
+        int top = item->getY(); int bottom = top + item->getHeight();
+        
+        if (position.x >= left && position.x <= right && position.y >= top && position.y <= bottom) return item;
+    }
+    
+    return nullptr;
+}
+
+void BKItemGraph::getItemsInArea(const Rectangle<int>& area, Array<BKItem*>& itemsFound)
+{
+    updateGrid();
+    
+    if (gridCells.size() == 0) return;
+    
+    const Rectangle<int> cells = getGridCells(area);
+    
+    for (int y = cells.getY(); y < cells.getBottom(); y++)
+    {
+        for (int x = cells.getX(); x < cells.getRight(); x++)
         {
-            // Look for synchronic targets
-            for (auto target : item->getConnections())
+            for (auto item : *gridCells.getUnchecked(y * gridColumns + x))
             {
-                BKPreparationType targetType = target->getType();
+                const Rectangle<int> bounds = item->getBounds();
                 
-                if (targetType == PreparationTypeSynchronic)
-                {
-                    Rectangle<int> otherBounds = target->getBounds();
-                    
-                    lines.add(Line<int>(item->getX() + item->getWidth()/2.0f,
-                                        item->getY() + item->getHeight()/2.0f,
-                                        otherBounds.getX() + otherBounds.getWidth()/2.0f,
-                                        otherBounds.getY() + otherBounds.getHeight()/2.0f));
-                }
-            }
-        }
-        else if (type == PreparationTypeSynchronic)
-        {
-            // Look for nostalgic targets
-            for (auto target : item->getConnections())
-            {
-                BKPreparationType targetType = target->getType();
+                if (bounds.getRight() < area.getX() || area.getRight() < bounds.getX() ||
+                    bounds.getBottom() < area.getY() || area.getBottom() < bounds.getY()) continue;
                 
-                if (targetType == PreparationTypeNostalgic)
-                {
-                    Rectangle<int> otherBounds = target->getBounds();
-                    
-                    lines.add(Line<int>(item->getX() + item->getWidth()/2.0f,
-                                        item->getY() + item->getHeight()/2.0f,
-                                        otherBounds.getX() + otherBounds.getWidth()/2.0f,
-                                        otherBounds.getY() + otherBounds.getHeight()/2.0f));
-                }
-            }
-        }
-        else if ((type >= PreparationTypeDirectMod && type <= PreparationTypeTempoMod) || type == PreparationTypeReset)
-        {
-            // Look for nostalgic targets
-            for (auto target : item->getConnections())
-            {
-                BKPreparationType targetType = target->getType();
+                // Items spanning several cells are only added from the first one the area shares with them
+                const Rectangle<int> itemCells = getGridCells(bounds);
                 
-                if (targetType != PreparationTypeKeymap)
-                {
-                    Rectangle<int> otherBounds = target->getBounds();
-                    
-                    lines.add(Line<int>(item->getX() + item->getWidth()/2.0f,
-                                        item->getY() + item->getHeight()/2.0f,
-                                        otherBounds.getX() + otherBounds.getWidth()/2.0f,
-                                        otherBounds.getY() + otherBounds.getHeight()/2.0f));
-                }
+                if (x == jmax(cells.getX(), itemCells.getX()) && y == jmax(cells.getY(), itemCells.getY()))
+                    itemsFound.add(item);
             }
         }
     }
-    return lines;
+}
+
+juce::Point<int> BKItemGraph::getMaxItemPosition(void)
+{
+    updateGrid();
+    
+    return maxItemPosition;
 }
 
 void BKItemGraph::reconstruct(void)
@@ -1079,6 +1196,113 @@ bool BKItemGraph::isValidConnection(BKPreparationType type1, BKPreparationType t
     return false;
 }
 
-
-
-
+#if BENCHMARK_ITEM_GRAPH
+// Pastes generated pianos into a scratch gallery, item by item as BKConstructionSite::paste does, then
+// configures them from scratch and reloads them from their state, which looks every item and connection
+// up by type and Id. Lookups through the item index are timed against searching the items as before.
+String BKItemGraph::benchmark(BKAudioProcessor& processor)
+{
+    String report = "item graph benchmark\n";
+    
+    // Units of a keymap, direct, synchronic, tuning and tempo, wired up as a piano would be
+    const BKPreparationType unit[] = { PreparationTypeKeymap, PreparationTypeDirect, PreparationTypeSynchronic,
+                                       PreparationTypeTuning, PreparationTypeTempo };
+    const int unitSize = 5;
+    
+    const int sizes[] = { 1000, 5000 };
+    
+    for (auto numItems : sizes)
+    {
+        Gallery::Ptr scratch = new Gallery(XmlDocument::parse(String::createStringFromData(BinaryData::Basic_Piano_xml,
+                                                                                           BinaryData::Basic_Piano_xmlSize)),
+                                           processor);
+        
+        BKItem::PtrArr clipboard;
+        
+        for (int i = 0; i < numItems; i++)
+        {
+            BKPreparationType type = unit[i % unitSize];
+            
+            BKItem* item = new BKItem(type, scratch->add(type), processor);
+            item->setTopLeftPosition((i % 100) * 80, (i / 100) * 80);
+            
+            clipboard.add(item);
+        }
+        
+        for (int i = 0; i + unitSize <= numItems; i += unitSize)
+        {
+            BKItem* keymap = clipboard[i];
+            BKItem* direct = clipboard[i + 1];
+            BKItem* synchronic = clipboard[i + 2];
+            BKItem* tuning = clipboard[i + 3];
+            BKItem* tempo = clipboard[i + 4];
+            
+            BKItem* pairs[][2] = { { keymap, direct }, { keymap, synchronic }, { tuning, direct },
+                                   { tuning, synchronic }, { tempo, synchronic } };
+            
+            for (auto pair : pairs)
+            {
+                pair[0]->addConnection(pair[1]);
+                pair[1]->addConnection(pair[0]);
+            }
+        }
+        
+        Piano::Ptr piano = new Piano(processor, -1);
+        piano->setGallery(scratch);
+        piano->prepareToPlay(processor.getSampleRate());
+        
+        double start = Time::getMillisecondCounterHiRes();
+        for (auto item : clipboard)
+        {
+            if (piano->contains(item->getType(), item->getId())) continue;
+            
+            piano->add(item);
+        }
+        const double pasteMs = Time::getMillisecondCounterHiRes() - start;
+        
+        start = Time::getMillisecondCounterHiRes();
+        piano->configure();
+        const double configureMs = Time::getMillisecondCounterHiRes() - start;
+        
+        ScopedPointer<XmlElement> state = piano->getState().createXml();
+        
+        Piano::Ptr reloaded = new Piano(processor, -1);
+        reloaded->setGallery(scratch);
+        
+        start = Time::getMillisecondCounterHiRes();
+        reloaded->setState(state);
+        const double loadMs = Time::getMillisecondCounterHiRes() - start;
+        
+        int found = 0;
+        
+        start = Time::getMillisecondCounterHiRes();
+        for (auto item : clipboard)
+        {
+            if (piano->itemWithTypeAndId(item->getType(), item->getId()) != nullptr) found++;
+        }
+        const double indexedMs = Time::getMillisecondCounterHiRes() - start;
+        
+        const BKItem::PtrArr items = piano->getItems();
+        
+        start = Time::getMillisecondCounterHiRes();
+        for (auto item : clipboard)
+        {
+            for (auto other : items)
+            {
+                if (other->getType() == item->getType() && other->getId() == item->getId())
+                {
+                    found++;
+                    break;
+                }
+            }
+        }
+        const double linearMs = Time::getMillisecondCounterHiRes() - start;
+        
+        report += "  " + String(numItems) + " items (" + String(reloaded->getNumItems()) + " reloaded, " + String(found) + " found)\n";
+        report += "    paste " + String(pasteMs, 3) + " ms, configure " + String(configureMs, 3) + " ms, load " + String(loadMs, 3) + " ms\n";
+        report += "    lookups: indexed " + String(indexedMs, 3) + " ms, searched " + String(linearMs, 3) + " ms\n";
+    }
+    
+    return report;
+}
+#endif
@@ -19,8 +19,9 @@
 
 class BKAudioProcessor;
 class BKConstructionSite;
+class Piano;
 
-class BKItem : public ItemMapper, public BKDraggableComponent, public BKListener, private Timer
+class BKItem : public ItemMapper, public BKDraggableComponent, public BKListener
 {
 public:
     typedef ReferenceCountedArray<BKItem, CriticalSection>      PtrArr;
@@ -28,13 +29,41 @@ public:
     
     BKItem(BKPreparationType type, int Id, BKAudioProcessor& p);
     
-    uint64 time;
-    inline void timerCallback(void) override
-    {
-        time++;
-    };
+    // When the item was last clicked (Time::getMillisecondCounter), to tell a second click that opens it
+    uint32 time;
     
     ~BKItem(void);
+    
+    // Bumped whenever any item is made, changes type or connections (structure), or moves or
+    // is resized (geometry), so BKItemGraph knows when its lines and item grid are out of date.
+    // Atomic since galleries can be built off the message thread (see Setlist).
+    static Atomic<int> structureRevision, geometryRevision;
+    
+    // Bumped when an item some piano has indexed changes type or Id, so Piano knows to rebuild its
+    // (type, Id) index. Items that haven't been added to a piano yet (paste) don't touch it.
+    static Atomic<int> identityRevision;
+    
+    // Bumped when any other setting undo keeps track of changes (active, piano target, name, comment
+    // text), so PianoHistory can skip looking at the graph when nothing has been edited.
+    static Atomic<int> settingsRevision;
+    
+    inline void setActive(bool a) { if (a != active) { active = a; ++settingsRevision; } }
+    inline void setPianoTarget(int target) { if (target != pianoTarget) { pianoTarget = target; ++settingsRevision; } }
+    inline void setItemName(String s) { if (s != name) { name = s; ++settingsRevision; } }
+    
+    inline void setIndexed(void) { indexed = true; }
+    
+    // Key for looking items up by type and Id
+    static inline int64 getKey(BKPreparationType type, int Id) { return ((int64) type << 32) | (uint32) Id; }
+    inline int64 getKey(void) const noexcept { return getKey(type, Id); }
+    
+    inline void setId(int newId)
+    {
+        if (newId == Id) return;
+        
+        Id = newId;
+        identityDidChange();
+    }
 
     BKItem* duplicate(void);
     
@@ -44,6 +73,7 @@ public:
     void paint(Graphics& g) override;
     
     void resized(void) override;
+    void moved(void) override;
     
     void itemIsBeingDragged(const MouseEvent&) override;
     
@@ -61,19 +91,26 @@ public:
     inline void setConnections(BKItem::PtrArr newConnections)
     {
         connections = newConnections;
+        
+        adjacent.clear();
+        for (auto item : connections) adjacent.set(getAdjacencyKey(item), 0);
+        
+        ++structureRevision;
     }
     
     inline void addConnection(BKItem::Ptr item)
     {
-        if (!isConnectedTo(item))   connections.add(item);
+        if (!isConnectedTo(item))
+        {
+            connections.add(item);
+            adjacent.set(getAdjacencyKey(item), 0);
+        }
+        ++structureRevision;
     }
     
     inline void addConnections(BKItem::PtrArr theseItems)
     {
-        for (auto item : theseItems)
-        {
-            if (!isConnectedTo(item)) connections.add(item);
-        }
+        for (auto item : theseItems) addConnection(item);
     }
     
     
@@ -83,7 +120,9 @@ public:
         {
             if ((connections.getUnchecked(i)->getType() == type) && (connections.getUnchecked(i)->getId() == Id))
             {
+                adjacent.remove(getAdjacencyKey(connections.getUnchecked(i)));
                 connections.remove(i);
+                ++structureRevision;
                 break;
             }
         }
@@ -91,13 +130,13 @@ public:
     
     inline void removeConnection(BKItem::Ptr thisItem)
     {
-        int index = 0;
-        for (auto item : connections)
+        if (adjacent.contains(getAdjacencyKey(thisItem)))
         {
-            if (item == thisItem) connections.remove(index);
-            
-            index++;
+            connections.removeObject(thisItem);
+            adjacent.remove(getAdjacencyKey(thisItem));
         }
+        
+        ++structureRevision;
     }
     
     inline bool isConnectedTo(BKPreparationType type, int Id)
@@ -113,17 +152,10 @@ public:
         return false;
     }
     
+    // Constant time: connections are between items in the same piano, where no two share a type and Id
     inline bool isConnectedTo(BKItem::Ptr thisItem)
     {
-        for (auto item : connections)
-        {
-            if ((item->getType() == thisItem->getType()) && (item->getId() == thisItem->getId()))
-            {
-                return true;
-            }
-        }
-        
-        return false;
+        return adjacent.contains(getAdjacencyKey(thisItem));
     }
     
     inline void changeIdOfConnection(BKPreparationType type, int oldId, int newId)
@@ -214,14 +246,22 @@ public:
     inline void clearConnections(void)
     {
         connections.clear();
+        adjacent.clear();
+        ++structureRevision;
     }
     
     inline void clearConnectionsOfType(BKPreparationType type)
     {
         for (int i = connections.size(); --i >= 0;)
         {
-            if (connections.getUnchecked(i)->getType() == type) connections.remove(i);
+            if (connections.getUnchecked(i)->getType() == type)
+            {
+                adjacent.remove(getAdjacencyKey(connections.getUnchecked(i)));
+                connections.remove(i);
+            }
         }
+        
+        ++structureRevision;
     }
     
     void copy(BKItem::Ptr);
@@ -251,7 +291,7 @@ public:
     
     bool resizing;
     
-    void setCommentText(String text) { comment.setText(text);}
+    void setCommentText(String text) { comment.setText(text); ++settingsRevision; }
     String getCommentText(void) { return comment.getText();}
     
     void exitComment(void);
@@ -268,6 +308,13 @@ private:
     BKAudioProcessor& processor;
     Label label;
     
+    // The connections again, by address, for isConnectedTo
+    HashMap<int64, int> adjacent;
+    static inline int64 getAdjacencyKey(const BKItem* item) { return (int64) (pointer_sized_int) item; }
+    
+    bool indexed;
+    inline void identityDidChange(void) { if (indexed) ++identityRevision; }
+    
     bool wasJustDragged;
     
     ScopedPointer<ComponentBoundsConstrainer> constrain;
@@ -334,11 +381,47 @@ public:
     BKItem::PtrArr getItems(void);
 
     
-    Array<Line<int>> getLines(void);
+    // Connection lines, cached until items move or connect.
+    const Array<Line<int>>& getLines(void);
+    
+    // The area the given items and their connection lines cover, to repaint around a drag.
+    Rectangle<int> getAreaAround(const BKItem::PtrArr& theseItems);
+    
+    // Hit-testing and lasso selection through a grid of the items, rebuilt only after they move.
+    BKItem* getItemAt(juce::Point<int> position);
+    void getItemsInArea(const Rectangle<int>& area, Array<BKItem*>& itemsFound);
+    
+    // The rightmost and lowest top-left corner of any item.
+    juce::Point<int> getMaxItemPosition(void);
+    
+#if BENCHMARK_ITEM_GRAPH
+    static String benchmark(BKAudioProcessor& processor);
+#endif
     
 private:
     BKAudioProcessor& processor;
     
+    // Cache, checked against the current piano and the item revisions
+    Piano* cachedPiano;
+    int cachedNumItems, cachedStructure, cachedGeometry;
+    bool gridIsStale;
+    
+    Array<Line<int>> lines;
+    Array<BKItem*> lineStarts, lineEnds;
+    
+    enum { gridCellSize = 128 };
+    Rectangle<int> gridArea;
+    int gridColumns, gridRows;
+    OwnedArray<Array<BKItem*>> gridCells;
+    juce::Point<int> maxItemPosition;
+    
+    void updateLines(void);
+    void updateGrid(void);
+    Rectangle<int> getGridCells(const Rectangle<int>& area);
+    
+    static bool isDrawnConnection(BKPreparationType fromType, BKPreparationType toType);
+    static Line<int> getLineBetween(BKItem* from, BKItem* to);
+    
     JUCE_LEAK_DETECTOR(BKItemGraph)
 };
 
@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    BKHeadlessRun.cpp
+    Created: 19 Oct 2026 6:02:17pm
+    Author:
+
+  ==============================================================================
+*/
+
+#include "BKHeadlessRun.h"
+
+#include "PluginProcessor.h"
+
+BKHeadlessRun::BKHeadlessRun(const String& name, int bs, const File& report):
+Thread(name),
+blockSize(bs),
+sampleRate(44100.0),
+reportFile(report)
+{
+    // The processor is made once the app is up, not from inside the one that found us
+    startTimer(1);
+}
+
+BKHeadlessRun::~BKHeadlessRun(void)
+{
+    stopRun();
+}
+
+void BKHeadlessRun::stopRun(void)
+{
+    stopTimer();
+    cancelPendingUpdate();
+    stopThread(10000);
+}
+
+File BKHeadlessRun::getArgumentFile(const String& path)
+{
+    return path.isNotEmpty() ? File::getCurrentWorkingDirectory().getChildFile(path) : File();
+}
+
+void BKHeadlessRun::timerCallback(void)
+{
+    if (processor == nullptr)
+    {
+        if (!prepare())
+        {
+            stopTimer();
+            triggerAsyncUpdate();
+            return;
+        }
+
+        processor = new BKAudioProcessor();
+
+        processor->setPlayConfigDetails(0, 2, sampleRate, blockSize);
+        processor->prepareToPlay(sampleRate, blockSize);
+
+        processor->mainPianoSynth.setRenderBudget(0.0);
+
+        setUp();
+
+        startTimer(100);
+        return;
+    }
+
+    if (!processor->samplesAreLoaded()) return;
+
+    stopTimer();
+    startThread(9);
+}
+
+void BKHeadlessRun::run(void)
+{
+    runRenders();
+
+    triggerAsyncUpdate();
+}
+
+void BKHeadlessRun::handleAsyncUpdate(void)
+{
+    String text;
+    DynamicObject::Ptr json = new DynamicObject();
+
+    const bool passed = report(text, *json);
+
+    std::cout << text << std::endl;
+    DBG(text);
+
+    if (reportFile != File() && json->getProperties().size() > 0)
+    {
+        if (!reportFile.replaceWithText(JSON::toString(var(json.get()))))
+            DBG(getThreadName() + ": couldn't write " + reportFile.getFullPathName());
+    }
+
+    if (!passed && JUCEApplicationBase::getInstance() != nullptr)
+        JUCEApplicationBase::getInstance()->setApplicationReturnValue(1);
+
+    JUCEApplicationBase::quit();
+}
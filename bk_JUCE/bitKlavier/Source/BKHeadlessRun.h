@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+
+    BKHeadlessRun.h
+    Created: 19 Oct 2026 6:02:17pm
+    Author:
+
+    What the command line runs (replay, soak, golden renders) have in
+    common: a processor of their own, off the audio device, fed blocks as
+    fast as they render on a thread of their own, and a report at the end
+    after which the app quits.
+
+    Once the app is up we make the processor, prepare it at the run's
+    sample rate and block size, and turn the governor off, since it drops
+    voices by how long blocks take and that's what these runs measure.
+    When its samples have loaded, runRenders() goes on the run's thread.
+    report() then writes the console text and the JSON report on the
+    message thread, and the app quits with 1 if it says the run failed.
+
+  ==============================================================================
+*/
+
+#ifndef BKHEADLESSRUN_H_INCLUDED
+#define BKHEADLESSRUN_H_INCLUDED
+
+#include "BKUtilities.h"
+
+class BKAudioProcessor;
+
+class BKHeadlessRun : public Thread,
+                      private Timer,
+                      private AsyncUpdater
+{
+public:
+    BKHeadlessRun(const String& name, int blockSize, const File& report);
+    virtual ~BKHeadlessRun(void);
+
+    // A path from the command line, relative to where the app was started; File() if it's empty.
+    static File getArgumentFile(const String& path);
+
+protected:
+    int blockSize;
+    double sampleRate;
+    File reportFile;
+
+    ScopedPointer<BKAudioProcessor> processor;
+
+    // Message thread, before the processor is made. May change the sample rate and block size;
+    // false gives up, going straight to report().
+    virtual bool prepare(void) { return true; }
+
+    // Message thread, once the processor is prepared and before its samples have loaded.
+    virtual void setUp(void) {}
+
+    // The run's thread. Should stop early if threadShouldExit().
+    virtual void runRenders(void) = 0;
+
+    // Message thread, when it's all over. Fills in the console text and the report (written only if it has
+    // anything in it); false if the run failed.
+    virtual bool report(String& text, DynamicObject& json) = 0;
+
+    // Every subclass calls this from its destructor, so the thread isn't left using members that are gone.
+    void stopRun(void);
+
+private:
+    void timerCallback(void) override;      // makes the processor, then waits for the samples
+    void run(void) override;
+    void handleAsyncUpdate(void) override;  // reports and quits
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BKHeadlessRun)
+};
+
+
+#endif  // BKHEADLESSRUN_H_INCLUDED
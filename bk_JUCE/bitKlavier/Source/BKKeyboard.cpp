@@ -62,7 +62,9 @@ canScroll (true),
 useMousePositionForVelocity (true),
 shouldCheckMousePos (false),
 keyMappingOctave (6),
-octaveNumForMiddleC (3)
+octaveNumForMiddleC (3),
+plainWhiteKeysScale (1.0f),
+drawingPlainWhiteKeys (false)
 {
     firstKeyDown = -1; lastKeyDown = -1; lastKeySelected = -1;
     
@@ -92,8 +94,6 @@ octaveNumForMiddleC (3)
     }
     
     state.addListener (this);
-    
-    startTimerHz (50);
 }
 
 BKKeymapKeyboardComponent::~BKKeymapKeyboardComponent()
@@ -174,6 +174,7 @@ void BKKeymapKeyboardComponent::setScrollButtonsVisible (const bool newCanScroll
 void BKKeymapKeyboardComponent::colourChanged()
 {
     setOpaque (findColour (whiteNoteColourId).isOpaque());
+    plainWhiteKeys = Image();
     repaint();
 }
 
@@ -193,6 +194,7 @@ void BKKeymapKeyboardComponent::setMidiChannelsToDisplay (const int midiChannelM
 {
     midiInChannelMask = midiChannelMask;
     shouldCheckState = true;
+    startTimerHz (50);
 }
 
 void BKKeymapKeyboardComponent::setVelocity (const float v, const bool useMousePosition)
@@ -370,10 +372,79 @@ void BKKeymapKeyboardComponent::repaintNote (const int noteNum)
         repaint (getRectangleForKey (noteNum));
 }
 
-void BKKeymapKeyboardComponent::paint (Graphics& g)
+void BKKeymapKeyboardComponent::repaintKeymapNote (const int noteNum)
+{
+    if (keysCurrentlyDrawnInKeymap[noteNum] != state.isInKeymap (noteNum))
+    {
+        keysCurrentlyDrawnInKeymap.setBit (noteNum, state.isInKeymap (noteNum));
+        repaintNote (noteNum);
+    }
+}
+
+void BKKeymapKeyboardComponent::repaintKeymap()
+{
+    for (int i = rangeStart; i <= rangeEnd; ++i)
+        repaintKeymapNote (i);
+}
+
+bool BKKeymapKeyboardComponent::isPlainWhiteKey (const int noteNum)
+{
+    return ! state.isInKeymap (noteNum)
+        && ! state.isNoteOnForChannels (midiInChannelMask, noteNum)
+        && ! mouseOverNotes.contains (noteNum)
+        && keyValues.getUnchecked (noteNum) == 0.;
+}
+
+void BKKeymapKeyboardComponent::drawPlainWhiteKeys (const float scale)
 {
+    plainWhiteKeysScale = scale;
+    plainWhiteKeys = Image (Image::ARGB,
+                            jmax (1, roundToInt (getWidth() * scale)),
+                            jmax (1, roundToInt (getHeight() * scale)),
+                            true);
+    
+    Graphics g (plainWhiteKeys);
+    g.addTransform (AffineTransform::scale (scale));
+    
     g.fillAll (findColour (whiteNoteColourId));
     
+    const Colour lineColour (findColour (keySeparatorLineColourId));
+    const Colour textColour (findColour (textLabelColourId));
+    
+    drawingPlainWhiteKeys = true;
+    
+    for (int octave = 0; octave < 128; octave += 12)
+    {
+        for (int white = 0; white < 7; ++white)
+        {
+            const int noteNum = octave + whiteNotes [white];
+            
+            if (noteNum >= rangeStart && noteNum <= rangeEnd)
+            {
+                Rectangle<int> pos = getRectangleForKey (noteNum);
+                
+                drawWhiteNote (noteNum, g, pos.getX(), pos.getY(), pos.getWidth(), pos.getHeight(),
+                               false, false, Colour(Colours::transparentWhite), lineColour, textColour);
+            }
+        }
+    }
+    
+    drawingPlainWhiteKeys = false;
+}
+
+void BKKeymapKeyboardComponent::paint (Graphics& g)
+{
+    // Keys with nothing on them come from the cached image; only the ones that are
+    // down, in the keymap, valued or under the mouse, and inside the clip, are drawn
+    const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    
+    if (plainWhiteKeys.isNull() || plainWhiteKeysScale != scale ||
+        plainWhiteKeys.getWidth() != jmax (1, roundToInt (getWidth() * scale)) ||
+        plainWhiteKeys.getHeight() != jmax (1, roundToInt (getHeight() * scale)))
+        drawPlainWhiteKeys (scale);
+    
+    g.drawImageTransformed (plainWhiteKeys, AffineTransform::scale (1.0f / plainWhiteKeysScale));
+    
     Colour keyColour;
     const Colour lineColour (findColour (keySeparatorLineColourId));
     const Colour textColour (findColour (textLabelColourId));
@@ -394,6 +465,15 @@ void BKKeymapKeyboardComponent::paint (Graphics& g)
             {
                 Rectangle<int> pos = getRectangleForKey (noteNum);
                 
+                if (! g.clipRegionIntersects (pos)) continue;
+                
+                keysCurrentlyDrawnInKeymap.setBit (noteNum, state.isInKeymap (noteNum));
+                
+                if (isPlainWhiteKey (noteNum)) continue;
+                
+                g.setColour (findColour (whiteNoteColourId));
+                g.fillRect (pos);
+                
                 drawWhiteNote (noteNum, g, pos.getX(), pos.getY(), pos.getWidth(), pos.getHeight(),
                                state.isNoteOnForChannels (midiInChannelMask, noteNum),
                                mouseOverNotes.contains (noteNum), keyColour, lineColour, textColour);
@@ -464,6 +544,10 @@ void BKKeymapKeyboardComponent::paint (Graphics& g)
             {
                 Rectangle<int> pos = getRectangleForKey (noteNum);
                 
+                if (! g.clipRegionIntersects (pos)) continue;
+                
+                keysCurrentlyDrawnInKeymap.setBit (noteNum, state.isInKeymap (noteNum));
+                
                 drawBlackNote (noteNum, g, pos.getX(), pos.getY(), pos.getWidth(), pos.getHeight(),
                                state.isNoteOnForChannels (midiInChannelMask, noteNum),
                                mouseOverNotes.contains (noteNum), keyColour);
@@ -481,7 +565,7 @@ void BKKeymapKeyboardComponent::drawWhiteNote (int midiNoteNumber,
 {
     Colour c (keyColour);
     
-    float keyVal = keyValues.getUnchecked(midiNoteNumber);
+    float keyVal = drawingPlainWhiteKeys ? 0.f : keyValues.getUnchecked(midiNoteNumber);
     if(keyVal != 0.)
     {
         if(keyVal > 0) c = c.overlaidWith (Colours::red.withSaturation ( sqrt(keyVal / 50.)) );
@@ -638,6 +722,7 @@ void BKKeymapKeyboardComponent::drawBlackNote (int midiNoteNumber,
 void BKKeymapKeyboardComponent::setOctaveForMiddleC (const int octaveNum)
 {
     octaveNumForMiddleC = octaveNum;
+    plainWhiteKeys = Image();
     repaint();
 }
 
@@ -771,23 +856,24 @@ void BKKeymapKeyboardComponent::resized()
         
         getKeyPos (rangeEnd, kx2, kw2);
         scrollUp->setVisible (canScroll && kx2 > w);
+        plainWhiteKeys = Image();
         repaint();
     }
 }
 
-void BKKeymapKeyboardComponent::handleKeymapNoteOn (BKKeymapKeyboardState*, int /*midiNoteNumber*/)
+void BKKeymapKeyboardComponent::handleKeymapNoteOn (BKKeymapKeyboardState*, int midiNoteNumber)
 {
-    shouldCheckState = true; // (probably being called from the audio thread, so avoid blocking in here)
+    repaintKeymapNote (midiNoteNumber); // keymaps only change on the message thread
 }
 
-void BKKeymapKeyboardComponent::handleKeymapNoteOff (BKKeymapKeyboardState*, int /*midiNoteNumber*/)
+void BKKeymapKeyboardComponent::handleKeymapNoteOff (BKKeymapKeyboardState*, int midiNoteNumber)
 {
-    shouldCheckState = true; // (probably being called from the audio thread, so avoid blocking in here)
+    repaintKeymapNote (midiNoteNumber); // keymaps only change on the message thread
 }
 
-void BKKeymapKeyboardComponent::handleKeymapNoteToggled (BKKeymapKeyboardState*, int /*midiNoteNumber*/)
+void BKKeymapKeyboardComponent::handleKeymapNoteToggled (BKKeymapKeyboardState*, int midiNoteNumber)
 {
-    shouldCheckState = true; // (probably being called from the audio thread, so avoid blocking in here)
+    repaintKeymapNote (midiNoteNumber); // keymaps only change on the message thread
 }
 
 
@@ -898,7 +984,7 @@ void BKKeymapKeyboardComponent::setKeysInKeymap(Array<int> keys)
     
     state.setKeymap(keymap);
     
-    repaint();
+    repaintKeymap();
 }
 
 void BKKeymapKeyboardComponent::setKeyValue(int midiNoteNumber, float val)
@@ -1011,6 +1097,7 @@ void BKKeymapKeyboardComponent::setFundamental(int fund)
         keyValues.setUnchecked(i, tempVals.getUnchecked(i));
     }
     
+    plainWhiteKeys = Image();
     repaint();
 }
 
@@ -1073,6 +1160,7 @@ void BKKeymapKeyboardComponent::mouseDown (const MouseEvent& e)
     {
         updateNoteUnderMouse (e, true);
         shouldCheckMousePos = true;
+        startTimerHz (50);
     }
 }
 
@@ -1132,6 +1220,10 @@ void BKKeymapKeyboardComponent::timerCallback()
             if (mi->getComponentUnderMouse() == this || isParentOf (mi->getComponentUnderMouse()))
                 updateNoteUnderMouse (getLocalPoint (nullptr, mi->getScreenPosition()).roundToInt(), mi->isDragging(), mi->getIndex());
     }
+    
+    // Only runs while there's something to follow
+    if (! shouldCheckState && ! shouldCheckMousePos)
+        stopTimer();
 }
 
 //==============================================================================
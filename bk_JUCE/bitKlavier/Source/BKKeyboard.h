@@ -170,6 +170,11 @@ public:
     void setScrollButtonsVisible (bool canScroll);
     
     void setKeysInKeymap(Array<int> keys);
+    
+    /** Repaints the keys whose keymap state differs from what was last drawn.
+        Use after changing the state's keymap without notifying its listeners.
+    */
+    void repaintKeymap();
 
     //==============================================================================
     /** A set of colour IDs to use to change the colour of various aspects of the keyboard.
@@ -423,7 +428,7 @@ private:
     float velocity;
 
     Array<int> mouseOverNotes, mouseDownNotes;
-    BigInteger keysPressed, keysCurrentlyDrawnDown;
+    BigInteger keysPressed, keysCurrentlyDrawnDown, keysCurrentlyDrawnInKeymap;
     bool shouldCheckState;
     bool allowDrag;
 
@@ -437,6 +442,11 @@ private:
     Array<int> keyPressNotes;
     int keyMappingOctave, octaveNumForMiddleC;
     int fundamental;
+    
+    // The white keys with nothing on them, drawn once per size and pixel scale
+    Image plainWhiteKeys;
+    float plainWhiteKeysScale;
+    bool drawingPlainWhiteKeys;
 
     static const uint8 whiteNotes[];
     static const uint8 blackNotes[];
@@ -448,6 +458,9 @@ private:
     void updateNoteUnderMouse (juce::Point<int>, bool isDown, int fingerNum);
     void updateNoteUnderMouse (const MouseEvent&, bool isDown);
     void repaintNote (int midiNoteNumber);
+    void repaintKeymapNote (int midiNoteNumber);
+    bool isPlainWhiteKey (int midiNoteNumber);
+    void drawPlainWhiteKeys (float scale);
     void setLowestVisibleKeyFloat (float noteNumber);
     
     int lastNoteOver;
@@ -0,0 +1,93 @@
+/*
+  ==============================================================================
+
+    BKMemoryReport.cpp
+    Created: 19 Oct 2026 9:14:36am
+    Author:
+
+  ==============================================================================
+*/
+
+#include "BKMemoryReport.h"
+
+BKMemoryReport::BKMemoryReport(const String& n):
+name(n),
+bytes(0),
+count(0),
+shared(false)
+{
+
+}
+
+BKMemoryReport::~BKMemoryReport(void)
+{
+
+}
+
+BKMemoryReport& BKMemoryReport::add(const String& n, int64 b, int c)
+{
+    BKMemoryReport* part = parts.add(new BKMemoryReport(n));
+
+    part->addBytes(b, c);
+
+    return *part;
+}
+
+int64 BKMemoryReport::getTotalBytes(void) const
+{
+    int64 total = bytes;
+
+    for (auto part : parts)
+    {
+        if (!part->isShared()) total += part->getTotalBytes();
+    }
+
+    return total;
+}
+
+var BKMemoryReport::toVar(void) const
+{
+    DynamicObject::Ptr obj = new DynamicObject();
+
+    obj->setProperty("name", name);
+    obj->setProperty("bytes", getTotalBytes());
+    obj->setProperty("count", count);
+    if (shared) obj->setProperty("shared", true);
+
+    if (parts.size() > 0)
+    {
+        var partVars;
+
+        for (auto part : parts) partVars.append(part->toVar());
+
+        obj->setProperty("parts", partVars);
+    }
+
+    return var(obj.get());
+}
+
+String BKMemoryReport::toJSON(void) const
+{
+    return JSON::toString(toVar());
+}
+
+String BKMemoryReport::toString(void) const
+{
+    String text;
+
+    appendTo(text, 0);
+
+    return text;
+}
+
+void BKMemoryReport::appendTo(String& text, int depth) const
+{
+    text << String::repeatedString("    ", depth) << name << ": " << File::descriptionOfSizeInBytes(getTotalBytes());
+
+    if (count > 0) text << " (" << count << ")";
+    if (shared) text << " shared";
+
+    text << newLine;
+
+    for (auto part : parts) part->appendTo(text, depth + 1);
+}
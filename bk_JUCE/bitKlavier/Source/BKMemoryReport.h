@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    BKMemoryReport.h
+    Created: 19 Oct 2026 9:14:36am
+    Author:
+
+    Where an instance's memory goes, as a tree: the processor reports its
+    samples, synth, gallery and setlist, the gallery its preparations and
+    pianos, each piano its items, processors, undo history and preparation
+    maps, and so on down. Each owner implements BKMemoryAccountable and adds
+    what it holds to the report it is handed.
+
+    Bytes are estimates from object sizes and array lengths, not from the
+    allocator, but they grow and shrink with what they count, which is what
+    we need for sizing and for catching things that only ever grow.
+
+    Memory held for several owners (the sample bank every instance shares)
+    is reported once; other owners can show their share of it as a shared
+    part, which is left out of the totals.
+
+  ==============================================================================
+*/
+
+#ifndef BKMEMORYREPORT_H_INCLUDED
+#define BKMEMORYREPORT_H_INCLUDED
+
+#include "BKUtilities.h"
+
+class BKMemoryReport
+{
+public:
+    BKMemoryReport(const String& name);
+    ~BKMemoryReport(void);
+
+    // A part of this one; its bytes count towards this one's total.
+    BKMemoryReport& add(const String& name, int64 bytes = 0, int count = 0);
+
+    // Bytes (and objects) held directly by this one, not by any of its parts.
+    inline void addBytes(int64 b, int n = 0) noexcept { bytes += b; count += n; }
+
+    // Counted elsewhere in the report: shown, but not added to the totals.
+    inline void setShared(bool s) noexcept { shared = s; }
+    inline bool isShared(void) const noexcept { return shared; }
+
+    inline const String& getName(void) const noexcept { return name; }
+    inline int getCount(void) const noexcept { return count; }
+    
+    inline int getNumParts(void) const noexcept { return parts.size(); }
+    inline const BKMemoryReport& getPart(int i) const noexcept { return *parts.getUnchecked(i); }
+
+    // This one's bytes and all of its parts' that aren't shared
+    int64 getTotalBytes(void) const;
+
+    var toVar(void) const;
+    String toJSON(void) const;
+
+    // One line per part, indented by depth, for DBG and the editor
+    String toString(void) const;
+
+private:
+    String name;
+    int64 bytes;
+    int count;
+    bool shared;
+
+    OwnedArray<BKMemoryReport> parts;
+
+    void appendTo(String& text, int depth) const;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BKMemoryReport)
+};
+
+class BKMemoryAccountable
+{
+public:
+    virtual ~BKMemoryAccountable(void) {}
+
+    // Adds what this owns to report. Message thread.
+    virtual void reportMemory(BKMemoryReport& report) const = 0;
+};
+
+
+#endif  // BKMEMORYREPORT_H_INCLUDED
@@ -13,23 +13,27 @@
 
 
 BKPianoSamplerSound::BKPianoSamplerSound (const String& soundName,
+                                          const File& soundFile,
                                           BKReferenceCountedBuffer::Ptr buffer,
-                                          uint64 soundLength,
-                                          double sourceSampleRate,
                                           const BigInteger& notes,
                                           const int rootMidiNote,
-                                          const BigInteger& velocities)
+                                          const BigInteger& velocities,
+                                          bool isResident)
 : name (soundName),
-data(buffer),
-sourceSampleRate(sourceSampleRate),
+file (soundFile),
+resident (isResident),
+sourceSampleRate(0.0),
 midiNotes (notes),
 midiVelocities(velocities),
-soundLength(soundLength),
-midiRootNote (rootMidiNote)
+soundLength(0),
+midiRootNote (rootMidiNote),
+rampOnSamples (0),
+rampOffSamples (0)
 {
-    rampOnSamples = roundToInt (aRampOnTimeSec* sourceSampleRate);
-    rampOffSamples = roundToInt (aRampOffTimeSec * sourceSampleRate);
+    velocityLow = jmax(0, midiVelocities.findNextSetBit(0));
+    velocityHigh = jmax(velocityLow, midiVelocities.getHighestBit());
     
+    setData(buffer);
 }
 
 BKPianoSamplerSound::~BKPianoSamplerSound()
@@ -51,6 +55,44 @@ bool BKPianoSamplerSound::appliesToChannel (int /*midiChannel*/)
     return true;
 }
 
+int BKPianoSamplerSound::getVelocityDistance (int midiNoteVelocity)
+{
+    if (midiNoteVelocity < velocityLow)     return velocityLow - midiNoteVelocity;
+    if (midiNoteVelocity > velocityHigh)    return midiNoteVelocity - velocityHigh;
+    return 0;
+}
+
+void BKPianoSamplerSound::setData (BKReferenceCountedBuffer::Ptr buffer)
+{
+    data = buffer;
+    
+    if (data == nullptr) return;
+    
+    sourceSampleRate = data->sampleRate;
+    soundLength = (uint64) data->getNumSamples();
+    
+    rampOnSamples = roundToInt (aRampOnTimeSec* sourceSampleRate);
+    rampOffSamples = roundToInt (aRampOffTimeSec * sourceSampleRate);
+}
+
+BKReferenceCountedBuffer::Ptr BKPianoSamplerSound::releaseData()
+{
+    BKReferenceCountedBuffer::Ptr buffer = data;
+    
+    data = nullptr;
+    
+    return buffer;
+}
+
+void BKPianoSamplerSound::requestReversed (int startPosition) noexcept
+{
+    // Round up, so a start that creeps later doesn't have the sample reversed again every time
+    const int needed = jmin((int) soundLength, (startPosition / reversedChunkSize + 1) * reversedChunkSize);
+    
+    // Only called from keyOn, under the synth's lock
+    if (needed > reversedRequest.get()) reversedRequest.set (needed);
+}
+
 
 //==============================================================================
 BKPianoSamplerVoice::BKPianoSamplerVoice(GeneralSettings::Ptr gen) :
@@ -61,7 +103,9 @@ lgain (0.0f), rgain (0.0f),
 rampOnOffLevel (0),
 rampOnDelta (0),
 rampOffDelta (0),
-isInRampOn (false), isInRampOff (false)
+isInRampOn (false), isInRampOff (false),
+window (2, compactWindowSize),
+windowStart (-compactWindowSize)
 {
     generalSettings = gen;
 }
@@ -86,7 +130,7 @@ void BKPianoSamplerVoice::startNote (const float midiNoteNumber,
                                      int voiceRampOff,
                                      BKSynthesiserSound* s)
 {
-    if (const BKPianoSamplerSound* const sound = dynamic_cast<const BKPianoSamplerSound*> (s))
+    if (BKPianoSamplerSound* const sound = dynamic_cast<BKPianoSamplerSound*> (s))
     {
         
         //DBG(sound->getName());
@@ -214,6 +258,12 @@ void BKPianoSamplerVoice::startNote (const float midiNoteNumber,
         lgain = gain;
         rgain = gain;
         
+        windowStart = -compactWindowSize;
+        
+#if REVERSED_SAMPLE_CACHE
+        if (playDirection == Reverse && sourceSamplePosition >= 0.0) sound->requestReversed ((int) sourceSamplePosition);
+#endif
+        
         isInRampOn = (voiceRampOn > 0);
         isInRampOff = false;
         
@@ -280,14 +330,34 @@ void BKPianoSamplerVoice::renderNextBlock (AudioSampleBuffer& outputBuffer, int
     if (const BKPianoSamplerSound* const playingSound = static_cast<BKPianoSamplerSound*> (getCurrentlyPlayingSound().get()))
     {
         
-        const float* const inL = playingSound->data->getAudioSampleBuffer()->getReadPointer (0);
-        const float* const inR = playingSound->data->getAudioSampleBuffer()->getNumChannels() > 1
-        ? playingSound->data->getAudioSampleBuffer()->getReadPointer (1) : nullptr;
+        const BKReferenceCountedBuffer& data = *playingSound->data;
+        const bool compact = data.isCompact();
+        
+        const float* inL = compact ? window.getReadPointer (0) : playingSound->data->getAudioSampleBuffer()->getReadPointer (0);
+        const float* inR = data.getNumChannels() > 1
+        ? (compact ? window.getReadPointer (1) : playingSound->data->getAudioSampleBuffer()->getReadPointer (1)) : nullptr;
+        
+#if REVERSED_SAMPLE_CACHE
+        // Reverse notes read forward through the reversed copy, once it reaches back to where they are
+        BKReferenceCountedBuffer* reversed = (playDirection == Reverse) ? playingSound->reversed.get() : nullptr;
+        const int reversedLength = playingSound->getReversedLength();
+        
+        if (reversed != nullptr && sourceSamplePosition > reversedLength - 1) reversed = nullptr;
+        
+        if (reversed != nullptr)
+        {
+            inL = reversed->getAudioSampleBuffer()->getReadPointer (0);
+            inR = reversed->getNumChannels() > 1 ? reversed->getAudioSampleBuffer()->getReadPointer (1) : nullptr;
+        }
+#endif
         
         
         float* outL = outputBuffer.getWritePointer (0, startSample);
         float* outR = outputBuffer.getNumChannels() > 1 ? outputBuffer.getWritePointer (1, startSample) : nullptr;
         
+        // Loudest sample written, for culling voices that can't be heard any more
+        float peak = 0.0f;
+        bool heard = false;
         
         while (--numSamples >= 0)
         {
@@ -307,13 +377,38 @@ void BKPianoSamplerVoice::renderNextBlock (AudioSampleBuffer& outputBuffer, int
                 continue;
             }
             
-            const int pos = (int) sourceSamplePosition;
-            const float alpha = (float) (sourceSamplePosition - pos);
+            int i = (int) sourceSamplePosition;
+            float alpha = (float) (sourceSamplePosition - i);
+            
+#if REVERSED_SAMPLE_CACHE
+            if (reversed != nullptr)
+            {
+                // The same position, mirrored; interpolating between the same two samples
+                const double mirrored = (reversedLength - 1) - sourceSamplePosition;
+                
+                i = (int) mirrored;
+                alpha = (float) (mirrored - i);
+                
+                // Ramping off past the start of the sample
+                if (i >= reversedLength)
+                {
+                    clearCurrentNote();
+                    break;
+                }
+            }
+            else
+#endif
+            if (compact)
+            {
+                if (i < windowStart || i + 1 >= windowStart + compactWindowSize) fillWindow (data, i);
+                i -= windowStart;
+            }
+            
             const float invAlpha = 1.0f - alpha;
             
             // just using a very simple linear interpolation here..
-            float l = (inL [pos] * invAlpha + inL [pos + 1] * alpha);
-            float r = (inR != nullptr) ? (inR [pos] * invAlpha + inR [pos + 1] * alpha) : l;
+            float l = (inL [i] * invAlpha + inL [i + 1] * alpha);
+            float r = (inR != nullptr) ? (inR [i] * invAlpha + inR [i + 1] * alpha) : l;
             
             l *= lgain;
             r *= rgain;
@@ -357,6 +452,9 @@ void BKPianoSamplerVoice::renderNextBlock (AudioSampleBuffer& outputBuffer, int
                 *outL++ += ((l + r) * 0.5f) * 1.0f;
             }
             
+            peak = jmax (peak, std::abs (l), std::abs (r));
+            heard = true;
+            
             if (playDirection == Forward)
             {
                 sourceSamplePosition += pitchRatio;
@@ -399,8 +497,20 @@ void BKPianoSamplerVoice::renderNextBlock (AudioSampleBuffer& outputBuffer, int
             
             
         }
+        
+        if (heard) noteOutputPeak (peak);
     }
     
 }
 
+void BKPianoSamplerVoice::fillWindow (const BKReferenceCountedBuffer& data, int pos)
+{
+    // Reverse notes read downwards, so keep pos near the top of the window
+    windowStart = (playDirection == Reverse) ? jmax(0, pos + 2 - compactWindowSize) : pos;
+    
+    for (int ch = 0; ch < data.getNumChannels(); ch++)
+    {
+        data.readFloat (ch, windowStart, window.getWritePointer (ch), compactWindowSize);
+    }
+}
 
@@ -22,14 +22,12 @@ class   BKPianoSamplerSound    : public BKSynthesiserSound
 {
 public:
     //==============================================================================
-    /** Creates a sampled sound from an audio reader.
-     
-     This will attempt to load the audio from the source into memory and store
-     it in this object.
+    /** Creates a sampled sound from a decoded buffer.
      
      @param name         a name for the sample
-     @param source       the audio to load. This object can be safely deleted by the
-     caller after this constructor returns
+     @param file         the file the buffer was decoded from
+     @param buffer       the decoded audio (see BKSampleBank). May be nullptr for a sound
+     that is loaded the first time it is played; see setData()
      @param midiNotes    the set of midi keys that this sound should be played on. This
      is used by the BKSynthesiserSound::appliesToNote() method
      @param rootMidiNote   the midi note at which the sample should be played
@@ -37,16 +35,15 @@ public:
      up or down relative to this one
      @param midiVelocities    the set of midi velocities that this sound should be played on. This
      is used by the BKSynthesiserSound::appliesToVelocity() method
-     @param maxSampleLengthSeconds   a maximum length of audio to read from the audio
-     source, in seconds
+     @param resident     false if the buffer may be released again when it hasn't been played for a while
      */
     BKPianoSamplerSound (const String& name,
+                         const File& file,
                          BKReferenceCountedBuffer::Ptr buffer,
-                         uint64 soundLength,
-                         double sourceSampleRate,
                          const BigInteger& midiNotes,
                          int rootMidiNote,
-                         const BigInteger& midiVelocities);
+                         const BigInteger& midiVelocities,
+                         bool resident = true);
     
     /** Destructor. */
     ~BKPianoSamplerSound();
@@ -66,13 +63,59 @@ public:
     bool appliesToVelocity (int midiNoteVelocity) override;
     bool appliesToChannel (int midiChannel) override;
     
+    bool isReady() override                                 { return data != nullptr; }
+    void requestData() override                             { requested.set (1); }
+    int getVelocityDistance (int midiNoteVelocity) override;
+    
+    //==============================================================================
+    // Loading on demand. Call setData() and releaseData() holding the synth's lock.
+    inline bool takeRequest() noexcept                      { return requested.compareAndSetBool (0, 1); }
+    void setData (BKReferenceCountedBuffer::Ptr buffer);
+    BKReferenceCountedBuffer::Ptr releaseData();
+    
+    inline BKReferenceCountedBuffer::Ptr getData() const noexcept   { return data; }
+    inline bool isResident() const noexcept                 { return resident; }
+    inline const File& getFile() const noexcept             { return file; }
+    
+    inline const BigInteger& getMidiNotes() const noexcept      { return midiNotes; }
+    inline const BigInteger& getMidiVelocities() const noexcept { return midiVelocities; }
+    inline int getRootMidiNote() const noexcept             { return midiRootNote; }
+    
+    //==============================================================================
+    // Reversed copies for reverse notes (REVERSED_SAMPLE_CACHE). A reverse note asks for the
+    // samples below where it starts; the loader reverses that much in the background.
+    void requestReversed (int startPosition) noexcept;
+    inline int getReversedRequest() const noexcept          { return reversedRequest.get(); }
+    inline void clearReversedRequest() noexcept             { reversedRequest.set (0); }
+    
+    // Call setReversed() holding the synth's lock.
+    inline void setReversed (BKReferenceCountedBuffer::Ptr buffer) noexcept { reversed = buffer; }
+    inline BKReferenceCountedBuffer::Ptr getReversed() const noexcept   { return reversed; }
+    
+    // How many samples from the start the reversed copy covers, 0 if there isn't one
+    inline int getReversedLength() const noexcept           { return (reversed != nullptr) ? reversed->getNumSamples() - 1 : 0; }
+    
+    enum { reversedChunkSize = 32768 };
+    
+    // The reversed copy is this instance's own; the samples are the sample bank's.
+    int64 getMemoryUsage() const override           { return sizeof (BKPianoSamplerSound) + ((reversed != nullptr) ? reversed->getMemoryUsage() : 0); }
+    int64 getSharedMemoryUsage() const override     { return (data != nullptr) ? data->getMemoryUsage() : 0; }
+    
 private:
     //==============================================================================
     friend class BKPianoSamplerVoice;
+    friend class BKPianoVoiceBatch;
     
     String name;
+    File file;
     
     BKReferenceCountedBuffer::Ptr data;
+    bool resident;
+    Atomic<int> requested;
+    int velocityLow, velocityHigh;
+    
+    BKReferenceCountedBuffer::Ptr reversed;
+    Atomic<int> reversedRequest;
     
     double sourceSampleRate;
     BigInteger midiNotes;
@@ -124,12 +167,17 @@ public:
                     ) override;
     
     void stopNote (float velocity, bool allowTailOff) override;
+    bool isTailingOff() const override              { return isInRampOff; }
+    bool isPlayingReverse() const override          { return playDirection == Reverse; }
+    bool isRampingOn() const override               { return isInRampOn; }
     
     void pitchWheelMoved (int newValue) override;
     void controllerMoved (int controllerNumber, int newValue) override;
     
     void renderNextBlock (AudioSampleBuffer&, int startSample, int numSamples) override;
     
+    int64 getMemoryUsage() const override           { return sizeof (BKPianoSamplerVoice) + (int64) window.getNumChannels() * window.getNumSamples() * (int64) sizeof (float); }
+    
     
     
     
@@ -150,6 +198,15 @@ private:
     float lgain, rgain, rampOnOffLevel, rampOnDelta, rampOffDelta;
     bool isInRampOn, isInRampOff;
     
+    // Compact samples are converted to float a window at a time, just ahead of where the note reads.
+    enum { compactWindowSize = 256 };
+    AudioSampleBuffer window;
+    int windowStart;
+    
+    void fillWindow (const BKReferenceCountedBuffer& data, int pos);
+    
+    friend class BKPianoVoiceBatch;
+    
     JUCE_LEAK_DETECTOR (BKPianoSamplerVoice)
 };
 
@@ -0,0 +1,322 @@
+/*
+  ==============================================================================
+
+    BKPianoVoiceBatch.cpp
+    Created: 19 Oct 2026 6:12:40pm
+    Author:
+
+  ==============================================================================
+*/
+
+#include "BKPianoVoiceBatch.h"
+
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define BK_SSE2 1
+#elif defined (__ARM_NEON__) || defined (__ARM_NEON)
+ #include <arm_neon.h>
+ #define BK_NEON 1
+#endif
+
+// Four floats, one per lane
+#if BK_SSE2
+typedef __m128 Lanes;
+
+static inline Lanes lanesLoad (const float* p) noexcept         { return _mm_loadu_ps (p); }
+static inline Lanes lanesFill (float f) noexcept                { return _mm_set1_ps (f); }
+static inline Lanes lanesAdd (Lanes a, Lanes b) noexcept        { return _mm_add_ps (a, b); }
+static inline Lanes lanesSub (Lanes a, Lanes b) noexcept        { return _mm_sub_ps (a, b); }
+static inline Lanes lanesMul (Lanes a, Lanes b) noexcept        { return _mm_mul_ps (a, b); }
+static inline Lanes lanesMax (Lanes a, Lanes b) noexcept        { return _mm_max_ps (a, b); }
+static inline Lanes lanesAbs (Lanes a) noexcept                 { return _mm_andnot_ps (_mm_set1_ps (-0.0f), a); }
+static inline void lanesStore (float* p, Lanes a) noexcept      { _mm_storeu_ps (p, a); }
+
+static inline float lanesSum (Lanes a) noexcept
+{
+    const __m128 swapped = _mm_shuffle_ps (a, a, _MM_SHUFFLE (2, 3, 0, 1));
+    const __m128 pairs = _mm_add_ps (a, swapped);
+
+    return _mm_cvtss_f32 (_mm_add_ss (pairs, _mm_movehl_ps (swapped, pairs)));
+}
+#elif BK_NEON
+typedef float32x4_t Lanes;
+
+static inline Lanes lanesLoad (const float* p) noexcept         { return vld1q_f32 (p); }
+static inline Lanes lanesFill (float f) noexcept                { return vdupq_n_f32 (f); }
+static inline Lanes lanesAdd (Lanes a, Lanes b) noexcept        { return vaddq_f32 (a, b); }
+static inline Lanes lanesSub (Lanes a, Lanes b) noexcept        { return vsubq_f32 (a, b); }
+static inline Lanes lanesMul (Lanes a, Lanes b) noexcept        { return vmulq_f32 (a, b); }
+static inline Lanes lanesMax (Lanes a, Lanes b) noexcept        { return vmaxq_f32 (a, b); }
+static inline Lanes lanesAbs (Lanes a) noexcept                 { return vabsq_f32 (a); }
+static inline void lanesStore (float* p, Lanes a) noexcept      { vst1q_f32 (p, a); }
+
+static inline float lanesSum (Lanes a) noexcept
+{
+    const float32x2_t pairs = vadd_f32 (vget_low_f32 (a), vget_high_f32 (a));
+
+    return vget_lane_f32 (vpadd_f32 (pairs, pairs), 0);
+}
+#else
+struct Lanes { float v[BKPianoVoiceBatch::numLanes]; };
+
+static inline Lanes lanesLoad (const float* p) noexcept         { Lanes r; for (int j = 0; j < 4; j++) r.v[j] = p[j]; return r; }
+static inline Lanes lanesFill (float f) noexcept                { Lanes r; for (int j = 0; j < 4; j++) r.v[j] = f; return r; }
+static inline Lanes lanesAdd (Lanes a, Lanes b) noexcept        { for (int j = 0; j < 4; j++) a.v[j] += b.v[j]; return a; }
+static inline Lanes lanesSub (Lanes a, Lanes b) noexcept        { for (int j = 0; j < 4; j++) a.v[j] -= b.v[j]; return a; }
+static inline Lanes lanesMul (Lanes a, Lanes b) noexcept        { for (int j = 0; j < 4; j++) a.v[j] *= b.v[j]; return a; }
+static inline Lanes lanesMax (Lanes a, Lanes b) noexcept        { for (int j = 0; j < 4; j++) a.v[j] = jmax (a.v[j], b.v[j]); return a; }
+static inline Lanes lanesAbs (Lanes a) noexcept                 { for (int j = 0; j < 4; j++) a.v[j] = std::abs (a.v[j]); return a; }
+static inline void lanesStore (float* p, Lanes a) noexcept      { for (int j = 0; j < 4; j++) p[j] = a.v[j]; }
+static inline float lanesSum (Lanes a) noexcept                 { return (a.v[0] + a.v[1]) + (a.v[2] + a.v[3]); }
+#endif
+
+BKPianoVoiceBatch::BKPianoVoiceBatch(void):
+capacity(0),
+numActive(0)
+{
+
+}
+
+BKPianoVoiceBatch::~BKPianoVoiceBatch(void)
+{
+
+}
+
+void BKPianoVoiceBatch::prepare(int numVoices)
+{
+    if (numVoices <= capacity) return;
+
+    // Whole groups of lanes, so the last group can be padded with silent ones
+    capacity = jmax(numVoices, capacity * 2);
+    capacity = ((capacity + numLanes - 1) / numLanes) * numLanes;
+
+    voice.allocate(capacity, true);
+    inL.allocate(capacity, true);
+    inR.allocate(capacity, true);
+    position.allocate(capacity, true);
+    step.allocate(capacity, true);
+    endPosition.allocate(capacity, true);
+    soundLength.allocate(capacity, true);
+    lgain.allocate(capacity, true);
+    rgain.allocate(capacity, true);
+    level.allocate(capacity, true);
+    onDelta.allocate(capacity, true);
+    offDelta.allocate(capacity, true);
+    ramp.allocate(capacity, true);
+    playing.allocate(capacity, true);
+    peak.allocate(capacity, true);
+    heard.allocate(capacity, true);
+}
+
+int64 BKPianoVoiceBatch::getMemoryUsage(void) const
+{
+    const size_t bytesPerLane = sizeof(BKPianoSamplerVoice*) + 2 * sizeof(const float*)
+                              + 4 * sizeof(double) + 6 * sizeof(float) + sizeof(int) + 2 * sizeof(bool);
+
+    return (int64) sizeof(BKPianoVoiceBatch) + (int64) capacity * (int64) bytesPerLane;
+}
+
+void BKPianoVoiceBatch::render(const OwnedArray<BKSynthesiserVoice>& voices, AudioSampleBuffer& buffer, int startSample, int numSamples)
+{
+    numActive = 0;
+
+    for (int i = voices.size(); --i >= 0;)
+    {
+        BKSynthesiserVoice* v = voices.getUnchecked(i);
+        BKPianoSamplerVoice* pianoVoice = dynamic_cast<BKPianoSamplerVoice*> (v);
+
+        if (pianoVoice == nullptr || numActive == capacity || !take(pianoVoice))
+            v->renderNextBlock(buffer, startSample, numSamples);
+    }
+
+    if (numActive == 0) return;
+
+    // Pad the last group with silent lanes
+    while (numActive % numLanes != 0)
+    {
+        voice[numActive] = nullptr;
+        playing[numActive] = false;
+        heard[numActive] = false;
+        numActive++;
+    }
+
+    float* outL = buffer.getWritePointer(0, startSample);
+    float* outR = buffer.getNumChannels() > 1 ? buffer.getWritePointer(1, startSample) : nullptr;
+
+    for (int first = 0; first < numActive; first += numLanes) renderLanes(first, outL, outR, numSamples);
+
+    for (int j = 0; j < numActive; j++) giveBack(j);
+}
+
+bool BKPianoVoiceBatch::take(BKPianoSamplerVoice* v)
+{
+    BKPianoSamplerSound* sound = static_cast<BKPianoSamplerSound*> (v->getCurrentlyPlayingSound().get());
+
+    // Not playing, nothing to render
+    if (sound == nullptr) return true;
+
+    if (sound->data == nullptr || sound->data->isCompact()) return false;
+
+    if (v->playDirection != Forward && v->playDirection != Reverse) return false;
+
+#if REVERSED_SAMPLE_CACHE
+    if (v->playDirection == Reverse && sound->reversed != nullptr) return false;
+#endif
+
+    AudioSampleBuffer* data = sound->data->getAudioSampleBuffer();
+
+    const int j = numActive++;
+
+    voice[j] = v;
+
+    // Mono samples play the same on both sides
+    inL[j] = data->getReadPointer(0);
+    inR[j] = (data->getNumChannels() > 1) ? data->getReadPointer(1) : inL[j];
+
+    position[j] = v->sourceSamplePosition;
+    step[j] = (v->playDirection == Reverse) ? -v->pitchRatio : v->pitchRatio;
+    endPosition[j] = v->playEndPosition;
+    soundLength[j] = (double) sound->soundLength;
+
+    lgain[j] = v->lgain;
+    rgain[j] = v->rgain;
+    level[j] = v->rampOnOffLevel;
+    onDelta[j] = v->rampOnDelta;
+    offDelta[j] = v->rampOffDelta;
+    ramp[j] = v->isInRampOn ? RampOn : (v->isInRampOff ? RampOff : RampNone);
+
+    playing[j] = true;
+    heard[j] = false;
+
+    return true;
+}
+
+void BKPianoVoiceBatch::giveBack(int lane)
+{
+    BKPianoSamplerVoice* v = voice[lane];
+
+    if (v == nullptr) return;
+
+    v->sourceSamplePosition = position[lane];
+    v->rampOnOffLevel = level[lane];
+    v->isInRampOn = (ramp[lane] == RampOn);
+    v->isInRampOff = (ramp[lane] == RampOff);
+
+    if (heard[lane]) v->noteOutputPeak(peak[lane]);
+
+    if (!playing[lane]) v->stopNote(0.0f, false);
+}
+
+void BKPianoVoiceBatch::renderLanes(int first, float* outL, float* outR, int numSamples)
+{
+    float a0L[numLanes], a1L[numLanes], a0R[numLanes], a1R[numLanes];
+    float alpha[numLanes], gainL[numLanes], gainR[numLanes];
+
+    const Lanes one = lanesFill(1.0f);
+
+    Lanes loudest = lanesFill(0.0f);
+
+    for (int s = 0; s < numSamples; s++)
+    {
+        // Read and step each lane on its own; the state logic matches BKPianoSamplerVoice::renderNextBlock
+        for (int j = 0; j < numLanes; j++)
+        {
+            const int v = first + j;
+
+            a0L[j] = a1L[j] = a0R[j] = a1R[j] = alpha[j] = gainL[j] = gainR[j] = 0.0f;
+
+            if (!playing[v]) continue;
+
+            const bool reverse = (step[v] < 0.0);
+
+            // Reverse notes that start past the end of the sample are silent until they reach it
+            if (reverse && position[v] > soundLength[v])
+            {
+                position[v] += step[v];
+                continue;
+            }
+
+            // Ramping off past the start of the sample
+            if (position[v] < 0.0)
+            {
+                playing[v] = false;
+                continue;
+            }
+
+            const int pos = (int) position[v];
+
+            heard[v] = true;
+
+            alpha[j] = (float) (position[v] - pos);
+
+            a0L[j] = inL[v][pos];
+            a1L[j] = inL[v][pos + 1];
+            a0R[j] = inR[v][pos];
+            a1R[j] = inR[v][pos + 1];
+
+            const float rampLevel = (ramp[v] == RampNone) ? 1.0f : level[v];
+
+            gainL[j] = lgain[v] * rampLevel;
+            gainR[j] = rgain[v] * rampLevel;
+
+            if (ramp[v] == RampOn)
+            {
+                level[v] += onDelta[v];
+
+                if (level[v] >= 1.0f)
+                {
+                    level[v] = 1.0f;
+                    ramp[v] = RampNone;
+                }
+            }
+            else if (ramp[v] == RampOff)
+            {
+                level[v] += offDelta[v];
+
+                // Ramped all the way off; this sample isn't played
+                if (level[v] <= 0.0f)
+                {
+                    gainL[j] = gainR[j] = 0.0f;
+                    playing[v] = false;
+                    continue;
+                }
+            }
+
+            position[v] += step[v];
+
+            if (!reverse)
+            {
+                if (ramp[v] != RampOff && position[v] >= endPosition[v]) ramp[v] = RampOff;
+
+                if (position[v] >= soundLength[v]) playing[v] = false;
+            }
+#if !CRAY_COOL_MUSIC_MAKER_2
+            else if (ramp[v] != RampOff && position[v] <= endPosition[v])
+            {
+                ramp[v] = RampOff;
+            }
+#endif
+        }
+
+        // Interpolate, apply gain and ramp, and sum the lanes
+        const Lanes a = lanesLoad(alpha);
+        const Lanes invA = lanesSub(one, a);
+
+        const Lanes l = lanesMul(lanesAdd(lanesMul(lanesLoad(a0L), invA), lanesMul(lanesLoad(a1L), a)), lanesLoad(gainL));
+        const Lanes r = lanesMul(lanesAdd(lanesMul(lanesLoad(a0R), invA), lanesMul(lanesLoad(a1R), a)), lanesLoad(gainR));
+
+        loudest = lanesMax(loudest, lanesMax(lanesAbs(l), lanesAbs(r)));
+
+        if (outR != nullptr)
+        {
+            outL[s] += lanesSum(l);
+            outR[s] += lanesSum(r);
+        }
+        else
+        {
+            outL[s] += (lanesSum(l) + lanesSum(r)) * 0.5f;
+        }
+    }
+
+    lanesStore(peak + first, loudest);
+}
@@ -0,0 +1,73 @@
+/*
+  ==============================================================================
+
+    BKPianoVoiceBatch.h
+    Created: 19 Oct 2026 6:12:40pm
+    Author:
+
+    Renders BKPianoSamplerVoices four at a time. Each block, the state of
+    the voices that are playing (position, step, gains, ramp) is copied into
+    arrays, one entry per lane, and the lanes are rendered together: samples
+    are read per lane, interpolation, gains and ramps are done in SIMD
+    registers, and the four lanes are summed into each output sample. The
+    state is copied back into the voices at the end of the block.
+
+    Voices playing compact samples or reading a reversed copy render
+    themselves as before.
+
+  ==============================================================================
+*/
+
+#ifndef BKPIANOVOICEBATCH_H_INCLUDED
+#define BKPIANOVOICEBATCH_H_INCLUDED
+
+#include "BKUtilities.h"
+
+#include "BKPianoSampler.h"
+
+class BKPianoVoiceBatch
+{
+public:
+    BKPianoVoiceBatch(void);
+    ~BKPianoVoiceBatch(void);
+
+    // Not on the audio thread. Makes room for numVoices lanes; voices past that render themselves.
+    void prepare(int numVoices);
+
+    // Audio thread, holding the synth's lock. Renders every voice, batched where it can.
+    void render(const OwnedArray<BKSynthesiserVoice>& voices, AudioSampleBuffer& buffer, int startSample, int numSamples);
+
+    // Bytes held for the lanes
+    int64 getMemoryUsage(void) const;
+
+    enum { numLanes = 4 };
+
+private:
+    enum RampState
+    {
+        RampNone = 0,
+        RampOn,
+        RampOff
+    };
+
+    int capacity;
+    int numActive;
+
+    HeapBlock<BKPianoSamplerVoice*> voice;
+    HeapBlock<const float*> inL, inR;
+    HeapBlock<double> position, step, endPosition, soundLength;
+    HeapBlock<float> lgain, rgain, level, onDelta, offDelta;
+    HeapBlock<int> ramp;
+    HeapBlock<bool> playing;
+    HeapBlock<float> peak;          // loudest output per lane, for culling
+    HeapBlock<bool> heard;
+
+    bool take(BKPianoSamplerVoice* v);
+    void giveBack(int lane);
+    void renderLanes(int first, float* outL, float* outR, int numSamples);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BKPianoVoiceBatch)
+};
+
+
+#endif  // BKPIANOVOICEBATCH_H_INCLUDED
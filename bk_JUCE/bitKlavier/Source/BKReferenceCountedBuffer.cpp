@@ -11,25 +11,207 @@
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "BKReferenceCountedBuffer.h"
 
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define BK_SSE2 1
+#elif defined (__ARM_NEON__) || defined (__ARM_NEON)
+ #include <arm_neon.h>
+ #define BK_NEON 1
+#endif
+
 //==============================================================================
 BKReferenceCountedBuffer::BKReferenceCountedBuffer (const String& nameToUse,
                                                 int numChannels,
                                                 int numSamples) :
 position (0),
 name (nameToUse),
-buffer (numChannels, numSamples)
+sampleRate (0.0),
+buffer (numChannels, numSamples),
+format (StoreFloat32),
+numChannels (numChannels),
+numSamples (numSamples),
+scale (1.0f)
 {
 
     //DBG (String ("Buffer named '") + name + "' constructed. numChannels = " + String (numChannels) + ", numSamples = " + String (numSamples));
     
 }
 
+BKReferenceCountedBuffer::BKReferenceCountedBuffer (const String& nameToUse,
+                                                int numChannels,
+                                                int numSamples,
+                                                StorageFormat storage) :
+position (0),
+name (nameToUse),
+sampleRate (0.0),
+format (storage),
+numChannels (numChannels),
+numSamples (numSamples),
+scale (1.0f)
+{
+    if (format == StoreFloat32)
+    {
+        buffer.setSize(numChannels, numSamples);
+    }
+    else
+    {
+        const size_t bytesPerSample = (format == StoreInt16) ? sizeof(int16) : sizeof(int32);
+        
+        compact.allocate((size_t) numChannels * numSamples * bytesPerSample, true);
+        
+        scale = (format == StoreInt16) ? (1.0f / 32768.0f) : (1.0f / 8388608.0f);
+    }
+}
+
 BKReferenceCountedBuffer::~BKReferenceCountedBuffer()
 {
     //DBG (String ("Buffer named '") + name + "' destroyed");
 }
 
+BKReferenceCountedBuffer* BKReferenceCountedBuffer::createCompact (const String& nameToUse,
+                                                                 AudioFormatReader& reader,
+                                                                 int numChannels,
+                                                                 int numSamples)
+{
+    if (reader.usesFloatingPointData)
+    {
+        // Nothing to gain, keep it as floats
+        ScopedPointer<BKReferenceCountedBuffer> newBuffer = new BKReferenceCountedBuffer(nameToUse, numChannels, numSamples);
+        
+        if (!reader.read(&newBuffer->buffer, 0, numSamples, 0, true, true)) return nullptr;
+        
+        return newBuffer.release();
+    }
+    
+    const StorageFormat storage = (reader.bitsPerSample <= 16) ? StoreInt16 : StoreInt24In32;
+    
+    ScopedPointer<BKReferenceCountedBuffer> newBuffer = new BKReferenceCountedBuffer(nameToUse, numChannels, numSamples, storage);
+    
+    // The reader gives integer samples left justified in 32 bits
+    const int chunkSize = 8192;
+    HeapBlock<int> chunk ((size_t) chunkSize * 2);
+    int* dest[2] = { chunk.getData(), chunk.getData() + chunkSize };
+    
+    for (int start = 0; start < numSamples; start += chunkSize)
+    {
+        const int num = jmin(chunkSize, numSamples - start);
+        
+        if (!reader.read(dest, numChannels, start, num, true)) return nullptr;
+        
+        for (int ch = 0; ch < numChannels; ch++)
+        {
+            const int* src = dest[ch];
+            
+            if (storage == StoreInt16)
+            {
+                int16* out = newBuffer->getCompactPointer<int16>(ch) + start;
+                for (int i = 0; i < num; i++) out[i] = (int16) (src[i] >> 16);
+            }
+            else
+            {
+                int32* out = newBuffer->getCompactPointer<int32>(ch) + start;
+                for (int i = 0; i < num; i++) out[i] = src[i] >> 8;
+            }
+        }
+    }
+    
+    return newBuffer.release();
+}
+
+BKReferenceCountedBuffer* BKReferenceCountedBuffer::createReversed (const BKReferenceCountedBuffer& source,
+                                                                   int numSamples)
+{
+    numSamples = jmin(numSamples, source.getNumSamples());
+    
+    if (numSamples <= 0) return nullptr;
+    
+    BKReferenceCountedBuffer* newBuffer = new BKReferenceCountedBuffer(source.name, source.getNumChannels(), numSamples + 1);
+    newBuffer->sampleRate = source.sampleRate;
+    
+    for (int ch = 0; ch < source.getNumChannels(); ch++)
+    {
+        float* dest = newBuffer->buffer.getWritePointer(ch);
+        
+        source.readFloat(ch, 0, dest, numSamples);
+        std::reverse(dest, dest + numSamples);
+        
+        dest[numSamples] = 0.0f;
+    }
+    
+    return newBuffer;
+}
+
 AudioSampleBuffer* BKReferenceCountedBuffer::getAudioSampleBuffer()
 {
+    jassert(format == StoreFloat32);
+    
     return &buffer;
 }
+
+static void convertInt16ToFloat (const int16* src, float* dest, float multiplier, int num) noexcept
+{
+    int i = 0;
+    
+#if BK_SSE2
+    const __m128 mult = _mm_set1_ps(multiplier);
+    
+    for (; i + 8 <= num; i += 8)
+    {
+        const __m128i s = _mm_loadu_si128((const __m128i*) (src + i));
+        
+        // sign extend each half to 32 bits
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+        
+        _mm_storeu_ps(dest + i,     _mm_mul_ps(_mm_cvtepi32_ps(lo), mult));
+        _mm_storeu_ps(dest + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), mult));
+    }
+#elif BK_NEON
+    for (; i + 8 <= num; i += 8)
+    {
+        const int16x8_t s = vld1q_s16(src + i);
+        
+        vst1q_f32(dest + i,     vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(s))),  multiplier));
+        vst1q_f32(dest + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(s))), multiplier));
+    }
+#endif
+    
+    for (; i < num; i++) dest[i] = src[i] * multiplier;
+}
+
+void BKReferenceCountedBuffer::readFloat (int channel, int start, float* dest, int num) const
+{
+    // Zero whatever falls outside the buffer
+    if (start < 0)
+    {
+        const int before = jmin(num, -start);
+        FloatVectorOperations::clear(dest, before);
+        dest += before; num -= before; start = 0;
+    }
+    
+    const int available = jlimit(0, num, numSamples - start);
+    
+    if (available < num) FloatVectorOperations::clear(dest + available, num - available);
+    
+    if (available <= 0) return;
+    
+    if (format == StoreFloat32)
+    {
+        FloatVectorOperations::copy(dest, buffer.getReadPointer(channel, start), available);
+    }
+    else if (format == StoreInt16)
+    {
+        convertInt16ToFloat(getCompactPointer<int16>(channel) + start, dest, scale, available);
+    }
+    else
+    {
+        FloatVectorOperations::convertFixedToFloat(dest, getCompactPointer<int32>(channel) + start, scale, available);
+    }
+}
+
+int64 BKReferenceCountedBuffer::getMemoryUsage(void) const
+{
+    const int64 bytesPerSample = (format == StoreInt16) ? sizeof(int16) : (format == StoreInt24In32) ? sizeof(int32) : sizeof(float);
+    
+    return (int64) numChannels * numSamples * bytesPerSample;
+}
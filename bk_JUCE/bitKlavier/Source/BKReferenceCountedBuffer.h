@@ -16,26 +16,77 @@
 //==============================================================================
 /*
  Adapted from advanced looping tutorial.
+ 
+ Samples are kept either as floats or, compacted, as the integer PCM they were
+ decoded from (16 bit, or 24 bit held in 32) plus one scale back to -1..1.
+ Compacted samples take half the memory of float ones (for 16 bit sources);
+ voices read them through readFloat().
  */
 class BKReferenceCountedBuffer    : public ReferenceCountedObject
 {
 public:
     typedef ReferenceCountedObjectPtr<BKReferenceCountedBuffer> Ptr;
     
+    enum StorageFormat
+    {
+        StoreFloat32 = 0,
+        StoreInt16,
+        StoreInt24In32
+    };
+    
     BKReferenceCountedBuffer (const String& nameToUse,
                             int numChannels,
                             int numSamples);
+    
+    BKReferenceCountedBuffer (const String& nameToUse,
+                            int numChannels,
+                            int numSamples,
+                            StorageFormat format);
     ~BKReferenceCountedBuffer();
     
+    // Decodes numSamples from reader, compacted if the source is integer PCM. Returns nullptr if it can't read.
+    static BKReferenceCountedBuffer* createCompact (const String& nameToUse,
+                                                    AudioFormatReader& reader,
+                                                    int numChannels,
+                                                    int numSamples);
+    
+    // The first numSamples of source back to front, as floats, with one 0 after them for interpolation.
+    static BKReferenceCountedBuffer* createReversed (const BKReferenceCountedBuffer& source,
+                                                     int numSamples);
+    
+    // Float storage only.
     AudioSampleBuffer* getAudioSampleBuffer();
-
+    
+    inline StorageFormat getFormat(void) const noexcept { return format; }
+    inline bool isCompact(void) const noexcept { return format != StoreFloat32; }
+    inline int getNumChannels(void) const noexcept { return numChannels; }
+    inline int getNumSamples(void) const noexcept { return numSamples; }
+    inline float getScale(void) const noexcept { return scale; }
+    
+    // Copies num samples from start into dest as floats; anything outside the buffer reads as 0.
+    void readFloat (int channel, int start, float* dest, int num) const;
+    
+    int64 getMemoryUsage(void) const;
+    
     int position;
     String name;
+    double sampleRate;  // of the source file
     
 private:
     
     AudioSampleBuffer buffer;
     
+    StorageFormat format;
+    int numChannels, numSamples;
+    float scale;
+    HeapBlock<char> compact;
+    
+    template <typename Type>
+    inline Type* getCompactPointer(int channel) const noexcept
+    {
+        return reinterpret_cast<Type*> (compact.getData()) + (size_t) channel * numSamples;
+    }
+    
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BKReferenceCountedBuffer)
 };
 
@@ -0,0 +1,186 @@
+/*
+  ==============================================================================
+
+    BKSampleBank.cpp
+    Created: 19 Oct 2026 3:48:22pm
+    Author:
+
+  ==============================================================================
+*/
+
+#include "BKSampleBank.h"
+
+BKSampleBank::BKSampleBank(void)
+{
+
+}
+
+BKSampleBank::~BKSampleBank(void)
+{
+
+}
+
+BKReferenceCountedBuffer::Ptr BKSampleBank::findBuffer(const File& file)
+{
+    const ScopedLock sl (lock);
+
+    return buffers[file.getFullPathName()];
+}
+
+BKReferenceCountedBuffer::Ptr BKSampleBank::getBuffer(const File& file)
+{
+    BKReferenceCountedBuffer::Ptr buffer = findBuffer(file);
+
+    if (buffer != nullptr) return buffer;
+
+    const ScopedLock dl (decodeLock);
+
+    // Another instance may have decoded it while we waited
+    buffer = findBuffer(file);
+
+    if (buffer != nullptr) return buffer;
+
+    buffer = decode(file);
+
+    if (buffer != nullptr)
+    {
+        const ScopedLock sl (lock);
+
+        buffers.set(file.getFullPathName(), buffer);
+    }
+
+    return buffer;
+}
+
+BKReferenceCountedBuffer::Ptr BKSampleBank::getTestTone(int root)
+{
+    // Kept with the decoded files, so instances share them and removeUnused() drops them the same way
+    const String key = "test tone " + String(root);
+    
+    const ScopedLock dl (decodeLock);
+    
+    BKReferenceCountedBuffer::Ptr buffer;
+    
+    {
+        const ScopedLock sl (lock);
+        
+        buffer = buffers[key];
+    }
+    
+    if (buffer != nullptr) return buffer;
+    
+    buffer = makeTestTone(root);
+    
+    const ScopedLock sl (lock);
+    
+    buffers.set(key, buffer);
+    
+    return buffer;
+}
+
+void BKSampleBank::removeUnused(void)
+{
+    // Release outside the lock; freeing big buffers takes a while
+    ReferenceCountedArray<BKReferenceCountedBuffer> unused;
+
+    {
+        const ScopedLock sl (lock);
+
+        StringArray keys;
+
+        for (HashMap<String, BKReferenceCountedBuffer::Ptr>::Iterator i (buffers); i.next();)
+        {
+            // Only the bank points to it
+            if (i.getValue()->getReferenceCount() == 1) keys.add(i.getKey());
+        }
+
+        for (int i = 0; i < keys.size(); i++)
+        {
+            unused.add(buffers[keys[i]]);
+            buffers.remove(keys[i]);
+        }
+    }
+
+    if (unused.size() > 0) DBG("released " + String(unused.size()) + " unused sample buffers");
+}
+
+int BKSampleBank::getNumBuffers(void) const
+{
+    const ScopedLock sl (lock);
+
+    return buffers.size();
+}
+
+int64 BKSampleBank::getMemoryUsage(void) const
+{
+    const ScopedLock sl (lock);
+
+    int64 bytes = 0;
+
+    for (HashMap<String, BKReferenceCountedBuffer::Ptr>::Iterator i (buffers); i.next();)
+    {
+        bytes += i.getValue()->getMemoryUsage();
+    }
+
+    return bytes;
+}
+
+BKReferenceCountedBuffer* BKSampleBank::decode(const File& file)
+{
+    WavAudioFormat wavFormat;
+
+    ScopedPointer<AudioFormatReader> sampleReader = wavFormat.createReaderFor(new FileInputStream(file), true);
+
+    if (sampleReader == nullptr) return nullptr;
+
+    double sourceSampleRate = sampleReader->sampleRate;
+    const int numChannels = sampleReader->numChannels;
+
+    if (sourceSampleRate <= 0 || sampleReader->lengthInSamples <= 0) return nullptr;
+
+    uint64 maxLength = jmin((uint64)sampleReader->lengthInSamples, (uint64) (aMaxSampleLengthSec * sourceSampleRate));
+
+#if COMPACT_SAMPLE_STORAGE
+    BKReferenceCountedBuffer* newBuffer = BKReferenceCountedBuffer::createCompact(file.getFileName(), *sampleReader, jmin(2, numChannels), (int)maxLength);
+
+    if (newBuffer == nullptr) return nullptr;
+#else
+    BKReferenceCountedBuffer* newBuffer = new BKReferenceCountedBuffer(file.getFileName(),jmin(2, numChannels),(int)maxLength);
+    sampleReader->read(newBuffer->getAudioSampleBuffer(), 0, (int)maxLength, 0, true, true);
+#endif
+
+    newBuffer->sampleRate = sourceSampleRate;
+
+    return newBuffer;
+}
+
+BKReferenceCountedBuffer* BKSampleBank::makeTestTone(int root)
+{
+    const double sampleRate = 44100.0;
+    const int numSamples = (int) (3.0 * sampleRate);
+    
+    const double frequency = 440.0 * std::pow(2.0, (root - 69) / 12.0);
+    
+    BKReferenceCountedBuffer* tone = new BKReferenceCountedBuffer("test tone " + String(root), 1, numSamples);
+    float* data = tone->getAudioSampleBuffer()->getWritePointer(0);
+    
+    for (int i = 0; i < numSamples; i++)
+    {
+        const double t = i / sampleRate;
+        
+        double sample = 0.0;
+        
+        // Higher harmonics die away faster, and none past Nyquist
+        for (int h = 1; h <= 4 && frequency * h < sampleRate * 0.5; h++)
+        {
+            sample += std::sin(2.0 * double_Pi * frequency * h * t) * std::exp(-1.5 * h * t) / h;
+        }
+        
+        // 5 ms attack, so it doesn't click
+        data[i] = (float) (0.25 * sample * jmin(1.0, t / 0.005));
+    }
+    
+    tone->sampleRate = sampleRate;
+    
+    return tone;
+}
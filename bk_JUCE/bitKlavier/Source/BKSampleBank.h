@@ -0,0 +1,59 @@
+/*
+  ==============================================================================
+
+    BKSampleBank.h
+    Created: 19 Oct 2026 3:48:22pm
+    Author:
+
+    Decoded piano samples, shared by every bitKlavier instance in the process.
+    Buffers are kept per sample file. The first instance to ask for a file
+    decodes it; the others get the same buffer and only build their own
+    sounds around it, so they load at once and add almost no sample memory.
+    Buffers are never written to once decoded.
+
+    A buffer stays in the bank for as long as some instance's sounds hold it.
+    Each instance keeps its own synths and voices.
+
+  ==============================================================================
+*/
+
+#ifndef BKSAMPLEBANK_H_INCLUDED
+#define BKSAMPLEBANK_H_INCLUDED
+
+#include "BKUtilities.h"
+
+// Use through SharedResourcePointer<BKSampleBank>; the bank lives while any instance does.
+class BKSampleBank
+{
+public:
+    BKSampleBank(void);
+    ~BKSampleBank(void);
+
+    // Samples of file, decoded now if no instance has them yet. nullptr if the file can't be read.
+    BKReferenceCountedBuffer::Ptr getBuffer(const File& file);
+
+    // Samples of file only if some instance already decoded them.
+    BKReferenceCountedBuffer::Ptr findBuffer(const File& file);
+
+    // A tone at root made in code: a few harmonics dying away, the same on every machine. See BKLoadTest.
+    BKReferenceCountedBuffer::Ptr getTestTone(int root);
+    
+    // Drops the buffers that no instance holds any more.
+    void removeUnused(void);
+
+    int getNumBuffers(void) const;
+    int64 getMemoryUsage(void) const;
+
+private:
+    CriticalSection lock;           // guards buffers
+    CriticalSection decodeLock;     // one file decoded at a time, so no file is ever decoded twice
+    HashMap<String, BKReferenceCountedBuffer::Ptr> buffers;
+
+    static BKReferenceCountedBuffer* decode(const File& file);
+    static BKReferenceCountedBuffer* makeTestTone(int root);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BKSampleBank)
+};
+
+
+#endif  // BKSAMPLEBANK_H_INCLUDED
@@ -19,38 +19,100 @@ String notes[4] = {"A","C","D#","F#"};
 
 #define EXIT_CHECK if (threadShouldExit()) { processor.updateState->pianoSamplesAreLoading = false; return; }
 
-void BKSampleLoader::run(void)
+void BKSampleLoader::reportMemory(BKMemoryReport& report) const
 {
-    BKSampleLoadType type = processor.currentSampleType;
-    
-    processor.updateState->pianoSamplesAreLoading = true;
-    
-    EXIT_CHECK;
+    const BKSampleLoadType type = loadedType;
     
-    loadMainPianoSamples(type);
+    String name = "sample bank (" + (type != BKLoadNil ? String(cBKSampleLoadTypes[type]) : String("nothing loaded"));
     
-    EXIT_CHECK;
+    // Every instance reports the whole bank
+    const int numInstances = processor.sampleBank.getReferenceCount();
+    if (numInstances > 1) name << ", shared by " << numInstances << " instances";
     
-    processor.didLoadMainPianoSamples = true;
+    name << ")";
     
-    if (!processor.didLoadHammersAndRes && type == BKLoadHeavy)
+    report.add(name, processor.sampleBank->getMemoryUsage(), processor.sampleBank->getNumBuffers());
+}
+
+void BKSampleLoader::run(void)
+{
+    // Runs until the processor goes away; loadPianoSamples() wakes it up when the load type changes.
+    while (!threadShouldExit())
     {
-        processor.didLoadHammersAndRes = true;
-        loadHammerReleaseSamples();
+        BKSampleLoadType type = processor.currentSampleType;
         
-        EXIT_CHECK;
+        if (type != loadedType)
+        {
+            // Only the first load blocks the UI; after that the old samples keep playing until the new ones are in
+            if (loadedType == BKLoadNil) processor.updateState->pianoSamplesAreLoading = true;
+            
+            loadMainPianoSamples(type);
+            
+            EXIT_CHECK;
+            
+            loadedType = type;
+            processor.didLoadMainPianoSamples = true;
+            
+            if (!processor.didLoadHammersAndRes && type == BKLoadHeavy)
+            {
+                processor.didLoadHammersAndRes = true;
+                loadHammerReleaseSamples();
+                
+                EXIT_CHECK;
+                
+                loadResonanceReleaseSamples();
+            }
+            else if (processor.didLoadHammersAndRes && type != BKLoadHeavy)
+            {
+                processor.didLoadHammersAndRes = false;
+                
+                ReferenceCountedArray<BKSynthesiserSound> none;
+                
+                processor.mainPianoSynth.setSounds(none, HammerSoundSet);
+                none.clear();
+                
+                processor.mainPianoSynth.setSounds(none, ResonanceSoundSet);
+                none.clear();
+            }
+            
+            // Whatever the last load type used that this one doesn't
+            processor.sampleBank->removeUnused();
+            
+#if BENCHMARK_SAMPLE_STORAGE
+            DBG(benchmarkSampleStorage());
+#endif
+            
+#if BENCHMARK_REVERSED_SAMPLES
+            DBG(benchmarkReversedSamples());
+#endif
+            
+#if BENCHMARK_VOICE_ENGINE
+            DBG(benchmarkVoiceEngine());
+#endif
+            
+            processor.updateState->pianoSamplesAreLoading = false;
+        }
+        
+#if LAZY_SAMPLE_LOADING
+        loadRequestedSamples();
+        
+        releaseUnplayedSamples();
+#endif
         
-        loadResonanceReleaseSamples();
+#if REVERSED_SAMPLE_CACHE
+        reverseRequestedSamples();
+#endif
+        
+        growVoicePools();
+        
+        reportDroppedVoices();
+        
+        wait(20);
     }
-    
-    processor.updateState->pianoSamplesAreLoading = false;
 }
 
-void BKSampleLoader::loadMainPianoSamples(BKSampleLoadType type)
+File BKSampleLoader::getSamplesFolder(void)
 {
-    WavAudioFormat wavFormat;
-    BKSynthesiser* synth = &processor.mainPianoSynth;
-    
     File bkSamples;
     
 #if JUCE_IOS
@@ -59,19 +121,30 @@ void BKSampleLoader::loadMainPianoSamples(BKSampleLoadType type)
     bkSamples = bkSamples.getSpecialLocation(File::userDocumentsDirectory).getChildFile("bitKlavier resources").getChildFile("samples");
 #endif
     
+    return bkSamples;
+}
+
+void BKSampleLoader::loadMainPianoSamples(BKSampleLoadType type)
+{
+    BKSynthesiser* synth = &processor.mainPianoSynth;
+    
+    File bkSamples = getSamplesFolder();
+    
     int numLayers = 0;
     
     if      (type == BKLoadLitest)      numLayers = 1;
+    else if (type == BKLoadTest)        numLayers = 1;
     else if (type == BKLoadLite)        numLayers = 2;
     else if (type == BKLoadMedium)      numLayers = 4;
     else if (type == BKLoadHeavy)       numLayers = 8;
     
-    synth->clearVoices();
-    synth->clearSounds();
-    
-    // 88 or more seems to work well
-    for (int i = 0; i < 300; i++)   synth->addVoice(new BKPianoSamplerVoice(synth->generalSettings));
+    // Voices from an earlier load type are kept, and may still be playing its sounds.
+    // Past the floor, the pool grows as it's used (see growVoicePools)
+    for (int i = synth->getNumVoices(); i < synth->getVoicePoolMinimum(); i++)   synth->addVoice(new BKPianoSamplerVoice(synth->generalSettings));
     
+    // Built on the side and swapped in at once. Layers the last load type also used are still
+    // held by its sounds, so the bank hands them back without decoding them again.
+    ReferenceCountedArray<BKSynthesiserSound> sounds;
     
     for (int i = 0; i < 8; i++) {
         for (int j = 0; j < 4; j++) {
@@ -110,12 +183,11 @@ void BKSampleLoader::loadMainPianoSamples(BKSampleLoadType type)
                 
                 FileInputStream inputStream(file);
                 
-                if (inputStream.openedOk())
+                // Test tones are made for the same notes and ranges as the very light set, without its files
+                if (type == BKLoadTest || inputStream.openedOk())
                 {
                     String soundName = file.getFileName();
                     
-                    sampleReader = wavFormat.createReaderFor(new FileInputStream(file), true);
-                    
                     BigInteger noteRange;
                     
                     int root = 0;
@@ -158,29 +230,22 @@ void BKSampleLoader::loadMainPianoSamples(BKSampleLoadType type)
                         velocityRange.setRange(aVelocityThresh_One[k], (aVelocityThresh_One[k+1] - aVelocityThresh_One[k]), true);
                     }
                     
-                    double sourceSampleRate = sampleReader->sampleRate;
-                    const int numChannels = sampleReader->numChannels;
-                    uint64 maxLength;
-                    
-                    if (sourceSampleRate <= 0 || sampleReader->lengthInSamples <= 0) {
-                        maxLength = 0;
-                        
-                    } else {
-                        maxLength = jmin((uint64)sampleReader->lengthInSamples, (uint64) (aMaxSampleLengthSec * sourceSampleRate));
-                        
-                        BKReferenceCountedBuffer::Ptr newBuffer = new BKReferenceCountedBuffer(file.getFileName(),jmin(2, numChannels),(int)maxLength);
-                        sampleReader->read(newBuffer->getAudioSampleBuffer(), 0, (int)sampleReader->lengthInSamples, 0, true, true);
+                    if (type == BKLoadTest)
+                    {
+                        soundName = "test tone " + String(root);
                         
-                        synth->addSound(new BKPianoSamplerSound(soundName,
-                                                                        newBuffer,
-                                                                        maxLength,
-                                                                        sourceSampleRate,
-                                                                        noteRange,
-                                                                        root,
-                                                                        velocityRange));
+                        sounds.add(new BKPianoSamplerSound(soundName, File(), processor.sampleBank->getTestTone(root),
+                                                           noteRange, root, velocityRange, true));
+                    }
+                    else
+                    {
+#if LAZY_SAMPLE_LOADING
+                        // The softest layer of every note now, the others when they are first played
+                        addSample(sounds, file, noteRange, root, velocityRange, k == 0);
+#else
+                        addSample(sounds, file, noteRange, root, velocityRange, true);
+#endif
                     }
-                    
-                    
                     
                     processor.progress += processor.progressInc;
                     DBG(soundName+": " + String(processor.progress));
@@ -195,26 +260,23 @@ void BKSampleLoader::loadMainPianoSamples(BKSampleLoadType type)
             
         }
     }
+    
+    if (threadShouldExit()) return;
+    
+    // The old sounds come back in sounds and are released here, outside the synth lock
+    synth->setSounds(sounds);
+    sounds.clear();
 }
 
 void BKSampleLoader::loadResonanceReleaseSamples(void)
 {
-    WavAudioFormat wavFormat;
-    BKSynthesiser* synth = &processor.resonanceReleaseSynth;
+    // Played on the main piano's voices
+    BKSynthesiser* synth = &processor.mainPianoSynth;
     
-    File bkSamples;
+    File bkSamples = getSamplesFolder();
     
-#if JUCE_IOS
-    bkSamples = bkSamples.getSpecialLocation(File::invokedExecutableFile).getParentDirectory().getChildFile("samples");
-#else
-    bkSamples = bkSamples.getSpecialLocation(File::userDocumentsDirectory).getChildFile("bitKlavier resources").getChildFile("samples");
-#endif
-    
-    synth->clearVoices();
-    synth->clearSounds();
+    ReferenceCountedArray<BKSynthesiserSound> sounds;
     
-    for (int i = 0; i < 88; i++)    synth->addVoice(new BKPianoSamplerVoice(synth->generalSettings));
-
     //load release resonance samples
     for (int i = 0; i < 7; i++) {       //i => octave
         for (int j = 0; j < 4; j++) {   //j => note name
@@ -239,7 +301,6 @@ void BKSampleLoader::loadResonanceReleaseSamples(void)
                 
                 if (inputStream.openedOk()) {
                     String soundName = file.getFileName();
-                    sampleReader = wavFormat.createReaderFor(new FileInputStream(file), true);
                     
                     //keymap assignment
                     BigInteger noteRange;
@@ -270,30 +331,7 @@ void BKSampleLoader::loadResonanceReleaseSamples(void)
                     velocityRange.setRange(aResonanceVelocityThresh[k], (aResonanceVelocityThresh[k+1] - aResonanceVelocityThresh[k]), true);
                     
                     //load the sample, add to synth
-                    double sourceSampleRate = sampleReader->sampleRate;
-                    const int numChannels = sampleReader->numChannels;
-                    uint64 maxLength;
-                    
-                    if (sourceSampleRate <= 0 || sampleReader->lengthInSamples <= 0)
-                    {
-                        maxLength = 0;
-                    }
-                    else
-                    {
-                        maxLength = jmin((uint64)sampleReader->lengthInSamples, (uint64) (aMaxSampleLengthSec * sourceSampleRate));
-                        
-                        BKReferenceCountedBuffer::Ptr newBuffer = new BKReferenceCountedBuffer(file.getFileName(),jmin(2, numChannels), (int)maxLength);
-                        sampleReader->read(newBuffer->getAudioSampleBuffer(), 0, (int)sampleReader->lengthInSamples, 0, true, true);
-                        
-                        //DBG("added resonance: " + String(noteRange.toInteger()) + " " + String(root) + " " + String(velocityRange.toInteger()) );
-                        synth->addSound(new BKPianoSamplerSound(soundName,
-                                                                               newBuffer,
-                                                                               maxLength,
-                                                                               sourceSampleRate,
-                                                                               noteRange,
-                                                                               root,
-                                                                               velocityRange));
-                    }
+                    addSample(sounds, file, noteRange, root, velocityRange, true);
                     
                     processor.progress += processor.progressInc;
                     DBG(soundName+": " + String(processor.progress));
@@ -305,24 +343,19 @@ void BKSampleLoader::loadResonanceReleaseSamples(void)
             }
         }
     }
+    
+    synth->setSounds(sounds, ResonanceSoundSet);
+    sounds.clear();
 }
 
 void BKSampleLoader::loadHammerReleaseSamples(void)
 {
-    WavAudioFormat wavFormat;
-    BKSynthesiser* synth = &processor.hammerReleaseSynth;
-    File bkSamples;
-    
-#if JUCE_IOS
-    bkSamples = bkSamples.getSpecialLocation(File::invokedExecutableFile).getParentDirectory().getChildFile("samples");
-#else
-    bkSamples = bkSamples.getSpecialLocation(File::userDocumentsDirectory).getChildFile("bitKlavier resources").getChildFile("samples");
-#endif
+    // Played on the main piano's voices
+    BKSynthesiser* synth = &processor.mainPianoSynth;
     
-    synth->clearVoices();
-    synth->clearSounds();
+    File bkSamples = getSamplesFolder();
     
-    for (int i = 0; i < 88; i++)    synth->addVoice(new BKPianoSamplerVoice(synth->generalSettings));
+    ReferenceCountedArray<BKSynthesiserSound> sounds;
     
     //load hammer release samples
     for (int i = 1; i <= 88; i++) {
@@ -338,7 +371,6 @@ void BKSampleLoader::loadHammerReleaseSamples(void)
         
         if (inputStream.openedOk()) {
             String soundName = file.getFileName();
-            sampleReader = wavFormat.createReaderFor(new FileInputStream(file), true);
             
             BigInteger noteRange;
             noteRange.setRange(20 + i, 1, true);
@@ -348,34 +380,533 @@ void BKSampleLoader::loadHammerReleaseSamples(void)
             
             int root = 20 + i;
             
-            double sourceSampleRate = sampleReader->sampleRate;
-            const int numChannels = sampleReader->numChannels;
-            uint64 maxLength;
+            addSample(sounds, file, noteRange, root, velocityRange, true);
+            processor.progress += processor.progressInc;
+            DBG(soundName+": " + String(processor.progress));
+        }
+        else
+        {
+            DBG("file not opened OK: " + temp);
+        }
+    }
+    
+    synth->setSounds(sounds, HammerSoundSet);
+    sounds.clear();
+}
+
+void BKSampleLoader::growVoicePools(void)
+{
+    BKSynthesiser* synth = &processor.mainPianoSynth;
+    
+    // Not loaded yet
+    if (synth->getNumVoices() == 0) return;
+    
+    const int wanted = synth->getNumVoicesWanted();
+    
+    if (wanted <= 0) return;
+    
+    // Made here so the audio thread only has to pick them up
+    for (int i = 0; i < wanted; i++)
+    {
+        BKPianoSamplerVoice* voice = new BKPianoSamplerVoice(synth->generalSettings);
+        
+        if (!synth->queueVoice(voice))
+        {
+            delete voice;
+            break;
+        }
+    }
+    
+    DBG("voice pool: " + String(synth->getNumVoices()) + " + " + String(wanted)
+        + " voices, peak use " + String(synth->getPeakVoiceUsage()));
+}
+
+void BKSampleLoader::reportDroppedVoices(void)
+{
+    const int dropped = processor.getNumDroppedVoices();
+    const int late = processor.getNumLateVoiceRenders();
+    const int droppedMidi = processor.getNumDroppedMidiEvents();
+    
+    if (droppedMidi != reportedDroppedMidi)
+    {
+        DBG("deferred MIDI: dropped " + String(droppedMidi - reportedDroppedMidi) + " events held over while a piano was reconfigured, "
+            + String(droppedMidi) + " in all");
+        
+        reportedDroppedMidi = droppedMidi;
+    }
+    
+    if (late != reportedLateRenders)
+    {
+        DBG("render pool: " + String(late - reportedLateRenders) + " blocks went out without a late worker's voices, "
+            + String(late) + " in all");
+        
+        reportedLateRenders = late;
+    }
+    
+    if (dropped == reportedDroppedVoices) return;
+    
+    DBG("render budget: dropped " + String(dropped - reportedDroppedVoices) + " voices, "
+        + String(dropped) + " in all, " + String(processor.getNumCulledVoices()) + " culled for being quiet");
+    
+    reportedDroppedVoices = dropped;
+}
+
+void BKSampleLoader::addSample(ReferenceCountedArray<BKSynthesiserSound>& sounds, const File& file,
+                               const BigInteger& noteRange, int root, const BigInteger& velocityRange, bool loadNow)
+{
+    // Decoded by the bank, unless another instance already did
+    BKReferenceCountedBuffer::Ptr buffer = loadNow ? processor.sampleBank->getBuffer(file) : processor.sampleBank->findBuffer(file);
+    
+    if (loadNow && buffer == nullptr) return;
+    
+    sounds.add(new BKPianoSamplerSound(file.getFileName(),
+                                       file,
+                                       buffer,
+                                       noteRange,
+                                       root,
+                                       velocityRange,
+                                       loadNow));
+}
+
+#if LAZY_SAMPLE_LOADING
+void BKSampleLoader::loadRequestedSamples(void)
+{
+    BKSynthesiser& synth = processor.mainPianoSynth;
+    
+    // Only this thread adds or removes sounds, so they can be looked at without the lock
+    ReferenceCountedArray<BKPianoSamplerSound> requested;
+    
+    for (int i = 0; i < synth.getNumSounds(); i++)
+    {
+        BKPianoSamplerSound* sound = dynamic_cast<BKPianoSamplerSound*> (synth.getSound(i));
+        
+        if (sound != nullptr && sound->takeRequest() && !sound->isReady()) requested.add(sound);
+    }
+    
+    for (int i = 0; i < requested.size(); i++)
+    {
+        if (threadShouldExit()) return;
+        
+        BKPianoSamplerSound* sound = requested.getUnchecked(i);
+        
+        BKReferenceCountedBuffer::Ptr buffer = processor.sampleBank->getBuffer(sound->getFile());
+        
+        if (buffer == nullptr) continue;
+        
+        const ScopedLock sl (synth.getLock());
+        
+        sound->setData(buffer);
+        
+        DBG("loaded on demand: " + sound->getName());
+    }
+}
+
+#endif
+
+#if LAZY_SAMPLE_LOADING || REVERSED_SAMPLE_CACHE
+struct LeastRecentlyPlayedSorter
+{
+    static int compareElements (BKPianoSamplerSound* s1, BKPianoSamplerSound* s2) noexcept
+    {
+        return (s1->lastPlayed < s2->lastPlayed) ? -1 : ((s2->lastPlayed < s1->lastPlayed) ? 1 : 0);
+    }
+};
+#endif
+
+#if LAZY_SAMPLE_LOADING
+void BKSampleLoader::releaseUnplayedSamples(void)
+{
+    BKSynthesiser& synth = processor.mainPianoSynth;
+    
+    const int64 maxBytes = (int64) LAZY_SAMPLE_MEMORY_MB * 1024 * 1024;
+    
+    // Only this thread sets or releases sound data, so it can be read without the lock
+    int64 bytes = 0;
+    
+    for (int i = 0; i < synth.getNumSounds(); i++)
+    {
+        BKPianoSamplerSound* sound = dynamic_cast<BKPianoSamplerSound*> (synth.getSound(i));
+        
+        if (sound != nullptr && sound->isReady()) bytes += sound->getData()->getMemoryUsage();
+    }
+    
+    if (bytes <= maxBytes) return;
+    
+    // Freed once the lock is let go
+    ReferenceCountedArray<BKReferenceCountedBuffer> released;
+    
+    {
+        const ScopedLock sl (synth.getLock());
+        
+        Array<BKSynthesiserSound*> playing;
+        
+        for (int i = 0; i < synth.getNumVoices(); i++)
+        {
+            playing.addIfNotAlreadyThere(synth.getVoice(i)->getCurrentlyPlayingSound().get());
+        }
+        
+        Array<BKPianoSamplerSound*> candidates;
+        
+        for (int i = 0; i < synth.getNumSounds(); i++)
+        {
+            BKPianoSamplerSound* sound = dynamic_cast<BKPianoSamplerSound*> (synth.getSound(i));
+            
+            if (sound != nullptr && sound->isReady() && !sound->isResident() && !playing.contains(sound)) candidates.add(sound);
+        }
+        
+        LeastRecentlyPlayedSorter sorter;
+        candidates.sort(sorter);
+        
+        for (int i = 0; i < candidates.size() && bytes > maxBytes; i++)
+        {
+            BKReferenceCountedBuffer::Ptr buffer = candidates.getUnchecked(i)->releaseData();
             
-            if (sourceSampleRate <= 0 || sampleReader->lengthInSamples <= 0) {
-                maxLength = 0;
+            bytes -= buffer->getMemoryUsage();
+            released.add(buffer);
+        }
+    }
+    
+    DBG("released " + String(released.size()) + " unplayed samples");
+    
+    released.clear();
+    
+    processor.sampleBank->removeUnused();
+}
+#endif
+
+#if REVERSED_SAMPLE_CACHE
+void BKSampleLoader::reverseRequestedSamples(void)
+{
+    BKSynthesiser& synth = processor.mainPianoSynth;
+    
+    // Freed once the lock is let go
+    ReferenceCountedArray<BKReferenceCountedBuffer> released;
+    
+    // Only this thread sets sound data and reversed copies, so they can be read without the lock
+    int64 bytes = 0;
+    
+    for (int i = 0; i < synth.getNumSounds(); i++)
+    {
+        if (threadShouldExit()) return;
+        
+        BKPianoSamplerSound* sound = dynamic_cast<BKPianoSamplerSound*> (synth.getSound(i));
+        
+        if (sound == nullptr) continue;
+        
+        BKReferenceCountedBuffer::Ptr data = sound->getData();
+        
+        // Reverse as far back as the latest reverse note started
+        if (data != nullptr && sound->getReversedRequest() > sound->getReversedLength())
+        {
+            BKReferenceCountedBuffer::Ptr reversed = BKReferenceCountedBuffer::createReversed(*data, sound->getReversedRequest());
+            
+            if (reversed != nullptr)
+            {
+                const ScopedLock sl (synth.getLock());
                 
-            } else {
-                maxLength = jmin((uint64)sampleReader->lengthInSamples, (uint64) (aMaxSampleLengthSec * sourceSampleRate));
+                if (sound->getReversed() != nullptr) released.add(sound->getReversed());
+                sound->setReversed(reversed);
+            }
+        }
+        // Lazy loading released the sample itself
+        else if (data == nullptr && sound->getReversed() != nullptr)
+        {
+            const ScopedLock sl (synth.getLock());
+            
+            released.add(sound->getReversed());
+            sound->setReversed(nullptr);
+            sound->clearReversedRequest();
+        }
+        
+        if (sound->getReversed() != nullptr) bytes += sound->getReversed()->getMemoryUsage();
+    }
+    
+    const int64 maxBytes = (int64) REVERSED_SAMPLE_MEMORY_MB * 1024 * 1024;
+    
+    if (bytes > maxBytes)
+    {
+        const ScopedLock sl (synth.getLock());
+        
+        Array<BKSynthesiserSound*> playing;
+        
+        for (int i = 0; i < synth.getNumVoices(); i++)
+        {
+            playing.addIfNotAlreadyThere(synth.getVoice(i)->getCurrentlyPlayingSound().get());
+        }
+        
+        Array<BKPianoSamplerSound*> candidates;
+        
+        for (int i = 0; i < synth.getNumSounds(); i++)
+        {
+            BKPianoSamplerSound* sound = dynamic_cast<BKPianoSamplerSound*> (synth.getSound(i));
+            
+            if (sound != nullptr && sound->getReversed() != nullptr && !playing.contains(sound)) candidates.add(sound);
+        }
+        
+        LeastRecentlyPlayedSorter sorter;
+        candidates.sort(sorter);
+        
+        for (int i = 0; i < candidates.size() && bytes > maxBytes; i++)
+        {
+            BKPianoSamplerSound* sound = candidates.getUnchecked(i);
+            
+            bytes -= sound->getReversed()->getMemoryUsage();
+            released.add(sound->getReversed());
+            
+            // Until it is played in reverse again
+            sound->setReversed(nullptr);
+            sound->clearReversedRequest();
+        }
+    }
+    
+    if (released.size() > 0) DBG("released " + String(released.size()) + " reversed samples");
+}
+#endif
+
+#if BENCHMARK_SAMPLE_STORAGE || BENCHMARK_REVERSED_SAMPLES
+double BKSampleLoader::timeRender(const ReferenceCountedArray<BKPianoSamplerSound>& sounds, int numNotes, int numBlocks,
+                                  PianoSamplerNoteDirection direction)
+{
+    GeneralSettings::Ptr general = new GeneralSettings();
+    
+    BKSynthesiser synth(general);
+    synth.setCurrentPlaybackSampleRate(44100.0);
+    
+    for (int i = 0; i < numNotes * 2; i++)  synth.addVoice(new BKPianoSamplerVoice(general));
+    
+    for (int i = 0; i < sounds.size(); i++) synth.addSound(sounds.getUnchecked(i));
+    
+    // spread across the keyboard and the velocity layers
+    for (int n = 0; n < numNotes; n++)
+    {
+        const int note = 21 + (n * 87) / jmax(1, numNotes - 1);
+        const float velocity = 0.2f + 0.2f * (n % 4);
+        
+        synth.keyOn(1, note, note, 0.0f, velocity, 1.0f, direction, Normal, MainNote, 1, 0.0f, 20000.0f, 3.0f, 30.0f);
+    }
+    
+    AudioSampleBuffer out(2, 512);
+    MidiBuffer midi;
+    
+    const double start = Time::getMillisecondCounterHiRes();
+    
+    for (int b = 0; b < numBlocks; b++)
+    {
+        out.clear();
+        synth.renderNextBlock(out, midi, 0, out.getNumSamples());
+    }
+    
+    return Time::getMillisecondCounterHiRes() - start;
+}
+#endif
+
+#if BENCHMARK_SAMPLE_STORAGE
+
+String BKSampleLoader::benchmarkSampleStorage(void)
+{
+    WavAudioFormat wavFormat;
+    BKSynthesiser& synth = processor.mainPianoSynth;
+    
+    ReferenceCountedArray<BKPianoSamplerSound> loaded;
+    
+    for (int i = 0; i < synth.getNumSounds(); i++)
+    {
+        BKPianoSamplerSound* sound = dynamic_cast<BKPianoSamplerSound*> (synth.getSound(i));
+        
+        if (sound != nullptr && sound->isReady()) loaded.add(sound);
+    }
+    
+    const int numNotes = 64;
+    const int numBlocks = 172; // about 2 seconds at 44.1k
+    
+    String report = "sample storage benchmark: " + String(loaded.size()) + " samples, "
+                  + String(numNotes) + " notes for " + String(numBlocks) + " blocks of 512\n";
+    
+    double renderMs[2];
+    int64 bytes[2];
+    
+    for (int compact = 0; compact < 2; compact++)
+    {
+        const int64 rssBefore = getResidentMemory();
+        
+        // Decode fresh copies so their memory shows up in RSS
+        ReferenceCountedArray<BKPianoSamplerSound> copies;
+        bytes[compact] = 0;
+        
+        for (int i = 0; i < loaded.size(); i++)
+        {
+            BKPianoSamplerSound* sound = loaded.getUnchecked(i);
+            BKReferenceCountedBuffer::Ptr original = sound->getData();
+            
+            ScopedPointer<AudioFormatReader> reader = wavFormat.createReaderFor(new FileInputStream(sound->getFile()), true);
+            
+            if (reader == nullptr) continue;
+            
+            const int numChannels = original->getNumChannels();
+            const int numSamples = original->getNumSamples();
+            
+            BKReferenceCountedBuffer::Ptr buffer;
+            
+            if (compact)
+            {
+                buffer = BKReferenceCountedBuffer::createCompact(sound->getName(), *reader, numChannels, numSamples);
                 
-                BKReferenceCountedBuffer::Ptr newBuffer = new BKReferenceCountedBuffer(file.getFileName(),jmin(2, numChannels), (int)maxLength);
-                sampleReader->read(newBuffer->getAudioSampleBuffer(), 0, (int)sampleReader->lengthInSamples, 0, true, true);
+                if (buffer == nullptr) continue;
+            }
+            else
+            {
+                buffer = new BKReferenceCountedBuffer(sound->getName(), numChannels, numSamples);
+                reader->read(buffer->getAudioSampleBuffer(), 0, numSamples, 0, true, true);
+            }
+            
+            buffer->sampleRate = original->sampleRate;
+            bytes[compact] += buffer->getMemoryUsage();
+            
+            copies.add(new BKPianoSamplerSound(sound->getName(), sound->getFile(), buffer,
+                                               sound->getMidiNotes(), sound->getRootMidiNote(), sound->getMidiVelocities()));
+        }
+        
+        const int64 rss = getResidentMemory();
+        
+        renderMs[compact] = timeRender(copies, numNotes, numBlocks, Forward);
+        
+        report += String(compact ? "compact: " : "float:   ")
+                + String(bytes[compact] / (1024.0 * 1024.0), 1) + " MB of samples, RSS "
+                + ((rssBefore >= 0 && rss >= 0) ? ("+" + String((rss - rssBefore) / (1024.0 * 1024.0), 1) + " MB") : String("unknown"))
+                + ", render " + String(renderMs[compact], 2) + " ms\n";
+    }
+    
+    report += "compact / float: memory " + String((double) bytes[1] / jmax((int64) 1, bytes[0]), 2)
+            + ", render time " + String(renderMs[1] / jmax(0.001, renderMs[0]), 2);
+    
+    return report;
+}
+#endif
+
+#if BENCHMARK_REVERSED_SAMPLES
+String BKSampleLoader::benchmarkReversedSamples(void)
+{
+    BKSynthesiser& synth = processor.mainPianoSynth;
+    
+    ReferenceCountedArray<BKPianoSamplerSound> loaded;
+    
+    for (int i = 0; i < synth.getNumSounds(); i++)
+    {
+        BKPianoSamplerSound* sound = dynamic_cast<BKPianoSamplerSound*> (synth.getSound(i));
+        
+        if (sound != nullptr && sound->isReady()) loaded.add(sound);
+    }
+    
+    // Reverse notes pile up under nostalgic and synchronic, so test well past a pianist's polyphony
+    const int numNotes = 128;
+    const int numBlocks = 172; // about 2 seconds at 44.1k
+    
+    String report = "reversed sample benchmark: " + String(loaded.size()) + " samples, "
+                  + String(numNotes) + " reverse notes for " + String(numBlocks) + " blocks of 512\n";
+    
+    double renderMs[2];
+    
+    for (int cached = 0; cached < 2; cached++)
+    {
+        // Separate sounds around the same data, so the piano's own reversed copies aren't touched
+        ReferenceCountedArray<BKPianoSamplerSound> copies;
+        int64 bytes = 0;
+        
+        for (int i = 0; i < loaded.size(); i++)
+        {
+            BKPianoSamplerSound* sound = loaded.getUnchecked(i);
+            BKReferenceCountedBuffer::Ptr data = sound->getData();
+            
+            BKPianoSamplerSound* copy = new BKPianoSamplerSound(sound->getName(), sound->getFile(), data,
+                                                                sound->getMidiNotes(), sound->getRootMidiNote(), sound->getMidiVelocities());
+            
+            if (cached)
+            {
+                copy->setReversed(BKReferenceCountedBuffer::createReversed(*data, data->getNumSamples()));
                 
-                synth->addSound(new BKPianoSamplerSound(soundName,
-                                                                    newBuffer,
-                                                                    maxLength,
-                                                                    sourceSampleRate,
-                                                                    noteRange,
-                                                                    root,
-                                                                    velocityRange));
+                if (copy->getReversed() != nullptr) bytes += copy->getReversed()->getMemoryUsage();
             }
-            processor.progress += processor.progressInc;
-            DBG(soundName+": " + String(processor.progress));
+            
+            copies.add(copy);
         }
-        else
+        
+        renderMs[cached] = timeRender(copies, numNotes, numBlocks, Reverse);
+        
+        report += String(cached ? "reversed copies: " : "backwards:       ")
+                + "render " + String(renderMs[cached], 2) + " ms"
+                + (cached ? (", " + String(bytes / (1024.0 * 1024.0), 1) + " MB of copies\n") : String("\n"));
+    }
+    
+    report += "reversed copies / backwards: render time " + String(renderMs[1] / jmax(0.001, renderMs[0]), 2);
+    
+    return report;
+}
+#endif
+
+#if BENCHMARK_VOICE_ENGINE
+String BKSampleLoader::benchmarkVoiceEngine(void)
+{
+    BKSynthesiser& mainSynth = processor.mainPianoSynth;
+    
+    ReferenceCountedArray<BKSynthesiserSound> loaded;
+    
+    for (int i = 0; i < mainSynth.getNumSounds(); i++)
+    {
+        if (mainSynth.getSound(i)->isReady()) loaded.add(mainSynth.getSound(i));
+    }
+    
+    const int numBlocks = 172; // about 2 seconds at 44.1k
+    
+    String report = "voice engine benchmark: " + String(loaded.size()) + " samples, 250 ms synchronic notes for "
+                  + String(numBlocks) + " blocks of 512\n";
+    
+    for (int numVoices = 16; numVoices <= 512; numVoices *= 2)
+    {
+        double renderMs[2];
+        
+        for (int batched = 0; batched < 2; batched++)
         {
-            DBG("file not opened OK: " + temp);
+            GeneralSettings::Ptr general = new GeneralSettings();
+            
+            BKSynthesiser synth(general);
+            synth.setCurrentPlaybackSampleRate(44100.0);
+            synth.setVoiceBatching(batched != 0);
+            
+            for (int i = 0; i < numVoices; i++)     synth.addVoice(new BKPianoSamplerVoice(general));
+            
+            for (int i = 0; i < loaded.size(); i++) synth.addSound(loaded.getUnchecked(i));
+            
+            AudioSampleBuffer out(2, 512);
+            MidiBuffer midi;
+            
+            // Notes are restarted in turn, so about numVoices of them sound at once
+            const int notesPerBlock = jmax(1, numVoices / 20);
+            int n = 0;
+            
+            const double start = Time::getMillisecondCounterHiRes();
+            
+            for (int b = 0; b < numBlocks; b++)
+            {
+                for (int k = 0; k < notesPerBlock; k++, n++)
+                {
+                    const int note = 21 + (n * 37) % 88;
+                    const float velocity = 0.2f + 0.2f * (n % 4);
+                    
+                    synth.keyOn(1, note, note, 0.0f, velocity, 1.0f, Forward, FixedLength, SynchronicNote, 1, 0.0f, 250.0f, 3.0f, 30.0f);
+                }
+                
+                out.clear();
+                synth.renderNextBlock(out, midi, 0, out.getNumSamples());
+            }
+            
+            renderMs[batched] = Time::getMillisecondCounterHiRes() - start;
         }
+        
+        report += String(numVoices).paddedLeft(' ', 3) + " voices: one by one " + String(renderMs[0], 2)
+                + " ms, batched " + String(renderMs[1], 2) + " ms ("
+                + String(renderMs[0] / jmax(0.001, renderMs[1]), 2) + "x)\n";
     }
     
+    return report;
 }
+#endif
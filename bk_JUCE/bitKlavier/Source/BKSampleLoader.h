@@ -12,15 +12,25 @@
 #define BKSAMPLELOADER_H_INCLUDED
 
 #include "BKUtilities.h"
+
+#include "BKSampleBank.h"
+
+#include "BKSynthesiser.h"
 
 class BKAudioProcessor;
+class BKPianoSamplerSound;
 
-class BKSampleLoader : public Thread
+class BKSampleLoader : public Thread,
+                       public BKMemoryAccountable
 {
 public:
     BKSampleLoader(BKAudioProcessor& p):
     processor(p),
-    Thread("sample_loader")
+    Thread("sample_loader"),
+    loadedType(BKLoadNil),
+    reportedDroppedVoices(0),
+    reportedLateRenders(0),
+    reportedDroppedMidi(0)
     {
         
     }
@@ -29,11 +39,17 @@ public:
     {
         
     }
+    
+    // The sample bank, with the load type it was loaded for
+    void reportMemory(BKMemoryReport& report) const override;
+    
+    // What's in the synths now; processor.currentSampleType is what was asked for
+    inline BKSampleLoadType getLoadedType(void) const noexcept { return loadedType; }
+    
 private:
     
     // Sample loading.
     AudioFormatManager formatManager;
-    ScopedPointer<AudioFormatReader> sampleReader;
     ScopedPointer<AudioSampleBuffer> sampleBuffer;
     
     void run(void) override;
@@ -42,7 +58,57 @@ private:
     void loadResonanceReleaseSamples(void);
     void loadHammerReleaseSamples(void);
     
+    // Buffers come from the processor's sample bank, which every instance shares.
+    // Without loadNow the sound is only ready if some instance has the file loaded already.
+    void addSample(ReferenceCountedArray<BKSynthesiserSound>& sounds, const File& file,
+                   const BigInteger& noteRange, int root, const BigInteger& velocityRange, bool loadNow);
+    
+    static File getSamplesFolder(void);
+    
+    // Makes the voices the synth's pool asks for and queues them for the audio thread.
+    void growVoicePools(void);
+    
+    // Reports voices the synth dropped to stay within its render budget, late pool renders and dropped deferred MIDI, since last time.
+    void reportDroppedVoices(void);
+    
+#if LAZY_SAMPLE_LOADING
+    // Loads the layers notes asked for, and releases the least recently played ones past LAZY_SAMPLE_MEMORY_MB.
+    void loadRequestedSamples(void);
+    void releaseUnplayedSamples(void);
+#endif
+    
+#if REVERSED_SAMPLE_CACHE
+    // Reverses the samples reverse notes asked for, and drops the least recently played copies past REVERSED_SAMPLE_MEMORY_MB.
+    void reverseRequestedSamples(void);
+#endif
+    
+#if BENCHMARK_SAMPLE_STORAGE || BENCHMARK_REVERSED_SAMPLES
+    double timeRender(const ReferenceCountedArray<BKPianoSamplerSound>& sounds, int numNotes, int numBlocks,
+                      PianoSamplerNoteDirection direction);
+#endif
+    
+#if BENCHMARK_SAMPLE_STORAGE
+    // Decodes the loaded main samples again as float and as compact samples and reports memory and render time for each.
+    String benchmarkSampleStorage(void);
+#endif
+    
+#if BENCHMARK_REVERSED_SAMPLES
+    // Renders reverse notes on the loaded main samples with and without reversed copies.
+    String benchmarkReversedSamples(void);
+#endif
+    
+#if BENCHMARK_VOICE_ENGINE
+    // Renders short notes on the loaded main samples with 16 to 512 voices, each voice on its own and batched.
+    String benchmarkVoiceEngine(void);
+#endif
+    
     BKAudioProcessor& processor;
+    
+    BKSampleLoadType loadedType;
+    
+    int reportedDroppedVoices;
+    int reportedLateRenders;
+    int reportedDroppedMidi;
   
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BKSampleLoader)
 };
@@ -103,6 +103,17 @@ double BKSubSlider::getValueFromText    (const String & text )
 // **************************************************  BKMultiSlider ************************************************** //
 // ******************************************************************************************************************** //
 
+//what a slider over min..max (stretched to take the value) would hold; for values kept without a slider of their own
+static float snapToSliderRange(double value, double min, double max, double increment)
+{
+    double start = jmin(min, value);
+    double end = jmax(max, value);
+    
+    if (end <= start) return (float) value;
+    
+    return (float) NormalisableRange<double>(start, end, increment).snapToLegalValue(value);
+}
+
 BKMultiSlider::BKMultiSlider(BKMultiSliderType which)
 {
     
@@ -120,12 +131,15 @@ BKMultiSlider::BKMultiSlider(BKMultiSliderType which)
     highlightedSliderLookAndFeel.setColour(Slider::thumbColourId, Colours::red.withSaturation(1.));
     activeSliderLookAndFeel.setColour(Slider::thumbColourId, Colours::goldenrod.withMultipliedAlpha(0.75));
     displaySliderLookAndFeel.setColour(Slider::thumbColourId, Colours::red.withMultipliedAlpha(0.5));
-    lastHighlightedSlider = 0;
+    lastHighlightedSlider = -1;
+    currentSubSlider = 0;
+    currentInvisibleSliderValue = 0.;
     
     sliderMin = sliderMinDefault = -1.;
     sliderMax = sliderMaxDefault = 1.;
     sliderIncrement = 0.01;
     sliderDefault = 0.;
+    skewFromMidpoint = true;
     
     numActiveSliders = 1;
     numDefaultSliders = 12;
@@ -159,13 +173,6 @@ BKMultiSlider::BKMultiSlider(BKMultiSliderType which)
         else subsliderStyle = Slider::LinearVertical;
     }
     
-    //create the default sliders, with one active
-    for(int i = 0; i<numDefaultSliders; i++)
-    {
-        if(i==0) addSlider(-1, true, dontSendNotification);
-        else addSlider(-1, false, dontSendNotification);
-    }
-    
     if(arrangedHorizontally)
     {
         int tempheight = sliderHeight;
@@ -199,6 +206,21 @@ BKMultiSlider::BKMultiSlider(BKMultiSliderType which)
                                              sliderIncrement,
                                              tempwidth,
                                              numActiveSliders * sliderHeight);
+        
+        displaySlider = new BKSubSlider(Slider::LinearBar,
+                                        sliderMin,
+                                        sliderMax,
+                                        sliderDefault,
+                                        sliderIncrement,
+                                        displaySliderWidth,
+                                        sliderHeight);
+    }
+    
+    //create the default sliders, with one active
+    for(int i = 0; i<numDefaultSliders; i++)
+    {
+        if(i==0) addSlider(-1, true, dontSendNotification);
+        else addSlider(-1, false, dontSendNotification);
     }
     
     bigInvisibleSlider->setTextBoxStyle(Slider::TextEntryBoxPosition::NoTextBox, true, 0,0);
@@ -237,49 +259,23 @@ BKMultiSlider::BKMultiSlider(BKMultiSliderType which)
 
 BKMultiSlider::~BKMultiSlider()
 {
-    
+    bigInvisibleSlider->setLookAndFeel(nullptr);
+    displaySlider->setLookAndFeel(nullptr);
 }
 
 
 void BKMultiSlider::setTo(Array<float> newvals, NotificationType newnotify)
 {
-    numActiveSliders = newvals.size();
-    if(numActiveSliders < 1) numActiveSliders = 1;
+    Array<Array<float>> banks;
+    banks.ensureStorageAllocated(newvals.size());
     
-    if(numActiveSliders <= numDefaultSliders) numVisibleSliders = numDefaultSliders;
-    else numVisibleSliders = numActiveSliders;
-    
-    deactivateAll(newnotify);
-    
-    for(int i=0; i<numVisibleSliders; i++)
+    for (auto val : newvals)
     {
-        if(i >= sliders.size()) addSlider(-1, true, newnotify);
-        
-        BKSubSlider* refSlider = sliders[i]->operator[](0);
-        if(refSlider != nullptr)
-        {
-            if(i<numActiveSliders)
-            {
-                if(refSlider->getMaximum() < newvals[i]) refSlider->setRange(sliderMin, newvals[i], sliderIncrement);
-                if(refSlider->getMinimum() > newvals[i]) refSlider->setRange(newvals[i], sliderMax, sliderIncrement);
-                
-                refSlider->setValue(newvals[i], newnotify);
-                refSlider->isActive(true);
-                refSlider->setLookAndFeel(&activeSliderLookAndFeel);
-            }
-            else
-            {
-                refSlider->setValue(sliderDefault, newnotify);
-                refSlider->isActive(false);
-                refSlider->setLookAndFeel(&passiveSliderLookAndFeel);
-            }
-        }
+        Array<float> bank; bank.add(val);
+        banks.add(bank);
     }
     
-    cleanupSliderArray();
-    resetRanges();
-    resized();
-    displaySlider->setValue(sliders[0]->operator[](0)->getValue());
+    setTo(banks, newnotify);
 }
 
 
@@ -291,96 +287,52 @@ void BKMultiSlider::setTo(Array<Array<float>> newvals, NotificationType newnotif
     if(numActiveSliders <= numDefaultSliders) numVisibleSliders = numDefaultSliders;
     else numVisibleSliders = numActiveSliders;
     
-    deactivateAll(newnotify);
-    
-    /*
-     for(int i=0; i<newvals.size(); i++)
-     {
-     for(int j=0; j<newvals[i].size(); j++)
-     {
-     DBG("new multislider value " + String(i) + " " + String(j) + " " + String(newvals[i].getUnchecked(j)));
-     }
-     }
-     */
+    sliderValues.clearQuick();
+    activeSliders.clearQuick();
+    sliderValues.ensureStorageAllocated(numVisibleSliders);
+    activeSliders.ensureStorageAllocated(numVisibleSliders);
     
     for(int i=0; i<numVisibleSliders; i++)
     {
-        if(i >= sliders.size()) addSlider(-1, false, newnotify);
+        Array<float> bank;
         
-        for(int j=0; j<newvals[i].size(); j++)
+        if(i < newvals.size())
         {
-            
-            if(j >= sliders[i]->size()) addSubSlider(i, false, newnotify);
-            
-            BKSubSlider* refSlider = sliders[i]->operator[](j);
-            if(refSlider != nullptr)
-            {
-                if(i<numActiveSliders)
-                {
-                    if(refSlider->getMaximum() < newvals[i][j]) refSlider->setRange(sliderMin, newvals[i][j], sliderIncrement);
-                    if(refSlider->getMinimum() > newvals[i][j]) refSlider->setRange(newvals[i][j], sliderMax, sliderIncrement);
-                    
-                    refSlider->setValue(newvals[i][j], newnotify);
-                    refSlider->isActive(true);
-                    refSlider->setLookAndFeel(&activeSliderLookAndFeel);
-                }
-                else
-                {
-                    refSlider->setValue(sliderDefault, newnotify);
-                    refSlider->isActive(false);
-                    refSlider->setLookAndFeel(&passiveSliderLookAndFeel);
-                }
-            }
+            for (auto val : newvals.getReference(i)) bank.add(snapToSliderRange(val, sliderMin, sliderMax, sliderIncrement));
         }
+        
+        activeSliders.add(bank.size() > 0);
+        
+        if (bank.size() == 0)   bank.add(sliderDefault);
+        
+        sliderValues.add(bank);
     }
     
-    cleanupSliderArray();
+    activeSliders.set(0, true);
+    lastHighlightedSlider = -1;
+    
     resetRanges();
     resized();
-    displaySlider->setValue(sliders[0]->operator[](0)->getValue());
+    displaySlider->setValue(sliderValues.getReference(0).getFirst());
+    
+    if(newnotify == sendNotification)
+    {
+        listeners.call(&BKMultiSlider::Listener::multiSliderAllValuesChanged,
+                       getName(),
+                       getAllActiveValues());
+    }
 }
 
 
 
 void BKMultiSlider::cleanupSliderArray()
 {
-    //sliders.getLock().enter();
-    //doc says "...or preferably use an object of ScopedLockType as an RAII lock for it"
-    //not sure if we should do that or not.
-    //not sure if we have to do any locking at all, because it looks like OwnedArray does so for remove
-    
-    for(int i=sliders.size() - 1; i>=0; i--)
+    //drop any banks past the visible sliders
+    if (sliderValues.size() > numVisibleSliders)
     {
-        //remove sliders above numVisibleSliders
-        if(i >= numVisibleSliders)
-        {
-            for(int j=sliders[i]->size() - 1; j>=0; j--)
-            {
-                BKSubSlider* refSlider = sliders[i]->operator[](j);
-                if(refSlider != nullptr)
-                {
-                    removeChildComponent(refSlider);
-                    sliders[i]->remove(j, true);
-                }
-            }
-        }
-        
-        //remove inactive subsliders; will only do anything if the parent slider still exists
-        for(int j=sliders[i]->size() - 1; j>=1; j--) //only remove subsliders....
-        {
-            BKSubSlider* refSlider = sliders[i]->operator[](j);
-            if(refSlider != nullptr)
-            {
-                if(!refSlider->isActive())
-                {
-                    removeChildComponent(refSlider);
-                }
-            }
-            
-        }
+        sliderValues.removeRange(numVisibleSliders, sliderValues.size() - numVisibleSliders);
+        activeSliders.removeRange(numVisibleSliders, activeSliders.size() - numVisibleSliders);
     }
-    
-    //sliders.getLock().exit();
 }
 
 
@@ -391,88 +343,49 @@ void BKMultiSlider::setMinMaxDefaultInc(std::vector<float> newvals)
     sliderDefault = newvals[2];
     sliderIncrement = newvals[3];
     
-    for(int i=0; i<sliders.size(); i++)
+    //as the subsliders did, go back to the default value
+    for(int i=0; i<sliderValues.size(); i++)
     {
-        for(int j = 0; j<sliders[i]->size(); j++)
-        {
-            BKSubSlider* refSlider = sliders[i]->operator[](j);
-            if(refSlider != nullptr)
-            {
-                refSlider->setMinMaxDefaultInc(newvals);
-                refSlider->setSkewFromMidpoint(skewFromMidpoint);
-            }
-        }
+        Array<float>& bank = sliderValues.getReference(i);
+        for(int j = 0; j<bank.size(); j++) bank.set(j, sliderDefault);
     }
     
     displaySlider->setMinMaxDefaultInc(newvals);
     bigInvisibleSlider->setMinMaxDefaultInc(newvals);
     displaySlider->setSkewFromMidpoint(skewFromMidpoint);
     bigInvisibleSlider->setSkewFromMidpoint(skewFromMidpoint);
+    
+    repaint();
 }
 
 void BKMultiSlider::setSkewFromMidpoint(bool sfm)
 {
     skewFromMidpoint = sfm;
     
-    for(int i=0; i<sliders.size(); i++)
-    {
-        for(int j = 0; j<sliders[i]->size(); j++)
-        {
-            BKSubSlider* refSlider = sliders[i]->operator[](j);
-            if(refSlider != nullptr)
-            {
-                refSlider->setSkewFromMidpoint(skewFromMidpoint);
-            }
-        }
-    }
-    
     displaySlider->setSkewFromMidpoint(skewFromMidpoint);
     bigInvisibleSlider->setSkewFromMidpoint(skewFromMidpoint);
+    
+    repaint();
 }
 
 
 void BKMultiSlider::addSlider(int where, bool active, NotificationType newnotify)
 {
-    BKSubSlider* newslider;
-    
-    if(arrangedHorizontally) newslider     = new BKSubSlider(subsliderStyle,
-                                                             sliderMin,
-                                                             sliderMax,
-                                                             sliderDefault,
-                                                             sliderIncrement,
-                                                             sliderWidth,
-                                                             sliderHeight);
-    else newslider                         = new BKSubSlider(subsliderStyle,
-                                                             sliderMin,
-                                                             sliderMax,
-                                                             sliderDefault,
-                                                             sliderIncrement,
-                                                             sliderWidth,
-                                                             sliderHeight);
-    
-    newslider->setRange(sliderMin, sliderMax, sliderIncrement);
-    newslider->setValue(sliderDefault, dontSendNotification);
-    newslider->addListener(this);
+    Array<float> bank;
+    bank.add(sliderDefault);
     
     if(where < 0)
     {
-        sliders.add(new OwnedArray<BKSubSlider>);
-        sliders.getLast()->add(newslider);
+        sliderValues.add(bank);
+        activeSliders.add(active);
     }
     else
     {
-        sliders.insert(where, new OwnedArray<BKSubSlider>);
-        sliders[where]->add(newslider);
+        sliderValues.insert(where, bank);
+        activeSliders.insert(where, active);
     }
     
-    addAndMakeVisible(newslider);
-    
-    if(active)
-        newslider->setLookAndFeel(&activeSliderLookAndFeel);
-    else
-        newslider->setLookAndFeel(&passiveSliderLookAndFeel);
-    
-    newslider->isActive(active);
+    repaint();
     
     if(newnotify == sendNotification)
     {
@@ -486,39 +399,16 @@ void BKMultiSlider::addSlider(int where, bool active, NotificationType newnotify
 
 void BKMultiSlider::addSubSlider(int where, bool active, NotificationType newnotify)
 {
-    BKSubSlider* newslider;
-    
-    if(arrangedHorizontally) newslider     = new BKSubSlider(subsliderStyle,
-                                                             sliderMin,
-                                                             sliderMax,
-                                                             sliderDefault,
-                                                             sliderIncrement,
-                                                             sliderWidth,
-                                                             sliderHeight);
-    else newslider                         = new BKSubSlider(subsliderStyle,
-                                                             sliderMin,
-                                                             sliderMax,
-                                                             sliderDefault,
-                                                             sliderIncrement,
-                                                             sliderWidth,
-                                                             sliderHeight);
-    
-    newslider->setRange(sliderMin, sliderMax, sliderIncrement);
-    newslider->setValue(newslider->proportionOfLengthToValue( 1. - (clickedHeight / this->getHeight())), dontSendNotification);
-    newslider->addListener(this);
-    
-    OwnedArray<BKSubSlider> *newsliderArray = sliders[where];
-    newsliderArray->add(newslider);
-    sliders.set(where, newsliderArray);
-    
-    addAndMakeVisible(newslider);
-    
-    if(active)
-        newslider->setLookAndFeel(&activeSliderLookAndFeel);
-    else
-        newslider->setLookAndFeel(&passiveSliderLookAndFeel);
+    if (where < 0 || where >= sliderValues.size()) return;
+    
+    //new subslider goes where the user clicked
+    float newval = snapToSliderRange(bigInvisibleSlider->proportionOfLengthToValue( 1. - (clickedHeight / this->getHeight())),
+                                     sliderMin, sliderMax, sliderIncrement);
     
-    newslider->isActive(active);
+    sliderValues.getReference(where).add(newval);
+    if (active) activeSliders.set(where, true);
+    
+    repaintSlider(where);
     
     if(newnotify == sendNotification)
     {
@@ -526,33 +416,28 @@ void BKMultiSlider::addSubSlider(int where, bool active, NotificationType newnot
                        getName(),
                        getAllActiveValues());
     }
-    
-    //resized();
 }
 
 
+//leaves the first slider active; drops all subsliders. Returns false if there was nothing to do.
+bool BKMultiSlider::deactivate(int where)
+{
+    if (sliderValues.size() <= 1 || where < 0 || where >= sliderValues.size()) return false;
+    
+    Array<float>& bank = sliderValues.getReference(where);
+    if (bank.size() > 1) bank.resize(1);
+    
+    if (where != 0) activeSliders.set(where, false);
+    
+    return true;
+}
 
 void BKMultiSlider::deactivateSlider(int where, NotificationType notify)
 {
-    if(sliders.size() > 1) {
-        
-        //leave one active slider for first slider
-        int startSlider;
-        if(where == 0) startSlider = 1;
-        else startSlider = 0;
-        
-        for(int i = sliders[where]->size() - 1; i >= startSlider; i--) {
-            
-            BKSubSlider* currentSlider = sliders[where]->operator[](i);
-            if(currentSlider != nullptr) {
-                currentSlider->isActive(false);
-                currentSlider->setLookAndFeel(&passiveSliderLookAndFeel);
-                if(i != 0) sliders[where]->remove(i); //remove all but first slider
-            }
-        }
-        
-        lastHighlightedSlider = 0;
-        cleanupSliderArray();
+    if (deactivate(where))
+    {
+        lastHighlightedSlider = -1;
+        repaint();
         
         if(notify) {
             listeners.call(&BKMultiSlider::Listener::multiSliderAllValuesChanged,
@@ -564,27 +449,37 @@ void BKMultiSlider::deactivateSlider(int where, NotificationType notify)
 
 void BKMultiSlider::deactivateAll(NotificationType notify)
 {
-    for(int i=0; i<sliders.size(); i++ )
-    {
-        deactivateSlider(i, notify);
-    }
+    deactivateAllBefore(sliderValues.size(), notify);
 }
 
 
 void BKMultiSlider::deactivateAllAfter(int where, NotificationType notify)
 {
-    for(int i=where+1; i<sliders.size(); i++ )
+    bool changed = false;
+    for(int i=where+1; i<sliderValues.size(); i++ ) changed |= deactivate(i);
+    
+    if (changed)
     {
-        deactivateSlider(i, notify);
+        lastHighlightedSlider = -1;
+        repaint();
+        
+        if(notify) listeners.call(&BKMultiSlider::Listener::multiSliderAllValuesChanged, getName(), getAllActiveValues());
     }
 }
 
 void BKMultiSlider::deactivateAllBefore(int where, NotificationType notify)
 {
-    if (where > sliders.size()) where = sliders.size();
-    for(int i=0; i<where; i++ )
+    if (where > sliderValues.size()) where = sliderValues.size();
+    
+    bool changed = false;
+    for(int i=0; i<where; i++ ) changed |= deactivate(i);
+    
+    if (changed)
     {
-        deactivateSlider(i, notify);
+        lastHighlightedSlider = -1;
+        repaint();
+        
+        if(notify) listeners.call(&BKMultiSlider::Listener::multiSliderAllValuesChanged, getName(), getAllActiveValues());
     }
 }
 
@@ -594,37 +489,27 @@ void BKMultiSlider::mouseDrag(const MouseEvent& e)
     {
         int which = whichSlider(e);
         
-        if(which >= 0) {
+        if(which >= 0 && currentSubSlider < sliderValues.getReference(which).size()) {
             
-            BKSubSlider* currentSlider = sliders[which]->operator[](currentSubSlider);
-            if (currentSlider != nullptr)
+            double newval = currentInvisibleSliderValue;
+            if(e.mods.isShiftDown()) newval = round(currentInvisibleSliderValue);
+            
+            sliderValues.getReference(which).set(currentSubSlider, snapToSliderRange(newval, sliderMin, sliderMax, sliderIncrement));
+            displaySlider->setValue(newval);
+            repaintSlider(which);
+            
+            if(!activeSliders[which]){
+                activeSliders.set(which, true);
+                listeners.call(&BKMultiSlider::Listener::multiSliderAllValuesChanged,
+                               getName(),
+                               getAllActiveValues());
+            }
+            else
             {
-                if(e.mods.isShiftDown())
-                {
-                    currentSlider->setValue(round(currentInvisibleSliderValue));
-                    displaySlider->setValue(round(currentInvisibleSliderValue));
-                }
-                else
-                {
-                    currentSlider->setValue(currentInvisibleSliderValue);
-                    displaySlider->setValue(currentInvisibleSliderValue);
-                }
-                
-                
-                if(!currentSlider->isActive()){
-                    currentSlider->isActive(true);
-                    currentSlider->setLookAndFeel(&activeSliderLookAndFeel);
-                    listeners.call(&BKMultiSlider::Listener::multiSliderAllValuesChanged,
-                                   getName(),
-                                   getAllActiveValues());
-                }
-                else
-                {
-                    listeners.call(&BKMultiSlider::Listener::multiSliderValueChanged,
-                                   getName(),
-                                   whichActiveSlider(which),
-                                   getOneSliderBank(which));
-                }
+                listeners.call(&BKMultiSlider::Listener::multiSliderValueChanged,
+                               getName(),
+                               whichActiveSlider(which),
+                               getOneSliderBank(which));
             }
         }
     }
@@ -637,14 +522,9 @@ void BKMultiSlider::mouseMove(const MouseEvent& e)
         int which = whichSlider(e);
         int whichSub = whichSubSlider(which, e);
         
-        if(which >= 0 && whichSub >= 0)
+        if(which >= 0 && whichSub >= 0 && activeSliders[which])
         {
-            BKSubSlider* currentSlider = sliders[which]->operator[](whichSub);
-            if (currentSlider != nullptr)
-            {
-                if(currentSlider->isActive())
-                    displaySlider->setValue(currentSlider->getValue());
-            }
+            displaySlider->setValue(sliderValues.getReference(which)[whichSub]);
         }
     }
 }
@@ -663,15 +543,17 @@ void BKMultiSlider::mouseDoubleClick (const MouseEvent &e)
     which += whichSubSlider(which, e);
     for (int i=0; i<whichSave; i++)
     {
-        if(sliders[i]->size() > 0)
+        if(sliderValues.getReference(i).size() > 0)
         {
-            which += (sliders[i]->size() - 1);
+            which += (sliderValues.getReference(i).size() - 1);
         }
     }
     
     //highlight number for current slider
+    String allValues = arrayFloatArrayToString(getAllActiveValues());
+    
     StringArray tokens;
-    tokens.addTokens(arrayFloatArrayToString(getAllActiveValues()), false); //arrayFloatArrayToString
+    tokens.addTokens(allValues, false); //arrayFloatArrayToString
     int startPoint = 0;
     int endPoint;
     
@@ -691,7 +573,7 @@ void BKMultiSlider::mouseDoubleClick (const MouseEvent &e)
     
     editValsTextField->setVisible(true);
     editValsTextField->toFront(true);
-    editValsTextField->setText(arrayFloatArrayToString(getAllActiveValues()));
+    editValsTextField->setText(allValues);
     editValsTextField->setWantsKeyboardFocus(true);
     editValsTextField->grabKeyboardFocus();
     
@@ -727,11 +609,8 @@ void BKMultiSlider::mouseUp (const MouseEvent &event)
             int which = whichSlider(event);
             if(which >= 0) {
                 
-                BKSubSlider* currentSlider = sliders[which]->operator[](0);
-                if (currentSlider != nullptr)
-                {
-                    currentSlider->setValue(sliderDefault); //again, need to identify which subslider to get
-                }
+                sliderValues.getReference(which).set(0, sliderDefault); //again, need to identify which subslider to get
+                repaintSlider(which);
                 
                 displaySlider->setValue(sliderDefault);
                 
@@ -748,18 +627,12 @@ void BKMultiSlider::mouseUp (const MouseEvent &event)
 
 int BKMultiSlider::whichSlider (const MouseEvent &e)
 {
-    int x = e.x;
-    int y = e.y;
+    if (sliderWidth <= 0.) return -1;
     
-    BKSubSlider* refSlider = sliders[0]->operator[](0);
-    if (refSlider != nullptr)
-    {
-        int which;
-        if(arrangedHorizontally) which = (x / refSlider->getWidth());
-        else which = (y / refSlider->getHeight());
-        
-        if (which >= 0 && which < sliders.size()) return which;
-    }
+    //sliders are laid out left to right over the invisible slider (see resized)
+    int which = (int) (e.x / sliderWidth);
+    
+    if (e.x >= 0 && which < sliderValues.size()) return which;
     
     return -1;
 }
@@ -767,28 +640,21 @@ int BKMultiSlider::whichSlider (const MouseEvent &e)
 
 int BKMultiSlider::whichSubSlider (int which)
 {
-    if(which < 0) return 0;
+    if(which < 0 || which >= sliderValues.size()) return 0;
     
-    int whichSub = 0;
-    float refDistance;
+    const Array<float>& bank = sliderValues.getReference(which);
     
-    BKSubSlider* refSlider = sliders[which]->operator[](0);
-    if(refSlider != nullptr)
-    {
-        refDistance = fabs(refSlider->getValue() - currentInvisibleSliderValue);
-    }
+    int whichSub = 0;
+    float refDistance = fabs(bank.getFirst() - currentInvisibleSliderValue);
     
     if(arrangedHorizontally) {
-        for(int i=0; i<sliders[which]->size(); i++)
+        for(int i=0; i<bank.size(); i++)
         {
-            BKSubSlider* currentSlider = sliders[which]->operator[](i);
-            if(currentSlider != nullptr) {
-                float tempDistance = fabs(currentSlider->getValue() - currentInvisibleSliderValue);
-                if(tempDistance < refDistance)
-                {
-                    whichSub = i;
-                    refDistance = tempDistance;
-                }
+            float tempDistance = fabs(bank.getUnchecked(i) - currentInvisibleSliderValue);
+            if(tempDistance < refDistance)
+            {
+                whichSub = i;
+                refDistance = tempDistance;
             }
         }
     }
@@ -798,28 +664,21 @@ int BKMultiSlider::whichSubSlider (int which)
 
 int BKMultiSlider::whichSubSlider (int which, const MouseEvent &e)
 {
-    if(which < 0) return 0;
+    if(which < 0 || which >= sliderValues.size()) return 0;
     
-    int whichSub = 0;
-    float refDistance;
+    const Array<float>& bank = sliderValues.getReference(which);
     
-    BKSubSlider* refSlider = sliders[which]->operator[](0);
-    if(refSlider != nullptr)
-    {
-        refDistance = fabs(refSlider->getPositionOfValue(refSlider->getValue()) - e.y);
-    }
+    int whichSub = 0;
+    float refDistance = fabs(bigInvisibleSlider->getPositionOfValue(bank.getFirst()) - e.y);
     
     if(arrangedHorizontally) {
-        for(int i=0; i<sliders[which]->size(); i++)
+        for(int i=0; i<bank.size(); i++)
         {
-            BKSubSlider* currentSlider = sliders[which]->operator[](i);
-            if(currentSlider != nullptr) {
-                float tempDistance = fabs(currentSlider->getPositionOfValue(currentSlider->getValue()) - e.y);
-                if(tempDistance < refDistance)
-                {
-                    whichSub = i;
-                    refDistance = tempDistance;
-                }
+            float tempDistance = fabs(bigInvisibleSlider->getPositionOfValue(bank.getUnchecked(i)) - e.y);
+            if(tempDistance < refDistance)
+            {
+                whichSub = i;
+                refDistance = tempDistance;
             }
         }
     }
@@ -830,13 +689,11 @@ int BKMultiSlider::whichSubSlider (int which, const MouseEvent &e)
 int BKMultiSlider::whichActiveSlider (int which)
 {
     int counter = 0;
-    if(which > sliders.size()) which = sliders.size();
+    if(which > activeSliders.size()) which = activeSliders.size();
     
     for(int i=0; i<which; i++)
     {
-        BKSubSlider* currentSlider = sliders[i]->operator[](0);
-        if(currentSlider != nullptr)
-            if(currentSlider->isActive()) counter++;
+        if(activeSliders.getUnchecked(i)) counter++;
     }
     
     
@@ -850,17 +707,12 @@ void BKMultiSlider::resetRanges()
     double sliderMinTemp = sliderMinDefault;
     double sliderMaxTemp = sliderMaxDefault;
     
-    for(int i = 0; i<sliders.size(); i++)
+    for(int i = 0; i<sliderValues.size(); i++)
     {
-        for(int j = 0; j<sliders[i]->size(); j++)
+        for (auto val : sliderValues.getReference(i))
         {
-            BKSubSlider* currentSlider = sliders[i]->operator[](j);
-            if(currentSlider != nullptr)
-            {
-                if(currentSlider->getValue() > sliderMaxTemp) sliderMaxTemp = currentSlider->getValue();
-                if(currentSlider->getValue() < sliderMinTemp) sliderMinTemp = currentSlider->getValue();
-            }
-            
+            if(val > sliderMaxTemp) sliderMaxTemp = val;
+            if(val < sliderMinTemp) sliderMinTemp = val;
         }
     }
     
@@ -869,20 +721,10 @@ void BKMultiSlider::resetRanges()
         sliderMax = sliderMaxTemp;
         sliderMin = sliderMinTemp;
         
-        for(int i = 0; i<sliders.size(); i++)
-        {
-            for(int j = 0; j<sliders[i]->size(); j++)
-            {
-                BKSubSlider* currentSlider = sliders[i]->operator[](j);
-                if(currentSlider != nullptr)
-                {
-                    currentSlider->setRange(sliderMin, sliderMax, sliderIncrement);
-                }
-            }
-        }
-        
         bigInvisibleSlider->setRange(sliderMin, sliderMax, sliderIncrement);
         displaySlider->setRange(sliderMin, sliderMax, sliderIncrement);
+        
+        repaint();
     }
 }
 
@@ -905,20 +747,64 @@ void BKMultiSlider::resized()
     
     sliderWidth = (float)area.getWidth() / numVisibleSliders;
     
-    for (int i=0; i<numVisibleSliders; i++)
+    bigInvisibleSlider->toFront(false);
+    
+    repaint();
+}
+
+//only the sliders inside the clip region are drawn, so a long array costs what's on screen
+void BKMultiSlider::paint (Graphics& g)
+{
+    Rectangle<int> area (bigInvisibleSlider->getBounds());
+    
+    if (area.isEmpty() || sliderWidth <= 0.) return;
+    
+    g.setColour(activeSliderLookAndFeel.findColour(Slider::backgroundColourId));
+    g.fillRect(area);
+    
+    Rectangle<int> clip (g.getClipBounds().getIntersection(area));
+    
+    int first = jmax(0, (int) ((clip.getX() - area.getX()) / sliderWidth));
+    int last = jmin(sliderValues.size() - 1, (int) ((clip.getRight() - area.getX()) / sliderWidth));
+    
+    for (int i = first; i <= last; i++)
     {
-        Rectangle<float> sliderArea (area.removeFromLeft(sliderWidth));
-        for(int j=0; j<sliders[i]->size(); j++)
+        Rectangle<float> sliderArea (getSliderBounds(i).toFloat());
+        
+        BKMultiSliderLookAndFeel& laf = (i == lastHighlightedSlider)    ? highlightedSliderLookAndFeel :
+                                        activeSliders[i]                ? activeSliderLookAndFeel :
+                                                                          passiveSliderLookAndFeel;
+        
+        //as BKMultiSliderLookAndFeel draws a bar slider: a band at the value, with a line on top
+        Colour baseColour (laf.findColour(Slider::thumbColourId).withMultipliedAlpha (0.8f));
+        
+        for (auto val : sliderValues.getReference(i))
         {
-            BKSubSlider* currentSlider = sliders[i]->operator[](j);
-            if(currentSlider != nullptr)
-            {
-                currentSlider->setBounds(sliderArea.toNearestInt());
-            }
+            float pos = area.getY() + bigInvisibleSlider->getPositionOfValue(val);
+            
+            g.setGradientFill (ColourGradient (baseColour.brighter (0.08f), 0.0f, sliderArea.getY(),
+                                               baseColour.darker (0.08f), 0.0f, sliderArea.getBottom(), false));
+            g.fillRect (sliderArea.getX(), pos - 2, sliderArea.getWidth(), 4.0f);
+            
+            g.setColour (baseColour.darker (0.2f));
+            g.fillRect (sliderArea.getX(), pos, sliderArea.getWidth(), 1.0f);
         }
     }
+}
+
+Rectangle<int> BKMultiSlider::getSliderBounds(int which)
+{
+    Rectangle<int> area (bigInvisibleSlider->getBounds());
     
-    bigInvisibleSlider->toFront(false);
+    int left = area.getX() + roundToInt(which * sliderWidth);
+    int right = area.getX() + roundToInt((which + 1) * sliderWidth);
+    
+    return Rectangle<int>(left, area.getY(), right - left, area.getHeight());
+}
+
+void BKMultiSlider::repaintSlider(int which)
+{
+    if (which >= 0 && which < sliderValues.size()) repaint(getSliderBounds(which).expanded(1, 0));
 }
 
 
@@ -938,13 +824,8 @@ void BKMultiSlider::textEditorReturnKeyPressed(TextEditor& textEditor)
         editValsTextField->setVisible(false);
         editValsTextField->toBack();
         
+        //parsed once; setTo tells the listeners
         setTo(stringToArrayFloatArray(textEditor.getText()), sendNotification);
-        resetRanges();
-        resized();
-        
-        listeners.call(&BKMultiSlider::Listener::multiSliderAllValuesChanged,
-                       getName(),
-                       getAllActiveValues());
     }
 }
 
@@ -981,12 +862,6 @@ void BKMultiSlider::textEditorFocusLost(TextEditor& textEditor)
         if(!focusLostByEscapeKey)
         {
             setTo(stringToArrayFloatArray(textEditor.getText()), sendNotification);
-            resetRanges();
-            resized();
-            
-            listeners.call(&BKMultiSlider::Listener::multiSliderAllValuesChanged,
-                           getName(),
-                           getAllActiveValues());
         }
     }
 #endif
@@ -995,47 +870,24 @@ void BKMultiSlider::textEditorFocusLost(TextEditor& textEditor)
 
 Array<Array<float>> BKMultiSlider::getAllValues()
 {
-    Array<Array<float>> currentvals;
-    
-    for(int i=0; i<sliders.size(); i++)
-    {
-        Array<float> toAdd;
-        
-        for(int j=0; j<sliders[i]->size(); j++)
-        {
-            BKSubSlider* currentSlider = sliders[i]->operator[](j);
-            if(currentSlider != nullptr)
-            {
-                toAdd.add(currentSlider->getValue());
-            }
-        }
-        
-        currentvals.add(toAdd);
-    }
-    
-    return currentvals;
+    return sliderValues;
 }
 
 
 Array<Array<float>> BKMultiSlider::getAllActiveValues()
 {
     Array<Array<float>> currentvals;
+    currentvals.ensureStorageAllocated(sliderValues.size());
     
-    for(int i=0; i<sliders.size(); i++)
+    for(int i=0; i<sliderValues.size(); i++)
     {
-        Array<float> toAdd;
+        if(!activeSliders[i]) continue;
+        
+        Array<float> toAdd (sliderValues.getReference(i));
         
-        for(int j=0; j<sliders[i]->size(); j++)
+        for(int j=0; j<toAdd.size(); j++)
         {
-            BKSubSlider* currentSlider = sliders[i]->operator[](j);
-            if(currentSlider != nullptr)
-            {
-                float valToAdd = currentSlider->getValue();
-                if(fabs(valToAdd) < 0.000001) valToAdd = 0.;
-                
-                if(currentSlider->isActive())
-                    toAdd.add(valToAdd);
-            }
+            if(fabs(toAdd.getUnchecked(j)) < 0.000001) toAdd.set(j, 0.);
         }
         
         if(toAdd.size() > 0) currentvals.add(toAdd);
@@ -1047,17 +899,7 @@ Array<Array<float>> BKMultiSlider::getAllActiveValues()
 
 Array<float> BKMultiSlider::getOneSliderBank(int which)
 {
-    Array<float> newvals;
-    for(int i=0; i<sliders[which]->size(); i++)
-    {
-        BKSubSlider* currentSlider = sliders[which]->operator[](i);
-        if(currentSlider != nullptr)
-        {
-            newvals.add(currentSlider->getValue());
-        }
-    }
-    
-    return newvals;
+    return sliderValues[which];
 }
 
 
@@ -1084,7 +926,7 @@ void BKMultiSlider::sliderModifyMenuCallback (const int result, BKMultiSlider* m
             case 1:   ms->deactivateSlider(which, sendNotification); break;
             case 2:   ms->deactivateAllAfter(which, sendNotification); break;
             case 3:   ms->deactivateAllBefore(which, sendNotification); break;
-            case 4:   ms->addSubSlider(which, true, sendNotification); ms->resized(); break;
+            case 4:   ms->addSubSlider(which, true, sendNotification); break;
                 
             default:  break;
         }
@@ -1100,10 +942,10 @@ void BKMultiSlider::setCurrentSlider(int activeSliderNum)
     
     if(sliderNum != lastHighlightedSlider)
     {
-        highlight(sliderNum);
-        deHighlight(lastHighlightedSlider);
+        repaintSlider(lastHighlightedSlider);
+        repaintSlider(sliderNum);
         lastHighlightedSlider = sliderNum;
-        displaySlider->setValue(sliders[sliderNum]->operator[](0)->getValue());
+        displaySlider->setValue(sliderValues.getReference(sliderNum).getFirst());
     }
 }
 
@@ -1111,36 +953,18 @@ int BKMultiSlider::getActiveSlider(int sliderNum)
 {
     int sliderCount = 0;
     
-    for(int i = 0; i < sliders.size(); i++)
+    for(int i = 0; i < activeSliders.size(); i++)
     {
-        if(sliderCount == sliderNum && sliders[i]->operator[](0)->isActive())
+        if(sliderCount == sliderNum && activeSliders.getUnchecked(i))
             return i;
         
-        if(sliders[i]->operator[](0)->isActive())
+        if(activeSliders.getUnchecked(i))
             sliderCount++;
     }
     
     return 0;
 }
 
-void BKMultiSlider::highlight(int activeSliderNum)
-{
-    //need to count through depth, but for now just the first one...
-    for(int i=0; i<sliders[activeSliderNum]->size(); i++)
-    {
-        sliders[activeSliderNum]->operator[](i)->setLookAndFeel(&highlightedSliderLookAndFeel);
-    }
-}
-
-void BKMultiSlider::deHighlight(int sliderNum)
-{
-    for(int i=0; i<sliders[sliderNum]->size(); i++)
-    {
-        sliders[sliderNum]->operator[](i)->setLookAndFeel(&activeSliderLookAndFeel);
-    }
-    
-}
-
 
 
 // ******************************************************************************************************************** //
@@ -1997,27 +1821,11 @@ sliderIncrement(increment)
     addAndMakeVisible(editValsTextField);
     editValsTextField->setVisible(false);
     
-    numSliders = 12;
     numActiveSliders = 1;
+    clickedSlider = 0;
     
-    for(int i=0; i<numSliders; i++)
-    {
-        dataSliders.add(new Slider);
-        Slider* newSlider = dataSliders.getLast();
-        
-        newSlider->setSliderStyle(Slider::LinearBar);
-        newSlider->setTextBoxStyle(Slider::NoTextBox, false, 0, 0);
-        newSlider->setRange(sliderMin, sliderMax, sliderIncrement);
-        newSlider->setValue(sliderDefault, dontSendNotification);
-        newSlider->setLookAndFeel(&stackedSliderLookAndFeel);
-        //newSlider->addListener(this);
-        addAndMakeVisible(newSlider);
-        if(i>0) {
-            newSlider->setVisible(false);
-            activeSliders.insert(i, false);
-        }
-        else activeSliders.insert(0, true);
-    }
+    dataValues.add(sliderDefault);
+    dataAlpha = 1.;
     
     topSlider = new Slider;
     topSlider->setSliderStyle(Slider::LinearBar);
@@ -2043,17 +1851,8 @@ void BKStackedSlider::setDim(float alphaVal)
     showName.setAlpha(alphaVal);
     topSlider->setAlpha(alphaVal);
     
-    for(int i=0; i<numSliders; i++)
-    {
-        Slider* newSlider = dataSliders.operator[](i);
-        if(newSlider != nullptr)
-        {
-            if(activeSliders.getUnchecked(i))
-            {
-                newSlider->setAlpha(alphaVal);
-            }
-        }
-    }
+    dataAlpha = alphaVal;
+    repaint();
 }
 
 void BKStackedSlider::setBright()
@@ -2061,17 +1860,8 @@ void BKStackedSlider::setBright()
     showName.setAlpha(1.);
     topSlider->setAlpha(1.);
     
-    for(int i=0; i<numSliders; i++)
-    {
-        Slider* newSlider = dataSliders.operator[](i);
-        if(newSlider != nullptr)
-        {
-            if(activeSliders.getUnchecked(i))
-            {
-                newSlider->setAlpha(1.);
-            }
-        }
-    }
+    dataAlpha = 1.;
+    repaint();
 }
 
 void BKStackedSlider::sliderValueChanged (Slider *slider)
@@ -2090,59 +1880,18 @@ void BKStackedSlider::addSlider(NotificationType newnotify)
 
 void BKStackedSlider::setTo(Array<float> newvals, NotificationType newnotify)
 {
+    //make sure there is one!
+    if(newvals.size() <= 0) newvals.add(sliderDefault);
     
-    int slidersToActivate = newvals.size();
-    if(slidersToActivate > numSliders) slidersToActivate = numSliders;
-    if(slidersToActivate <= 0)
-    {
-        slidersToActivate = 1;
-        newvals.add(sliderDefault);
-    }
-    
-    //activate sliders
-    for(int i=0; i<slidersToActivate; i++)
-    {
-        
-        Slider* newSlider = dataSliders.operator[](i);
-        if(newSlider != nullptr)
-        {
-            if(newvals.getUnchecked(i) > sliderMax)
-                newSlider->setRange(sliderMin, newvals.getUnchecked(i), sliderIncrement);
-            
-            if(newvals.getUnchecked(i) < sliderMin)
-                newSlider->setRange(newvals.getUnchecked(i), sliderMax, sliderIncrement);
-            
-            newSlider->setValue(newvals.getUnchecked(i));
-            newSlider->setVisible(true);
-        }
-        
-        activeSliders.set(i, true);
-    }
-    
-    //deactivate unused sliders
-    for(int i=slidersToActivate; i<numSliders; i++)
-    {
-        
-        Slider* newSlider = dataSliders.operator[](i);
-        if(newSlider != nullptr)
-        {
-            newSlider->setValue(sliderDefault);
-            newSlider->setVisible(false);
-        }
-        
-        activeSliders.set(i, false);
-    }
+    dataValues.clearQuick();
+    dataValues.ensureStorageAllocated(newvals.size());
     
-    //make sure there is one!
-    if(slidersToActivate <= 0)
-    {
-        dataSliders.getFirst()->setValue(sliderDefault);
-        activeSliders.set(0, true);
-    }
+    for (auto val : newvals) dataValues.add(snapToSliderRange(val, sliderMin, sliderMax, sliderIncrement));
     
     resetRanges();
+    repaint();
     
-    topSlider->setValue(dataSliders.getFirst()->getValue(), dontSendNotification);
+    topSlider->setValue(dataValues.getFirst(), dontSendNotification);
 }
 
 
@@ -2167,17 +1916,18 @@ void BKStackedSlider::mouseDrag(const MouseEvent& e)
 {
     if(!mouseJustDown)
     {
-        Slider* currentSlider = dataSliders.operator[](clickedSlider);
-        if(currentSlider != nullptr)
+        if(clickedSlider >= 0 && clickedSlider < dataValues.size())
         {
             if(e.mods.isShiftDown())
             {
-                currentSlider->setValue(round(topSlider->getValue()));
+                dataValues.set(clickedSlider, round(topSlider->getValue()));
                 topSlider->setValue(round(topSlider->getValue()));
             }
             else {
-                currentSlider->setValue(topSlider->getValue(), sendNotification);
+                dataValues.set(clickedSlider, topSlider->getValue());
             }
+            
+            repaint();
         }
     }
     else mouseJustDown = false;
@@ -2194,7 +1944,7 @@ void BKStackedSlider::mouseUp(const MouseEvent& e)
 void BKStackedSlider::mouseMove(const MouseEvent& e)
 {
     //topSlider->setValue(topSlider->proportionOfLengthToValue((double)e.x / getWidth()), dontSendNotification);
-    topSlider->setValue(dataSliders.getUnchecked(whichSlider(e))->getValue());
+    topSlider->setValue(dataValues[whichSlider(e)]);
 }
 
 
@@ -2206,8 +1956,10 @@ void BKStackedSlider::mouseDoubleClick (const MouseEvent &e)
     hasBigOne = true;
     WantsBigOne::listeners.call(&WantsBigOne::Listener::iWantTheBigOne, editValsTextField, sliderName);
 #else
+    String allValues = floatArrayToString(getAllActiveValues());
+    
     StringArray tokens;
-    tokens.addTokens(floatArrayToString(getAllActiveValues()), false); //arrayFloatArrayToString
+    tokens.addTokens(allValues, false); //arrayFloatArrayToString
     int startPoint = 0;
     int endPoint;
     
@@ -2220,7 +1972,7 @@ void BKStackedSlider::mouseDoubleClick (const MouseEvent &e)
     
     editValsTextField->setVisible(true);
     editValsTextField->toFront(true);
-    editValsTextField->setText(floatArrayToString(getAllActiveValues())); //arrayFloatArrayToString
+    editValsTextField->setText(allValues); //arrayFloatArrayToString
     
     Range<int> highlightRange(startPoint, endPoint);
     editValsTextField->setHighlightedRegion(highlightRange);
@@ -2285,14 +2037,10 @@ void BKStackedSlider::resetRanges()
     double sliderMinTemp = sliderMinDefault;
     double sliderMaxTemp = sliderMaxDefault;
     
-    for(int i = 0; i<dataSliders.size(); i++)
+    for (auto val : dataValues)
     {
-        Slider* currentSlider = dataSliders.operator[](i);
-        if(currentSlider != nullptr)
-        {
-            if(currentSlider->getValue() > sliderMaxTemp) sliderMaxTemp = currentSlider->getValue();
-            if(currentSlider->getValue() < sliderMinTemp) sliderMinTemp = currentSlider->getValue();
-        }
+        if(val > sliderMaxTemp) sliderMaxTemp = val;
+        if(val < sliderMinTemp) sliderMinTemp = val;
     }
     
     if( (sliderMax != sliderMaxTemp) || sliderMin != sliderMinTemp)
@@ -2300,89 +2048,41 @@ void BKStackedSlider::resetRanges()
         sliderMax = sliderMaxTemp;
         sliderMin = sliderMinTemp;
         
-        for(int i = 0; i<dataSliders.size(); i++)
-        {
-            Slider* currentSlider = dataSliders.operator[](i);
-            if(currentSlider != nullptr)
-            {
-                currentSlider->setRange(sliderMin, sliderMax, sliderIncrement);
-            }
-        }
-        
         topSlider->setRange(sliderMin, sliderMax, sliderIncrement);
+        
+        repaint();
     }
 }
 
 
 Array<float> BKStackedSlider::getAllActiveValues()
 {
-    Array<float> currentVals;
-    
-    for(int i=0; i<dataSliders.size(); i++)
-    {
-        Slider* currentSlider = dataSliders.operator[](i);
-        if(currentSlider != nullptr)
-        {
-            if(activeSliders.getUnchecked(i))
-                currentVals.add(currentSlider->getValue());
-        }
-        
-    }
-    
-    return currentVals;
+    return dataValues;
 }
 
 int BKStackedSlider::whichSlider()
 {
-    float refDistance;
-    int whichSub = 0;
-    
-    Slider* refSlider = dataSliders.getFirst();
-    refDistance = fabs(refSlider->getValue() - topSlider->getValue());
-    
-    for(int i=1; i<dataSliders.size(); i++)
-    {
-        if(activeSliders.getUnchecked(i))
-        {
-            Slider* currentSlider = dataSliders.operator[](i);
-            if(currentSlider != nullptr) {
-                float tempDistance = fabs(currentSlider->getValue() - topSlider->getValue());
-                if(tempDistance < refDistance)
-                {
-                    whichSub = i;
-                    refDistance = tempDistance;
-                }
-            }
-        }
-    }
-    //DBG("whichSlider = " + String(whichSub));
-    
-    return whichSub;
+    return whichSlider(topSlider->getValue());
 }
 
 int BKStackedSlider::whichSlider(const MouseEvent& e)
 {
-    float refDistance;
-    float topSliderVal = topSlider->proportionOfLengthToValue((double)e.x / getWidth());
-    
+    return whichSlider(topSlider->proportionOfLengthToValue((double)e.x / getWidth()));
+}
+
+//the value nearest to val
+int BKStackedSlider::whichSlider(double val)
+{
     int whichSub = 0;
+    float refDistance = fabs(dataValues.getFirst() - val);
     
-    Slider* refSlider = dataSliders.getFirst();
-    refDistance = fabs(refSlider->getValue() - topSliderVal);
-    
-    for(int i=1; i<dataSliders.size(); i++)
+    for(int i=1; i<dataValues.size(); i++)
     {
-        if(activeSliders.getUnchecked(i))
+        float tempDistance = fabs(dataValues.getUnchecked(i) - val);
+        if(tempDistance < refDistance)
         {
-            Slider* currentSlider = dataSliders.operator[](i);
-            if(currentSlider != nullptr) {
-                float tempDistance = fabs(currentSlider->getValue() - topSliderVal);
-                if(tempDistance < refDistance)
-                {
-                    whichSub = i;
-                    refDistance = tempDistance;
-                }
-            }
+            whichSub = i;
+            refDistance = tempDistance;
         }
     }
     //DBG("whichSlider = " + String(whichSub));
@@ -2428,13 +2128,28 @@ void BKStackedSlider::resized ()
     editValsTextField->setBounds(area);
     editValsTextField->setVisible(false);
     
-    for(int i=0; i<numSliders; i++)
-    {
-        Slider* newSlider = dataSliders.getUnchecked(i);
-        newSlider->setBounds(area);
-    }
-    
+    repaint();
 }
 
-
+//the values are drawn under topSlider, each as BKMultiSliderLookAndFeel draws a bar slider
+void BKStackedSlider::paint (Graphics& g)
+{
+    Rectangle<float> area (getLocalBounds().toFloat());
+    
+    g.setColour(stackedSliderLookAndFeel.findColour(Slider::backgroundColourId).withMultipliedAlpha(dataAlpha));
+    g.fillRect(area);
+    
+    Colour baseColour (stackedSliderLookAndFeel.findColour(Slider::thumbColourId).withMultipliedAlpha (0.8f * dataAlpha));
+    
+    g.setGradientFill (ColourGradient (baseColour.brighter (0.08f), 0.0f, 0.0f,
+                                       baseColour.darker (0.08f), 0.0f, area.getHeight(), false));
+    
+    for (auto val : dataValues)
+        g.fillRect (topSlider->getPositionOfValue(val) - 2, area.getY(), 4.0f, area.getHeight());
+    
+    g.setColour (baseColour.darker (0.2f));
+    
+    for (auto val : dataValues)
+        g.fillRect (topSlider->getPositionOfValue(val), area.getY(), 1.0f, area.getHeight());
+}
 
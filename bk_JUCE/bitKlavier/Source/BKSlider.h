@@ -63,6 +63,9 @@ private:
 // **************************************************  BKMultiSlider ************************************************** //
 // ******************************************************************************************************************** //
 
+//values are kept in arrays and drawn directly, one column per slider (with its subsliders);
+//the user interacts with a single invisible slider laid over the columns, so a long array
+//doesn't mean a long list of child components
 class BKMultiSlider :
 public Component,
 public Slider::Listener,
@@ -126,6 +129,7 @@ public:
     inline int getNumVisible(void) const noexcept { return numVisibleSliders;}
     
     void resized() override;
+    void paint(Graphics& g) override;
     
     class Listener
     {
@@ -177,7 +181,9 @@ private:
     
     double currentInvisibleSliderValue;
     
-    OwnedArray< OwnedArray<BKSubSlider>> sliders;
+    Array<Array<float>> sliderValues;   //one bank per visible slider: its value, then its subsliders'
+    Array<bool> activeSliders;
+    
     ScopedPointer< BKSubSlider> displaySlider;
     ScopedPointer< BKSubSlider> bigInvisibleSlider;
     ScopedPointer< TextEditor> editValsTextField;
@@ -208,8 +214,9 @@ private:
     void showModifyPopupMenu(int which);
     static void sliderModifyMenuCallback (const int result, BKMultiSlider* slider, int which);
     
-    void highlight(int activeSliderNum);
-    void deHighlight(int sliderNum);
+    bool deactivate(int where);
+    Rectangle<int> getSliderBounds(int which);
+    void repaintSlider(int which);
     int getActiveSlider(int sliderNum);
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BKMultiSlider)
@@ -584,15 +591,6 @@ public:
     ~BKStackedSlider()
     {
         topSlider->setLookAndFeel(nullptr);
-        
-        for(int i=0; i<numSliders; i++)
-        {
-            Slider* newSlider = dataSliders.operator[](i);
-            if(newSlider != nullptr)
-            {
-                newSlider->setLookAndFeel(nullptr);
-            }
-        }
     };
     
     void sliderValueChanged (Slider *slider) override;
@@ -622,6 +620,7 @@ public:
     void resetRanges();
     int whichSlider();
     int whichSlider(const MouseEvent& e);
+    int whichSlider(double val);
     void addSlider(NotificationType newnotify);
     
     inline String getText(void) { return editValsTextField->getText(); }
@@ -631,6 +630,7 @@ public:
     String getName()                { return sliderName; }
     
     void resized() override;
+    void paint(Graphics& g) override;
     
     void setDim(float newAlpha);
     void setBright();
@@ -655,12 +655,11 @@ public:
 private:
     
     ScopedPointer<Slider> topSlider; //user interacts with this
-    OwnedArray<Slider> dataSliders;  //displays data, user controls with topSlider
-    Array<bool> activeSliders;
+    Array<float> dataValues;         //drawn under topSlider (see paint), user controls with topSlider
+    float dataAlpha;
     
     ScopedPointer<BKTextEditor> editValsTextField;
     
-    int numSliders;
     int numActiveSliders;
     int clickedSlider;
     float clickedPosition;
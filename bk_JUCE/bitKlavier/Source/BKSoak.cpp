@@ -0,0 +1,395 @@
+/*
+  ==============================================================================
+
+    BKSoak.cpp
+    Created: 19 Oct 2026 3:26:41pm
+    Author:
+
+  ==============================================================================
+*/
+
+#include "BKSoak.h"
+
+#include "PluginProcessor.h"
+
+static float median(Array<float> values)
+{
+    if (values.size() == 0) return 0.0f;
+
+    values.sort();
+
+    return values.getUnchecked(values.size() / 2);
+}
+
+BKSoak::BKSoak(double m, int64 s, int bs, const File& r):
+BKHeadlessRun("soak", bs, r),
+minutesPerGallery(m),
+seed(s),
+random(s),
+pedalDown(false),
+nextNote(0),
+nextPedal(0),
+nextSwitch(0)
+{
+
+}
+
+BKSoak::~BKSoak(void)
+{
+    stopRun();
+}
+
+BKSoak* BKSoak::fromCommandLine(const StringArray& args)
+{
+    bool shouldSoak = false;
+    double minutes = 10.0;
+    int64 seed = 1;
+    int blockSize = 512;
+    String reportPath;
+
+    for (auto arg : args)
+    {
+        const String value = arg.fromFirstOccurrenceOf("=", false, false).unquoted();
+
+        if      (arg.startsWith("--soak-seed="))    seed = value.getLargeIntValue();
+        else if (arg.startsWith("--soak-report="))  reportPath = value;
+        else if (arg.startsWith("--block-size="))   blockSize = value.getIntValue();
+        else if (arg == "--soak" || arg.startsWith("--soak="))
+        {
+            shouldSoak = true;
+            if (value.isNotEmpty()) minutes = value.getDoubleValue();
+        }
+    }
+
+    if (!shouldSoak) return nullptr;
+
+    return new BKSoak(jmax(0.1, minutes), seed, jmax(16, blockSize), getArgumentFile(reportPath));
+}
+
+void BKSoak::runRenders(void)
+{
+    for (int i = 0; i < BinaryData::namedResourceListSize && !threadShouldExit(); i++)
+    {
+        const String resource = BinaryData::namedResourceList[i];
+
+        if (resource.contains("_xml")) soakGallery(resource);
+    }
+
+    // Memory a gallery leaves behind when the next one comes in adds up over the run
+    if (runs.size() > 1)
+    {
+        const int64 first = runs.getFirst()->residentAfter;
+        const int64 last = runs.getLast()->residentAfter;
+
+        if (first > 0 && last > first + jmax((int64) 64 * 1024 * 1024, first / 5))
+        {
+            failures.add("resident memory grew from " + File::descriptionOfSizeInBytes(first) + " after the first gallery to "
+                         + File::descriptionOfSizeInBytes(last) + " after the last");
+        }
+    }
+}
+
+void BKSoak::soakGallery(const String& resource)
+{
+    int size;
+    String xmlData = CharPointer_UTF8 (BinaryData::getNamedResource(resource.toUTF8(), size));
+
+    // Nothing else plays on this processor, so the gallery can be swapped in between blocks
+    processor->loadGalleryFromXml(XmlDocument::parse(xmlData));
+
+    GalleryRun* galleryRun = runs.add(new GalleryRun());
+    galleryRun->name = processor->gallery->getName();
+    galleryRun->residentAfter = -1;
+
+    // Each gallery gets the same playing however many come before it
+    random.setSeed(seed + runs.size());
+    held.clearQuick();
+    pedalDown = false;
+    nextNote = 0;
+    nextPedal = secondsToSamples(2.0);
+    nextSwitch = secondsToSamples(15.0);
+
+    const int64 length = secondsToSamples(minutesPerGallery * 60.0);
+    const int64 tail = secondsToSamples(tailSeconds);
+    const int64 windowLength = secondsToSamples(windowSeconds);
+
+    AudioSampleBuffer buffer(2, blockSize);
+    MidiBuffer midi;
+
+    Array<float> blockMs;
+    blockMs.ensureStorageAllocated((int) (windowLength / blockSize) + 1);
+
+    int maxVoices = 0;
+    int64 windowStart = 0;
+
+    for (int64 position = 0; position < length + tail && !threadShouldExit(); position += blockSize)
+    {
+        midi.clear();
+
+        play(midi, position, position >= length);
+
+        const int64 start = Time::getHighResolutionTicks();
+
+        processor->processBlock(buffer, midi);
+
+        blockMs.add((float) (Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start) * 1000.0));
+        maxVoices = jmax(maxVoices, processor->mainPianoSynth.getNumBusyVoices());
+
+        const int64 end = position + blockSize;
+
+        // The tail lets go of everything, so it isn't part of the trends
+        if (windowStart >= length)
+        {
+            blockMs.clearQuick();
+            continue;
+        }
+
+        if (end - windowStart < windowLength && end < length) continue;
+
+        Window window;
+        window.seconds = end / sampleRate;
+        window.resident = getResidentMemory();
+        window.maxVoices = maxVoices;
+
+        blockMs.sort();
+        window.p50 = blockMs.getUnchecked((blockMs.size() - 1) / 2);
+        window.p99 = blockMs.getUnchecked((int) ((blockMs.size() - 1) * 0.99));
+        window.maxMs = blockMs.getLast();
+
+        BKMemoryReport report("bitKlavier");
+        processor->reportMemory(report);
+        addCounts(*galleryRun, window, report, String());
+
+        galleryRun->windows.add(window);
+
+        blockMs.clearQuick();
+        maxVoices = 0;
+        windowStart = end;
+    }
+
+    galleryRun->residentAfter = getResidentMemory();
+
+    check(*galleryRun);
+
+    int mostVoices = 0;
+    float worstP99 = 0.0f;
+
+    for (auto& window : galleryRun->windows)
+    {
+        mostVoices = jmax(mostVoices, window.maxVoices);
+        worstP99 = jmax(worstP99, window.p99);
+    }
+
+    String text;
+
+    text << "soak: " << galleryRun->name << ", " << galleryRun->windows.size() << " windows, " << mostVoices << " voices at most, p99 "
+         << String(worstP99, 3) << " ms at worst, " << File::descriptionOfSizeInBytes(galleryRun->residentAfter) << " resident, "
+         << (galleryRun->failures.size() ? "FAILED" : "ok");
+
+    for (auto failure : galleryRun->failures)
+    {
+        text << newLine << "    " << failure;
+        failures.add(galleryRun->name + ": " + failure);
+    }
+
+    std::cout << text << std::endl;
+    DBG(text);
+}
+
+void BKSoak::play(MidiBuffer& midi, int64 position, bool letGo)
+{
+    const int64 end = position + blockSize;
+
+    for (int i = held.size(); --i >= 0;)
+    {
+        const HeldNote& h = held.getReference(i);
+
+        if (!letGo && h.off >= end) continue;
+
+        midi.addEvent(MidiMessage::noteOff(1, h.note), letGo ? 0 : (int) jmax((int64) 0, h.off - position));
+        held.remove(i);
+    }
+
+    if (letGo)
+    {
+        if (pedalDown) midi.addEvent(MidiMessage::controllerEvent(1, 64, 0), 0);
+        pedalDown = false;
+
+        return;
+    }
+
+    while (nextNote < end)
+    {
+        const int offset = (int) jmax((int64) 0, nextNote - position);
+
+        // Mostly single notes, now and then a chord
+        const int numNotes = (random.nextInt(5) == 0) ? 3 + random.nextInt(3) : 1;
+        const int root = 21 + random.nextInt(88);
+
+        for (int n = 0, note = root; n < numNotes && held.size() < maxHeldNotes; n++, note += 3 + random.nextInt(3))
+        {
+            midi.addEvent(MidiMessage::noteOn(1, jmin(note, 108), (uint8) (20 + random.nextInt(108))), offset);
+
+            HeldNote h = { jmin(note, 108), nextNote + secondsToSamples(0.05 + random.nextDouble() * 2.0) };
+            held.add(h);
+        }
+
+        nextNote += secondsToSamples(0.02 + random.nextDouble() * 0.25);
+    }
+
+    while (nextPedal < end)
+    {
+        pedalDown = !pedalDown;
+        midi.addEvent(MidiMessage::controllerEvent(1, 64, pedalDown ? 127 : 0), (int) jmax((int64) 0, nextPedal - position));
+
+        nextPedal += secondsToSamples(1.0 + random.nextDouble() * 6.0);
+    }
+
+    // Pianos also change from piano maps as the keys hit them; this gets every gallery switching
+    if (nextSwitch < end)
+    {
+        Piano::PtrArr pianos = processor->gallery->getPianos();
+
+        if (pianos.size() > 1) processor->setCurrentPiano(pianos.getUnchecked(random.nextInt(pianos.size()))->getId());
+
+        nextSwitch += secondsToSamples(15.0 + random.nextDouble() * 45.0);
+    }
+}
+
+void BKSoak::check(GalleryRun& galleryRun)
+{
+    const int numWindows = galleryRun.windows.size();
+
+    // Too short to tell a trend from the start
+    if (numWindows < 8) return;
+
+    const int warmup = numWindows / 10;
+    const int half = numWindows / 2;
+    const int lastQuarter = numWindows * 3 / 4;
+
+    for (int c = 0; c < galleryRun.containers.size(); c++)
+    {
+        int earlyMax = 0, lateMin = INT_MAX;
+
+        for (int w = warmup; w < numWindows; w++)
+        {
+            const Array<int>& counts = galleryRun.windows.getReference(w).counts;
+            const int count = (c < counts.size()) ? counts.getUnchecked(c) : 0;
+
+            if (w < half)               earlyMax = jmax(earlyMax, count);
+            else if (w >= lastQuarter)  lateMin = jmin(lateMin, count);
+        }
+
+        // Bounded containers come and go with the playing; one that never gets back down is growing
+        if (lateMin != INT_MAX && lateMin > earlyMax * 2 + 32)
+        {
+            galleryRun.failures.add(galleryRun.containers[c] + " grew from " + String(earlyMax) + " to " + String(lateMin));
+        }
+    }
+
+    Array<float> early, late;
+
+    for (int w = warmup; w < numWindows; w++)
+    {
+        const float p99 = galleryRun.windows.getReference(w).p99;
+
+        if (w < half)               early.add(p99);
+        else if (w >= lastQuarter)  late.add(p99);
+    }
+
+    const float earlyP99 = median(early), lateP99 = median(late);
+
+    if (lateP99 > earlyP99 * 1.5f + 0.05f)
+    {
+        galleryRun.failures.add("block time p99 drifted from " + String(earlyP99, 3) + " ms to " + String(lateP99, 3) + " ms");
+    }
+}
+
+void BKSoak::addCounts(GalleryRun& galleryRun, Window& window, const BKMemoryReport& report, const String& path)
+{
+    for (int i = 0; i < report.getNumParts(); i++)
+    {
+        const BKMemoryReport& part = report.getPart(i);
+
+        // Shared parts are counted elsewhere, and the sample bank only grows to what the gallery plays
+        if (part.isShared() || (path.isEmpty() && part.getName() == "samples")) continue;
+
+        const String name = path.isEmpty() ? part.getName() : path + " / " + part.getName();
+
+        int index = galleryRun.containers.indexOf(name);
+
+        if (index < 0)
+        {
+            index = galleryRun.containers.size();
+            galleryRun.containers.add(name);
+        }
+
+        while (window.counts.size() <= index) window.counts.add(0);
+
+        window.counts.set(index, part.getCount());
+
+        addCounts(galleryRun, window, part, name);
+    }
+}
+
+bool BKSoak::report(String& text, DynamicObject& json)
+{
+    text << "soak: " << runs.size() << " galleries, " << String(minutesPerGallery, 1) << " minutes each, seed " << seed << ", "
+         << (failures.size() ? String(failures.size()) + " failures" : String("ok"));
+
+    for (auto failure : failures) text << newLine << "    " << failure;
+
+    if (reportFile != File())
+    {
+        var runVars;
+
+        for (auto galleryRun : runs)
+        {
+            DynamicObject::Ptr runObj = new DynamicObject();
+
+            runObj->setProperty("gallery", galleryRun->name);
+            runObj->setProperty("residentAfter", galleryRun->residentAfter);
+
+            var failureVars;
+            for (auto failure : galleryRun->failures) failureVars.append(failure);
+            runObj->setProperty("failures", failureVars);
+
+            var windowVars;
+
+            for (auto& window : galleryRun->windows)
+            {
+                DynamicObject::Ptr windowObj = new DynamicObject();
+
+                windowObj->setProperty("seconds", window.seconds);
+                windowObj->setProperty("resident", window.resident);
+                windowObj->setProperty("maxVoices", window.maxVoices);
+                windowObj->setProperty("p50", window.p50);
+                windowObj->setProperty("p99", window.p99);
+                windowObj->setProperty("max", window.maxMs);
+
+                DynamicObject::Ptr countsObj = new DynamicObject();
+                for (int c = 0; c < window.counts.size(); c++)
+                    countsObj->setProperty(galleryRun->containers[c], window.counts.getUnchecked(c));
+
+                windowObj->setProperty("counts", var(countsObj.get()));
+
+                windowVars.append(var(windowObj.get()));
+            }
+
+            runObj->setProperty("windows", windowVars);
+
+            runVars.append(var(runObj.get()));
+        }
+
+        json.setProperty("seed", seed);
+        json.setProperty("minutesPerGallery", minutesPerGallery);
+        json.setProperty("blockSize", blockSize);
+        json.setProperty("galleries", runVars);
+
+        var failureVars;
+        for (auto failure : failures) failureVars.append(failure);
+        json.setProperty("failures", failureVars);
+    }
+
+    return failures.size() == 0;
+}
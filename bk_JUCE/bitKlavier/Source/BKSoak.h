@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    BKSoak.h
+    Created: 19 Oct 2026 3:26:41pm
+    Author:
+
+    A soak test: hours of playing in minutes. Every gallery bundled with
+    the app gets played in turn by a seeded random player (notes, chords,
+    the pedal, switches between the gallery's pianos, and whatever
+    modifications and resets its keys set off). Blocks go through
+    processBlock on a processor of our own, as fast as they render.
+
+    Every window of audio we note the process's resident memory, the
+    busiest the voices got, block time percentiles, and the count of
+    every part of the memory report. That covers the containers that grow
+    with playing: nostalgic notes, direct keys played, sustained notes,
+    tempo history and the previous pianos list.
+
+    A gallery fails if any of those counts keeps growing, or if its block
+    times drift up, over the run. The whole soak fails if resident memory
+    climbs from gallery to gallery. The standalone app runs it from the
+    command line:
+
+        bitKlavier --soak[=<minutes per gallery>] [--soak-seed=<n>]
+                   [--block-size=<n>] [--soak-report=<file>]
+
+    It prints a line per gallery, writes every window to the report as
+    JSON if asked, and quits with 1 if anything failed.
+
+  ==============================================================================
+*/
+
+#ifndef BKSOAK_H_INCLUDED
+#define BKSOAK_H_INCLUDED
+
+#include "BKUtilities.h"
+
+#include "BKHeadlessRun.h"
+
+class BKMemoryReport;
+
+class BKSoak : public BKHeadlessRun
+{
+public:
+    BKSoak(double minutesPerGallery, int64 seed, int blockSize, const File& report);
+    ~BKSoak(void);
+
+    // Looks for --soak on the command line and, if it's there, starts one. Standalone app only.
+    static BKSoak* fromCommandLine(const StringArray& args);
+
+    enum
+    {
+        windowSeconds = 10,
+        tailSeconds = 5,        // rendered after letting go of everything, before the next gallery
+        maxHeldNotes = 16
+    };
+
+private:
+    struct Window
+    {
+        double seconds;
+        int64 resident;
+        int maxVoices;
+        float p50, p99, maxMs;
+        Array<int> counts;      // by GalleryRun::containers
+    };
+
+    struct GalleryRun
+    {
+        String name;
+        StringArray containers;
+        Array<Window> windows;
+        StringArray failures;
+        int64 residentAfter;
+    };
+
+    struct HeldNote
+    {
+        int note;
+        int64 off;
+    };
+
+    double minutesPerGallery;
+    int64 seed;
+
+    OwnedArray<GalleryRun> runs;
+    StringArray failures;
+
+    // The player; soak thread only
+    Random random;
+    Array<HeldNote> held;
+    bool pedalDown;
+    int64 nextNote, nextPedal, nextSwitch;
+
+    void runRenders(void) override;
+    bool report(String& text, DynamicObject& json) override;
+
+    void soakGallery(const String& resource);
+    void play(MidiBuffer& midi, int64 position, bool letGo);
+    void check(GalleryRun& galleryRun);
+
+    void addCounts(GalleryRun& galleryRun, Window& window, const BKMemoryReport& report, const String& path);
+
+    int64 secondsToSamples(double seconds) const { return (int64) (seconds * sampleRate); }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BKSoak)
+};
+
+
+#endif  // BKSOAK_H_INCLUDED
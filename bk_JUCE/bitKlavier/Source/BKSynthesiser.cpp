@@ -10,7 +10,10 @@
 
 #include "BKSynthesiser.h"
 
-BKSynthesiserSound::BKSynthesiserSound() {}
+#include "BKPianoVoiceBatch.h"
+#include "BKVoiceRenderPool.h"
+
+BKSynthesiserSound::BKSynthesiserSound() : lastPlayed (0) {}
 BKSynthesiserSound::~BKSynthesiserSound() {}
 
 //==============================================================================
@@ -18,6 +21,10 @@ BKSynthesiserVoice::BKSynthesiserVoice()
 : currentSampleRate (44100.0),
 currentlyPlayingNote (-1),
 currentPlayingMidiChannel (0),
+soundSet (MainSoundSet),
+outputPeak (-1.0f),
+lastOutputPeak (-1.0f),
+quietSamples (0),
 noteOnTime (0),
 keyIsDown (false),
 sustainPedalDown (false),
@@ -79,11 +86,21 @@ bool BKSynthesiserVoice::wasStartedBefore (const BKSynthesiserVoice& other) cons
     lastNoteOnCounter (0),
     minimumSubBlockSize (32),
     subBlockSubdivisionIsStrict (false),
-    shouldStealNotes (true)
+    shouldStealNotes (true),
+    renderPool (nullptr),
+    voiceQueue (voiceQueueSize),
+    minPoolVoices (0),
+    maxPoolVoices (0),
+    cullLevel (0.0f),
+    cullHoldMs (0.0f),
+    renderBudget (0.0)
     {
         for (int i = 0; i < numElementsInArray (lastPitchWheelValues); ++i)
             lastPitchWheelValues[i] = 0x2000;
         
+#if SOA_VOICE_RENDERING
+        setVoiceBatching (true);
+#endif
     }
     
     BKSynthesiser::BKSynthesiser(void):
@@ -91,11 +108,21 @@ bool BKSynthesiserVoice::wasStartedBefore (const BKSynthesiserVoice& other) cons
     lastNoteOnCounter (0),
     minimumSubBlockSize (32),
     subBlockSubdivisionIsStrict (false),
-    shouldStealNotes (true)
+    shouldStealNotes (true),
+    renderPool (nullptr),
+    voiceQueue (voiceQueueSize),
+    minPoolVoices (0),
+    maxPoolVoices (0),
+    cullLevel (0.0f),
+    cullHoldMs (0.0f),
+    renderBudget (0.0)
     {
         for (int i = 0; i < numElementsInArray (lastPitchWheelValues); ++i)
             lastPitchWheelValues[i] = 0x2000;
         
+#if SOA_VOICE_RENDERING
+        setVoiceBatching (true);
+#endif
     }
     
     void BKSynthesiser::setGeneralSettings(GeneralSettings::Ptr gen)
@@ -113,6 +140,12 @@ bool BKSynthesiserVoice::wasStartedBefore (const BKSynthesiserVoice& other) cons
     
     BKSynthesiser::~BKSynthesiser()
     {
+        // Voices that were never picked up
+        int start1, size1, start2, size2;
+        voiceQueue.prepareToRead (voiceQueue.getNumReady(), start1, size1, start2, size2);
+        
+        for (int i = 0; i < size1; i++) delete queuedVoices [start1 + i];
+        for (int i = 0; i < size2; i++) delete queuedVoices [start2 + i];
     }
     
     //==============================================================================
@@ -126,12 +159,19 @@ bool BKSynthesiserVoice::wasStartedBefore (const BKSynthesiserVoice& other) cons
     {
         const ScopedLock sl (lock);
         voices.clear();
+        voices.ensureStorageAllocated (maxPoolVoices);
+        numPoolVoices.set (0);
     }
     
     BKSynthesiserVoice* BKSynthesiser::addVoice (BKSynthesiserVoice* const newVoice)
     {
         const ScopedLock sl (lock);
         newVoice->setCurrentPlaybackSampleRate (sampleRate);
+        
+        if (batch != nullptr) batch->prepare (voices.size() + 1);
+        
+        numPoolVoices.set (voices.size() + 1);
+        
         return voices.add (newVoice);
     }
     
@@ -139,24 +179,250 @@ bool BKSynthesiserVoice::wasStartedBefore (const BKSynthesiserVoice& other) cons
     {
         const ScopedLock sl (lock);
         voices.remove (index);
+        numPoolVoices.set (voices.size());
+    }
+    
+    BKSoundSet BKSynthesiser::getSoundSet (const BKNoteType bktype) noexcept
+    {
+        if (bktype == HammerNote)       return HammerSoundSet;
+        if (bktype == ResonanceNote)    return ResonanceSoundSet;
+        
+        return MainSoundSet;
     }
     
     void BKSynthesiser::clearSounds()
     {
         const ScopedLock sl (lock);
-        sounds.clear();
+        
+        for (int set = 0; set < BKSoundSetNil; ++set)
+            sounds[set].clear();
+    }
+    
+    BKSynthesiserSound* BKSynthesiser::addSound (const BKSynthesiserSound::Ptr& newSound, const BKSoundSet set)
+    {
+        const ScopedLock sl (lock);
+        return sounds[set].add (newSound);
+    }
+    
+    void BKSynthesiser::removeSound (const int index, const BKSoundSet set)
+    {
+        const ScopedLock sl (lock);
+        sounds[set].remove (index);
+    }
+    
+    void BKSynthesiser::setSounds (ReferenceCountedArray<BKSynthesiserSound>& newSounds, const BKSoundSet set)
+    {
+        const ScopedLock sl (lock);
+        sounds[set].swapWith (newSounds);
     }
     
-    BKSynthesiserSound* BKSynthesiser::addSound (const BKSynthesiserSound::Ptr& newSound)
+    void BKSynthesiser::setVoiceBatching (const bool shouldBatch)
     {
+        ScopedPointer<BKPianoVoiceBatch> newBatch;
+        
+        if (shouldBatch)
+        {
+            newBatch = new BKPianoVoiceBatch();
+            newBatch->prepare (voices.size());
+        }
+        
         const ScopedLock sl (lock);
-        return sounds.add (newSound);
+        batch.swapWith (newBatch);
     }
     
-    void BKSynthesiser::removeSound (const int index)
+    void BKSynthesiser::setRenderPool (BKVoiceRenderPool* pool)
     {
         const ScopedLock sl (lock);
-        sounds.remove (index);
+        renderPool = pool;
+    }
+    
+    void BKSynthesiser::setVoicePoolLimits (const int minVoices, const int maxVoices)
+    {
+        const ScopedLock sl (lock);
+        
+        minPoolVoices = minVoices;
+        maxPoolVoices = jmax (minVoices, maxVoices);
+        
+        // So the audio thread never has to grow these
+        voices.ensureStorageAllocated (maxPoolVoices);
+        governedVoices.ensureStorageAllocated (maxPoolVoices);
+        if (batch != nullptr) batch->prepare (maxPoolVoices);
+    }
+    
+    int BKSynthesiser::getNumVoicesWanted() const noexcept
+    {
+        const int numVoices = numPoolVoices.get() + voiceQueue.getNumReady();
+        
+        int target = minPoolVoices;
+        
+        // High-water mark: grow by half again once three quarters are busy
+        if (busyVoices.get() * 4 > numVoices * 3) target = jmax (target, numVoices + jmax (16, numVoices / 2));
+        
+        target = jmin (target, maxPoolVoices);
+        
+        return jlimit (0, voiceQueue.getFreeSpace(), target - numVoices);
+    }
+    
+    bool BKSynthesiser::queueVoice (BKSynthesiserVoice* newVoice)
+    {
+        int start1, size1, start2, size2;
+        voiceQueue.prepareToWrite (1, start1, size1, start2, size2);
+        
+        if (size1 + size2 < 1) return false;
+        
+        queuedVoices [size1 > 0 ? start1 : start2] = newVoice;
+        voiceQueue.finishedWrite (1);
+        
+        return true;
+    }
+    
+    void BKSynthesiser::takeQueuedVoices()
+    {
+        const int numReady = voiceQueue.getNumReady();
+        
+        // Nothing to pick up, or no room reserved for them
+        if (numReady == 0 || voices.size() + numReady > maxPoolVoices) return;
+        
+        int start1, size1, start2, size2;
+        voiceQueue.prepareToRead (numReady, start1, size1, start2, size2);
+        
+        for (int i = 0; i < size1 + size2; i++)
+        {
+            BKSynthesiserVoice* newVoice = queuedVoices [(i < size1) ? start1 + i : start2 + i - size1];
+            
+            newVoice->setCurrentPlaybackSampleRate (sampleRate);
+            voices.add (newVoice);
+        }
+        
+        voiceQueue.finishedRead (size1 + size2);
+        
+        numPoolVoices.set (voices.size());
+    }
+    
+    void BKSynthesiser::setVoiceCulling (const float floorDecibels, const float holdMs)
+    {
+        const ScopedLock sl (lock);
+        
+        cullLevel = Decibels::decibelsToGain (floorDecibels);
+        cullHoldMs = holdMs;
+    }
+    
+    void BKSynthesiser::setRenderBudget (const double proportionOfBlock)
+    {
+        const ScopedLock sl (lock);
+        renderBudget = proportionOfBlock;
+    }
+    
+    void BKSynthesiser::reportMemory (BKMemoryReport& report) const
+    {
+        static const char* const setNames[BKSoundSetNil] = { "main sounds", "hammer sounds", "resonance sounds" };
+        
+        const ScopedLock sl (lock);
+        
+        report.addBytes (sizeof (BKSynthesiser));
+        
+        BKMemoryReport& voiceReport = report.add ("voices");
+        for (auto voice : voices) voiceReport.addBytes (voice->getMemoryUsage(), 1);
+        
+        if (batch != nullptr) report.add ("voice batch", batch->getMemoryUsage());
+        
+        for (int set = 0; set < BKSoundSetNil; ++set)
+        {
+            BKMemoryReport& soundReport = report.add (setNames[set]);
+            int64 sampleBytes = 0;
+            
+            for (auto sound : sounds[set])
+            {
+                soundReport.addBytes (sound->getMemoryUsage(), 1);
+                sampleBytes += sound->getSharedMemoryUsage();
+            }
+            
+            // Held by the sample bank, which reports them
+            soundReport.add ("samples", sampleBytes).setShared (true);
+        }
+    }
+    
+    void BKSynthesiser::cullQuietVoices (const int numSamples)
+    {
+        if (cullLevel <= 0.0f) return;
+        
+        const int holdSamples = (int) (cullHoldMs * 0.001f * sampleRate);
+        
+        for (int i = voices.size(); --i >= 0;)
+        {
+            BKSynthesiserVoice* const voice = voices.getUnchecked (i);
+            
+            // Nothing heard yet, e.g. a reverse note that hasn't reached its sample
+            if (! voice->isVoiceActive() || voice->outputPeak < 0.0f) continue;
+            
+            const bool rising = voice->outputPeak > voice->lastOutputPeak;
+            voice->lastOutputPeak = voice->outputPeak;
+            
+            // Reverse notes and slow attacks start out quiet on their way up to the loud part
+            if (voice->outputPeak >= cullLevel || voice->isPlayingReverse() || voice->isRampingOn())
+            {
+                voice->quietSamples = 0;
+                continue;
+            }
+            
+            // Getting louder isn't dying away; a tail's small ups and downs only put off its cull a little
+            if (rising) continue;
+            
+            voice->quietSamples += numSamples;
+            
+            if (voice->quietSamples >= holdSamples)
+            {
+                stopVoice (voice, 0.0f, false);
+                ++numCulledVoices;
+            }
+        }
+    }
+    
+    struct VoiceLoudnessSorter
+    {
+        // Quietest first, oldest first among equals; voices not heard yet go last
+        static int compareElements (BKSynthesiserVoice* v1, BKSynthesiserVoice* v2) noexcept
+        {
+            const float p1 = (v1->getOutputPeak() < 0.0f) ? std::numeric_limits<float>::max() : v1->getOutputPeak();
+            const float p2 = (v2->getOutputPeak() < 0.0f) ? std::numeric_limits<float>::max() : v2->getOutputPeak();
+            
+            if (p1 != p2) return (p1 < p2) ? -1 : 1;
+            
+            return v1->wasStartedBefore (*v2) ? -1 : (v2->wasStartedBefore (*v1) ? 1 : 0);
+        }
+    };
+    
+    void BKSynthesiser::governVoices (const double renderSeconds, const int numSamples)
+    {
+        if (renderBudget <= 0.0) return;
+        
+        const double budgetSeconds = renderBudget * numSamples / sampleRate;
+        
+        if (renderSeconds <= budgetSeconds) return;
+        
+        // Voices already fading out are on their way
+        governedVoices.clearQuick();
+        
+        for (int i = voices.size(); --i >= 0;)
+        {
+            BKSynthesiserVoice* const voice = voices.getUnchecked (i);
+            
+            if (voice->isVoiceActive() && ! voice->isTailingOff()) governedVoices.add (voice);
+        }
+        
+        if (governedVoices.size() == 0) return;
+        
+        // Each voice costs about the same, so release the share of them that went over
+        const double over = (renderSeconds - budgetSeconds) / renderSeconds;
+        const int numToDrop = jlimit (1, governedVoices.size(), (int) std::ceil (governedVoices.size() * over));
+        
+        VoiceLoudnessSorter sorter;
+        governedVoices.sort (sorter);
+        
+        for (int i = 0; i < numToDrop; ++i)
+            stopVoice (governedVoices.getUnchecked (i), 0.0f, true);
+        
+        numDroppedVoices += numToDrop;
     }
     
     void BKSynthesiser::setNoteStealingEnabled (const bool shouldSteal)
@@ -205,12 +471,31 @@ bool BKSynthesiserVoice::wasStartedBefore (const BKSynthesiserVoice& other) cons
         
         const ScopedLock sl (lock);
         
+        takeQueuedVoices();
+        
+        // Notes for this block have been started by now
+        int busy = 0;
+        for (int i = voices.size(); --i >= 0;)
+        {
+            BKSynthesiserVoice* const voice = voices.getUnchecked (i);
+            
+            if (voice->isVoiceActive()) ++busy;
+            
+            voice->outputPeak = -1.0f;
+        }
+        
+        busyVoices.set (busy);
+        if (busy > peakVoices.get()) peakVoices.set (busy);
+        
+        const int blockSize = numSamples;
+        const int64 renderStart = Time::getHighResolutionTicks();
+        
         while (numSamples > 0)
         {
             if (! midiIterator.getNextEvent (m, midiEventPos))
             {
                 renderVoices (outputAudio, startSample, numSamples);
-                return;
+                break;
             }
             
             const int samplesToNextMidiMessage = midiEventPos - startSample;
@@ -238,6 +523,9 @@ bool BKSynthesiserVoice::wasStartedBefore (const BKSynthesiserVoice& other) cons
         
         while (midiIterator.getNextEvent (m, midiEventPos))
             handleMidiEvent (m);
+        
+        cullQuietVoices (blockSize);
+        governVoices (Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - renderStart), blockSize);
     }
     
     // explicit template instantiation
@@ -252,6 +540,15 @@ bool BKSynthesiserVoice::wasStartedBefore (const BKSynthesiserVoice& other) cons
     
     void BKSynthesiser::renderVoices (AudioBuffer<float>& buffer, int startSample, int numSamples)
     {
+        // Falls through to serial rendering when there are too few voices to split up
+        if (renderPool != nullptr && renderPool->render (voices, buffer, startSample, numSamples)) return;
+        
+        if (batch != nullptr)
+        {
+            batch->render (voices, buffer, startSample, numSamples);
+            return;
+        }
+        
         for (int i = voices.size(); --i >= 0;)
             voices.getUnchecked (i)->renderNextBlock (buffer, startSample, numSamples);
     }
@@ -328,18 +625,34 @@ bool BKSynthesiserVoice::wasStartedBefore (const BKSynthesiserVoice& other) cons
         
         float transposition = transp;
         
-        for (int i = sounds.size(); --i >= 0;)
+        const BKSoundSet set = getSoundSet (bktype);
+        
+        for (int i = sounds[set].size(); --i >= 0;)
         {
-            BKSynthesiserSound* const sound = sounds.getUnchecked(i);
+            BKSynthesiserSound* const sound = sounds[set].getUnchecked(i);
             
             // Check if sound applies to note, velocity, and channel.
             if (sound->appliesToNote (noteNumber)
                 && sound->appliesToVelocity((int)(velocity * 127.0))
                 && sound->appliesToChannel (midiChannel))
             {
+                BKSynthesiserSound* soundToPlay = sound;
+                
+                sound->lastPlayed = lastNoteOnCounter + 1;
+                
+                // Not loaded yet: ask for it, and play the nearest loaded layer meanwhile
+                if (! sound->isReady())
+                {
+                    sound->requestData();
+                    
+                    soundToPlay = findStandIn (set, midiChannel, noteNumber, (int)(velocity * 127.0));
+                    
+                    if (soundToPlay == nullptr) continue;
+                }
+                
                 //DBG("BKSynthesiser::keyOn " + String(noteNumber));
-                startVoice (findFreeVoice (sound, midiChannel, noteNumber, shouldStealNotes),
-                            sound,
+                startVoice (findFreeVoice (soundToPlay, midiChannel, noteNumber, shouldStealNotes),
+                            soundToPlay,
                             midiChannel,
                             keyNoteNumber,
                             noteNumber,
@@ -389,6 +702,10 @@ bool BKSynthesiserVoice::wasStartedBefore (const BKSynthesiserVoice& other) cons
             voice->length = (int)length;
             voice->type = type;
             voice->bktype = bktype;
+            voice->soundSet = getSoundSet (bktype);
+            voice->outputPeak = -1.0f;
+            voice->lastOutputPeak = -1.0f;
+            voice->quietSamples = 0;
             voice->currentPlayingMidiChannel = midiChannel;
             voice->noteOnTime = ++lastNoteOnCounter;
             voice->currentlyPlayingSound = sound;
@@ -643,6 +960,7 @@ bool BKSynthesiserVoice::wasStartedBefore (const BKSynthesiserVoice& other) cons
                                                          int /*midiChannel*/, int midiNoteNumber) const
     {
         // This voice-stealing algorithm applies the following heuristics:
+        // - Hammer and resonance voices go before any main voice
         // - Re-use the oldest notes first
         // - Protect the lowest & topmost notes, even if sustained, but not if they've been released.
         
@@ -687,6 +1005,15 @@ bool BKSynthesiserVoice::wasStartedBefore (const BKSynthesiserVoice& other) cons
         
         const int numUsableVoices = usableVoices.size();
         
+        // Oldest hammer or resonance voice: short and quiet, so the cheapest to lose
+        for (int i = 0; i < numUsableVoices; ++i)
+        {
+            BKSynthesiserVoice* const voice = usableVoices.getUnchecked (i);
+            
+            if (voice->getSoundSet() != MainSoundSet)
+                return voice;
+        }
+        
         // The oldest note that's playing with the target pitch is ideal..
         for (int i = 0; i < numUsableVoices; ++i)
         {
@@ -733,3 +1060,34 @@ bool BKSynthesiserVoice::wasStartedBefore (const BKSynthesiserVoice& other) cons
         return low;
     }
     
+    BKSynthesiserSound* BKSynthesiser::findStandIn (const BKSoundSet set,
+                                                    const int midiChannel,
+                                                    const int midiNoteNumber,
+                                                    const int midiVelocity) const
+    {
+        const ScopedLock sl (lock);
+        
+        BKSynthesiserSound* nearest = nullptr;
+        int nearestDistance = std::numeric_limits<int>::max();
+        
+        for (int i = sounds[set].size(); --i >= 0;)
+        {
+            BKSynthesiserSound* const sound = sounds[set].getUnchecked (i);
+            
+            if (sound->isReady()
+                && sound->appliesToNote (midiNoteNumber)
+                && sound->appliesToChannel (midiChannel))
+            {
+                const int distance = sound->getVelocityDistance (midiVelocity);
+                
+                if (distance < nearestDistance)
+                {
+                    nearest = sound;
+                    nearestDistance = distance;
+                }
+            }
+        }
+        
+        return nearest;
+    }
+    
@@ -17,6 +17,10 @@
 
 #include "General.h"
 
+#include "BKMemoryReport.h"
+
+class BKPianoVoiceBatch;
+class BKVoiceRenderPool;
 
 //==============================================================================
 /**
@@ -63,6 +67,28 @@ public:
      */
     virtual bool appliesToChannel (int midiChannel) = 0;
     
+    /** Returns false while the sound's audio is still to be loaded.
+     
+     The BKSynthesiser then asks for it with requestData() and plays the nearest
+     ready sound for the note instead (see getVelocityDistance()).
+     */
+    virtual bool isReady() { return true; }
+    
+    /** Called from the audio thread when a note wanted this sound before it was ready. */
+    virtual void requestData() {}
+    
+    /** How far a midi velocity is from the velocities this sound is played at, 0 if it is one of them. */
+    virtual int getVelocityDistance (int midiNoteVelocity) { return appliesToVelocity (midiNoteVelocity) ? 0 : 128; }
+    
+    /** Note on counter of the last note that wanted this sound. */
+    uint32 lastPlayed;
+    
+    /** Bytes this sound holds for itself. */
+    virtual int64 getMemoryUsage() const { return sizeof (BKSynthesiserSound); }
+    
+    /** Bytes of audio this sound plays that are shared with other sounds or instances. */
+    virtual int64 getSharedMemoryUsage() const { return 0; }
+    
     
     /** The class is reference-counted, so this is a handy pointer class for it. */
     typedef ReferenceCountedObjectPtr<BKSynthesiserSound> Ptr;
@@ -105,6 +131,12 @@ public:
      */
     BKSynthesiserSound::Ptr getCurrentlyPlayingSound() const noexcept     { return currentlyPlayingSound; }
     
+    /** Returns which set of sounds the voice is playing from (main, hammer or resonance). */
+    BKSoundSet getSoundSet() const noexcept                              { return soundSet; }
+    
+    /** Bytes this voice holds. */
+    virtual int64 getMemoryUsage() const                                 { return sizeof (BKSynthesiserVoice); }
+    
     /** Must return true if this voice object is capable of playing the given sound.
      
      If there are different classes of sound, and different classes of voice, a voice can
@@ -153,6 +185,21 @@ public:
      */
     virtual bool isVoiceActive() const;
     
+    /** Returns true if the voice has been told to stop and is fading out. */
+    virtual bool isTailingOff() const                                   { return false; }
+    
+    /** Called while rendering with the loudest sample the voice has just written,
+     after its gains. The synth stops voices that stay too quiet to hear.
+     */
+    void noteOutputPeak (float peak) noexcept                           { if (peak > outputPeak) outputPeak = peak; }
+    float getOutputPeak() const noexcept                                { return outputPeak; }
+    
+    /** Returns true if the voice reads its sound backwards, so it gets louder as it goes. */
+    virtual bool isPlayingReverse() const                               { return false; }
+    
+    /** Returns true while the voice is still ramping up to its full level. */
+    virtual bool isRampingOn() const                                    { return false; }
+    
     /** Called to let the voice know that the pitch wheel has been moved.
      This will be called during the rendering callback, so must be fast and thread-safe.
      */
@@ -269,7 +316,11 @@ private:
     PianoSamplerNoteType direction;
     PianoSamplerNoteType type;
     BKNoteType bktype;
+    BKSoundSet soundSet;
     int layerId;
+    float outputPeak;       // loudest this block, or less than 0 if nothing has been heard yet
+    float lastOutputPeak;   // outputPeak of the block before
+    int quietSamples;       // how long it's been below the synth's cull level
     uint32 noteOnTime;
     BKSynthesiserSound::Ptr currentlyPlayingSound;
     bool keyIsDown, sustainPedalDown, sostenutoPedalDown;
@@ -309,7 +360,7 @@ private:
  what the target playback rate is. This value is passed on to the voices so that
  they can pitch their output correctly.
  */
-class JUCE_API  BKSynthesiser
+class JUCE_API  BKSynthesiser    : public BKMemoryAccountable
 {
 public:
     //==============================================================================
@@ -349,24 +400,98 @@ public:
     void removeVoice (int index);
     
     //==============================================================================
-    /** Deletes all sounds. */
+    /** Sounds come in sets: the main piano, hammer releases and resonance releases.
+     keyOn() picks the set from the note's BKNoteType, and every set plays on the
+     same voices, so there is one pool, one polyphony limit and one render pass.
+     */
+    static BKSoundSet getSoundSet (BKNoteType bktype) noexcept;
+    
+    /** Deletes all sounds, in every set. */
     void clearSounds();
     
-    /** Returns the number of sounds that have been added to the synth. */
-    int getNumSounds() const noexcept                               { return sounds.size(); }
+    /** Returns the number of sounds that have been added to a set. */
+    int getNumSounds (BKSoundSet set = MainSoundSet) const noexcept    { return sounds[set].size(); }
     
     /** Returns one of the sounds. */
-    BKSynthesiserSound* getSound (int index) const noexcept           { return sounds [index]; }
+    BKSynthesiserSound* getSound (int index, BKSoundSet set = MainSoundSet) const noexcept      { return sounds[set] [index]; }
     
     /** Adds a new sound to the BKSynthesiser.
      
      The object passed in is reference counted, so will be deleted when the
      BKSynthesiser and all voices are no longer using it.
      */
-    BKSynthesiserSound* addSound (const BKSynthesiserSound::Ptr& newSound);
+    BKSynthesiserSound* addSound (const BKSynthesiserSound::Ptr& newSound, BKSoundSet set = MainSoundSet);
     
     /** Removes and deletes one of the sounds. */
-    void removeSound (int index);
+    void removeSound (int index, BKSoundSet set = MainSoundSet);
+    
+    /** Replaces all the sounds in a set at once, so no note finds the set half built.
+     
+     newSounds is left holding the old sounds, so they can be released
+     outside the lock. Voices still playing an old sound keep it alive.
+     */
+    void setSounds (ReferenceCountedArray<BKSynthesiserSound>& newSounds, BKSoundSet set = MainSoundSet);
+    
+    //==============================================================================
+    /** Renders piano voices four at a time from struct-of-arrays state (see BKPianoVoiceBatch).
+     On by default when SOA_VOICE_RENDERING is set.
+     */
+    void setVoiceBatching (bool shouldBatch);
+    bool isVoiceBatching() const noexcept                           { return batch != nullptr; }
+    
+    /** Renders the voices on pool's worker threads as well as the audio thread when there are
+     enough of them (see BKVoiceRenderPool). The pool isn't owned; nullptr to render serially.
+     */
+    void setRenderPool (BKVoiceRenderPool* pool);
+    
+    //==============================================================================
+    /** Lets the voice pool grow from minVoices up to maxVoices.
+     
+     Once more than three quarters of the voices are busy, getNumVoicesWanted() asks
+     for more. A background thread makes them and hands them over with queueVoice(),
+     and the audio thread adds them at the start of the next block, without locking
+     or allocating. With minVoices == maxVoices the pool stays that size.
+     
+     Call this off the audio thread; it reserves room for maxVoices.
+     */
+    void setVoicePoolLimits (int minVoices, int maxVoices);
+    int getVoicePoolMinimum() const noexcept                        { return minPoolVoices; }
+    
+    /** How many more voices the pool should get. Background thread. */
+    int getNumVoicesWanted() const noexcept;
+    
+    /** Hands a new voice to the audio thread. Background thread. Returns false, and
+     doesn't take the voice, if too many are already waiting.
+     */
+    bool queueVoice (BKSynthesiserVoice* newVoice);
+    
+    /** The most voices that have been busy at once, to size a pinned pool by. */
+    int getPeakVoiceUsage() const noexcept                          { return peakVoices.get(); }
+    int getNumBusyVoices() const noexcept                           { return busyVoices.get(); }
+    void resetPeakVoiceUsage() noexcept                             { peakVoices.set (0); }
+    
+    //==============================================================================
+    /** Stops voices whose output has stayed below floorDecibels for holdMs, such as the
+     long tails of sustained notes that are still being read but can't be heard.
+     Reverse notes and voices still ramping on aren't counted as quiet, nor is any
+     block in which a voice got louder, since those are on their way up, not dying away.
+     A floor of -100 dB or lower turns culling off.
+     */
+    void setVoiceCulling (float floorDecibels, float holdMs);
+    
+    /** Keeps the worst case bounded: when rendering a block takes longer than
+     proportionOfBlock of the block's duration, the quietest voices are released,
+     oldest first among equally quiet ones, in proportion to the overrun.
+     0 turns it off.
+     */
+    void setRenderBudget (double proportionOfBlock);
+    
+    /** How many voices have been culled for being quiet, and dropped for the render budget. */
+    int getNumCulledVoices() const noexcept                         { return numCulledVoices.get(); }
+    int getNumDroppedVoices() const noexcept                        { return numDroppedVoices.get(); }
+    
+    /** Voices, the voice batch and each set of sounds. Takes the synth's lock. */
+    void reportMemory (BKMemoryReport& report) const override;
     
     //==============================================================================
     /** If set to true, then the synth will try to take over an existing voice if
@@ -561,6 +686,9 @@ public:
      */
     double getSampleRate() const noexcept                       { return sampleRate; }
     
+    /** Held while rendering and while notes are triggered. Hold it to change a sound's data. */
+    const CriticalSection& getLock() const noexcept                 { return lock; }
+    
     /** Sets a minimum limit on the size to which audio sub-blocks will be divided when rendering.
      
      When rendering, the audio blocks that are passed into renderNextBlock() will be split up
@@ -591,7 +719,28 @@ protected:
     CriticalSection lock;
     
     OwnedArray<BKSynthesiserVoice> voices;
-    ReferenceCountedArray<BKSynthesiserSound> sounds;
+    ReferenceCountedArray<BKSynthesiserSound> sounds [BKSoundSetNil];
+    
+    ScopedPointer<BKPianoVoiceBatch> batch;
+    BKVoiceRenderPool* renderPool;
+    
+    // Voice pool growth: written by the background thread, read by the audio thread through the fifo
+    enum { voiceQueueSize = 64 };
+    AbstractFifo voiceQueue;
+    BKSynthesiserVoice* queuedVoices [voiceQueueSize];
+    int minPoolVoices, maxPoolVoices;
+    Atomic<int> numPoolVoices, busyVoices, peakVoices;
+    
+    void takeQueuedVoices();
+    
+    // Culling and the render budget; the counts are read by other threads
+    float cullLevel, cullHoldMs;
+    double renderBudget;
+    Atomic<int> numCulledVoices, numDroppedVoices;
+    Array<BKSynthesiserVoice*> governedVoices;
+    
+    void cullQuietVoices (int numSamples);
+    void governVoices (double renderSeconds, int numSamples);
     
     /** The last pitch-wheel values for each midi channel. */
     int lastPitchWheelValues [16];
@@ -619,7 +768,8 @@ protected:
                                                bool stealIfNoneAvailable) const;
     
     /** Chooses a voice that is most suitable for being re-used.
-     The default method will attempt to find the oldest voice that isn't the
+     The default method will attempt to find the oldest hammer or resonance voice,
+     since those are short and quiet, and then the oldest voice that isn't the
      bottom or top note being played. If that's not suitable for your synth,
      you can override this method and do something more cunning instead.
      */
@@ -627,6 +777,14 @@ protected:
                                                   int midiChannel,
                                                   int midiNoteNumber) const;
     
+    /** Finds the ready sound for a note whose velocities are nearest, to stand in for
+     one that isn't loaded yet. Returns nullptr if there is none.
+     */
+    BKSynthesiserSound* findStandIn (BKSoundSet set,
+                                     int midiChannel,
+                                     int midiNoteNumber,
+                                     int midiVelocity) const;
+    
     /** Starts a specified voice playing a particular sound.
      You'll probably never need to call this, it's used internally by noteOn(), but
      may be needed by subclasses for custom behaviours.
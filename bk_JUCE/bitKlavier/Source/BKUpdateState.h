@@ -13,6 +13,8 @@
 
 #include "BKUtilities.h"
 
+#include "BKEditorEvents.h"
+
 class BKUpdateState : public ReferenceCountedObject
 {
 public:
@@ -48,6 +50,8 @@ public:
     
     bool idDidChange = false;
     bool galleriesUpdated = false;
+    bool galleryIndexDidChange = false;
+    bool setlistDidAdvance = false;
     bool galleryLoaded = false;
     bool directDidChange = false;
     bool pianoDidChangeForGraph = false;
@@ -67,6 +71,9 @@ public:
     bool displayDidChange;
     
     bool loadedJson = false;
+    
+    // What the audio thread changed that the editors show (see BKEditorEvents.h)
+    BKEditorEventQueue editorEvents;
 
     void setCurrentDisplay(BKPreparationDisplay type)
     {
@@ -10,6 +10,12 @@
 
 #include "BKUtilities.h"
 
+#if JUCE_LINUX
+#include <unistd.h>
+#elif JUCE_MAC || JUCE_IOS
+#include <mach/mach.h>
+#endif
+
 
 String rectangleToString(Rectangle<int> rect)
 {
@@ -26,6 +32,27 @@ String rectangleToString(Rectangle<float> rect)
             " H: " + String(rect.getHeight()));
 }
 
+int64 getResidentMemory(void)
+{
+#if JUCE_LINUX
+    // second field of statm is resident pages
+    StringArray fields = StringArray::fromTokens(File("/proc/self/statm").loadFileAsString(), false);
+    
+    if (fields.size() < 2) return -1;
+    
+    return fields[1].getLargeIntValue() * (int64) sysconf(_SC_PAGESIZE);
+#elif JUCE_MAC || JUCE_IOS
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info, &count) != KERN_SUCCESS) return -1;
+    
+    return (int64) info.resident_size;
+#else
+    return -1;
+#endif
+}
+
 BKParameterDataType getBKDataType ( SynchronicParameterType type)
 {
     if ((type == SynchronicTuning) ||
@@ -290,37 +317,38 @@ String arrayIntArrayToString(Array<Array<int>> afarr)
     return s;
 }
 
+// Written into a stream rather than appended to a String, so long arrays aren't copied for every value
 String arrayFloatArrayToString(Array<Array<float>> afarr)
 {
-    String s = "";
+    MemoryOutputStream s;
     for (auto arr : afarr)
     {
         if (arr.size()>1)
         {
-            s += "[";
+            s << "[";
             for (auto f : arr)
             {
-                s += String(f)+" ";
+                s << String(f) << " ";
             }
-            s += "] ";
+            s << "] ";
         }
         else
         {
-            s +=String(arr[0])+" ";
+            s << String(arr[0]) << " ";
         }
     }
-    return s;
+    return s.toString();
 }
 
 String floatArrayToString(Array<float> arr)
 {
-    String s = "";
+    MemoryOutputStream s;
     for (auto key : arr)
     {
-        s.append(String(key), 6);
-        s.append(" ", 1);
+        s << String(key).substring(0, 6);
+        s << " ";
     }
-    return s;
+    return s.toString();
 }
 
 Array<int> keymapStringToIntArray(String s)
@@ -437,88 +465,82 @@ Array<int> stringToIntArray(String s)
     return arr;
 }
 
+// "1 2 [3 4] 5": numbers outside brackets are groups of one, numbers inside are one group.
+// One pass over the text; a bracket that is never closed is dropped.
 Array<Array<float>> stringToArrayFloatArray(String s)
 {
     Array<Array<float>> afarr;
-
-    String rest = s;
     
-    // "4"
-    while (rest.length())
+    String::CharPointerType c = s.getCharPointer();
+    String::CharPointerType start = c;
+    
+    while (!c.isEmpty())
     {
-        String sub = rest.upToFirstOccurrenceOf("[", false, true);
-        
-        Array<float> ind = stringToFloatArray(sub);
+        if (*c != '[')
+        {
+            ++c;
+            continue;
+        }
         
-        for (auto f : ind)
+        for (auto f : stringToFloatArray(String(start, c)))
         {
             Array<float> arr; arr.add(f);
             afarr.add(arr);
         }
         
-        if (sub == rest) break;
+        start = ++c;
         
-        rest = rest.substring(sub.length()+1);
+        while (!c.isEmpty() && *c != ']') ++c;
         
-        sub = rest.upToFirstOccurrenceOf("]", false, true);
+        if (c.isEmpty()) return afarr;
         
-        if (sub != rest)
-        {
-            Array<float> group = stringToFloatArray(sub);
-            
-            afarr.add(group);
-        }
+        afarr.add(stringToFloatArray(String(start, c)));
         
-        rest = rest.substring(sub.length()+1);
+        start = ++c;
+    }
+    
+    for (auto f : stringToFloatArray(String(start, c)))
+    {
+        Array<float> arr; arr.add(f);
+        afarr.add(arr);
     }
  
     return afarr;
 }
 
 
+// Each run of digits, '.' and '-' is one number; everything else separates them.
 Array<float> stringToFloatArray(String s)
 {
     Array<float> arr = Array<float>();
     
-    String temp = "";
     bool inNumber = false;
     
     String::CharPointerType c = s.getCharPointer();
+    String::CharPointerType start = c;
     
-    juce_wchar prd = '.';
-    juce_wchar dash = '-';
-    
-    int prdCnt = 0;
-    
-    // DEBUG
-    for (int i = 0; i < (s.length()+1); i++)
+    for (;;)
     {
-        juce_wchar c1 = c.getAndAdvance();
-        
-        bool isPrd = !CharacterFunctions::compare(c1, prd);
-        bool isDash = !CharacterFunctions::compare(c1, dash);
-        
-        if (isPrd) prdCnt += 1;
+        juce_wchar c1 = *c;
         
-        bool isNumChar = CharacterFunctions::isDigit(c1) || isPrd || isDash;
+        bool isNumChar = CharacterFunctions::isDigit(c1) || c1 == '.' || c1 == '-';
         
-        if (!isNumChar)
+        if (isNumChar)
         {
-            if (inNumber)
-            {
-                arr.add(temp.getFloatValue());
-                temp = "";
-            }
+            if (!inNumber) start = c;
             
-            inNumber = false;
-            continue;
+            inNumber = true;
         }
         else
         {
-            inNumber = true;
+            if (inNumber) arr.add(String(start, c).getFloatValue());
             
-            temp += c1;
+            inNumber = false;
+            
+            if (c1 == 0) break;
         }
+        
+        ++c;
     }
     
     return arr;
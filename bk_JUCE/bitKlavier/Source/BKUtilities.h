@@ -19,8 +19,39 @@
 
 #include "AudioConstants.h"
 
-#define TRY_UNDO 0 //enable attempt at undo/redo
-#define NUM_EPOCHS 10
+#define TRY_UNDO 1 //enable undo/redo
+#define NUM_EPOCHS 1000 //max undo steps kept per piano
+
+#define BENCHMARK_ITEM_GRAPH 0 //time pasting, configuring and reloading generated pianos of 1k and 5k items when a gallery is loaded from disk
+
+#define COMPACT_SAMPLE_STORAGE 0 //keep samples as 16 (or 24) bit PCM instead of float, about half the memory
+#define BENCHMARK_SAMPLE_STORAGE 0 //compare memory and render time of float vs compact samples after loading
+
+#define LAZY_SAMPLE_LOADING 0 //load the softest layer of every note up front, the other layers when first played
+#define LAZY_SAMPLE_MEMORY_MB 512 //past this, lazily loaded layers are released again, least recently played first
+
+#define REVERSED_SAMPLE_CACHE 0 //reverse notes (nostalgic, synchronic) read forward through reversed copies made in the background
+#define REVERSED_SAMPLE_MEMORY_MB 256 //past this, the least recently played reversed copies are dropped
+#define BENCHMARK_REVERSED_SAMPLES 0 //time reverse notes with and without reversed copies after loading (with REVERSED_SAMPLE_CACHE on)
+
+#define SOA_VOICE_RENDERING 0 //render piano voices four at a time in SIMD lanes (BKPianoVoiceBatch) instead of one by one
+#define BENCHMARK_VOICE_ENGINE 0 //time short synchronic notes from 16 to 512 voices, one by one vs batched, after loading
+
+#define PARALLEL_VOICE_RENDERING 0 //render voices on worker threads as well as the audio thread when there are enough of them
+#define PARALLEL_VOICE_THREADS 3 //worker threads, each pinned to a core of its own
+
+#define VOICE_POOL_MIN 64 //voices the synth starts with; it grows when they're mostly busy
+#define VOICE_POOL_MAX 1024 //most voices it grows to, main, hammer and resonance together; past that notes steal
+
+#define VOICE_CULLING 1 //stop voices that have been too quiet to hear for a while, e.g. the tails of long sustained notes
+#define VOICE_CULL_DB -90 //below this a voice counts as quiet
+#define VOICE_CULL_MS 250 //how long it has to stay quiet
+#define VOICE_CPU_GOVERNOR 0 //release the quietest voices when a block takes too long to render
+#define VOICE_CPU_BUDGET 70 //percent of a block's duration rendering it may take
+
+#define OVERRUN_WATCHDOG 1 //record engine events in a ring and write the last of them to disk when a block misses its deadline
+
+#define MIDI_CAPTURE 1 //let the gallery menu record incoming MIDI with the state it plays on, for replaying with --replay
 
 #define SAVE_ID 1
 #define SAVEAS_ID 2
@@ -79,6 +110,10 @@
 #define ABOUT_ID 49
 #define EXPORT_ID 50
 #define IMPORT_ID 51
+#define SETLIST_ID 52
+#define SETLIST_NEXT_ID 53
+#define MEMORY_ID 54
+#define CAPTURE_ID 55
 
 inline PopupMenu getNewItemMenu(LookAndFeel* laf)
 {
@@ -233,6 +268,9 @@ double          ftom(double f);
 String rectangleToString(Rectangle<int> rect);
 String rectangleToString(Rectangle<float> rect);
 
+// Resident memory of the whole process in bytes, -1 where we can't tell
+int64 getResidentMemory(void);
+
 
 
 BKParameterDataType getBKDataType ( SynchronicParameterType param);
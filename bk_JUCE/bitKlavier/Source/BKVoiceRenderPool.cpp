@@ -0,0 +1,247 @@
+/*
+  ==============================================================================
+
+    BKVoiceRenderPool.cpp
+    Created: 19 Oct 2026 7:40:15pm
+    Author:
+
+  ==============================================================================
+*/
+
+#include "BKVoiceRenderPool.h"
+
+// How long a worker keeps spinning for the next job before it goes to sleep
+static const uint32 workerSpinMs = 2;
+
+// How long, as a share of the block, the audio thread waits on workers once its own chunks are done
+static const double lateWaitFraction = 0.5;
+
+BKVoiceRenderPool::Worker::Worker(BKVoiceRenderPool& p, int index):
+Thread("voice_render_" + String(index)),
+pool(p)
+{
+
+}
+
+void BKVoiceRenderPool::Worker::run(void)
+{
+    int seen = pool.claim.get() >> chunkBits;
+    uint32 lastJob = Time::getMillisecondCounter();
+
+    while (!threadShouldExit())
+    {
+        const int jobGeneration = pool.claim.get() >> chunkBits;
+
+        if (jobGeneration != seen)
+        {
+            seen = jobGeneration;
+
+            while (pool.renderChunk(jobGeneration)) {}
+
+            lastJob = Time::getMillisecondCounter();
+            continue;
+        }
+
+        if (Time::getMillisecondCounter() - lastJob < workerSpinMs) continue;
+
+        // Publishing a job and checking sleeping happen in the opposite order, so one of us sees the other
+        sleeping.set(1);
+
+        if ((pool.claim.get() >> chunkBits) == seen) wakeUp.wait(100);
+
+        sleeping.set(0);
+
+        lastJob = Time::getMillisecondCounter();
+    }
+}
+
+BKVoiceRenderPool::BKVoiceRenderPool(int numThreads):
+generation(0),
+numChunks(0),
+numSamplesToRender(0),
+sampleRate(44100.0),
+lateGeneration(-1)
+{
+    claim.set(closedChunk);
+
+    for (int i = 0; i <= maxThreads; i++) chunkDone[i].set(-1);
+
+    numThreads = jlimit(0, (int) maxThreads, numThreads);
+
+    const int numCores = SystemStats::getNumCpus();
+
+    for (int i = 0; i < numThreads; i++)
+    {
+        Worker* worker = workers.add(new Worker(*this, i));
+
+        // Leave core 0 to the audio thread
+        if (numCores > numThreads) worker->setAffinityMask(1u << (uint32) (i + 1));
+
+        worker->startThread(10);
+    }
+
+    for (int i = 0; i <= numThreads; i++) scratch.add(new AudioSampleBuffer());
+
+    prepare(2, 512, 44100.0);
+}
+
+BKVoiceRenderPool::~BKVoiceRenderPool(void)
+{
+    for (int i = 0; i < workers.size(); i++)
+    {
+        workers[i]->signalThreadShouldExit();
+        workers[i]->wakeUp.signal();
+    }
+
+    for (int i = 0; i < workers.size(); i++) workers[i]->stopThread(1000);
+}
+
+void BKVoiceRenderPool::prepare(int numChannels, int maxBlockSize, double newSampleRate)
+{
+    // A late worker may still be writing into its scratch buffer
+    for (int i = 0; lateGeneration >= 0 && !allChunksDone(lateGeneration) && i < 1000; i++) Thread::sleep(1);
+
+    lateGeneration = -1;
+
+    for (int i = 0; i < scratch.size(); i++) scratch[i]->setSize(numChannels, maxBlockSize);
+
+    if (newSampleRate > 0.0) sampleRate = newSampleRate;
+
+    // The processor keeps the voice pool at or below this
+    active.ensureStorageAllocated(VOICE_POOL_MAX);
+    owned.ensureStorageAllocated(VOICE_POOL_MAX);
+}
+
+bool BKVoiceRenderPool::allChunksDone(int jobGeneration) const
+{
+    for (int c = 0; c < numChunks; c++)
+    {
+        if (chunkDone[c].get() != jobGeneration) return false;
+    }
+
+    return true;
+}
+
+void BKVoiceRenderPool::renderAroundLateJob(const OwnedArray<BKSynthesiserVoice>& voices, AudioSampleBuffer& buffer, int startSample, int numSamples)
+{
+    owned.clearQuick();
+
+    for (int c = 0; c < numChunks; c++)
+    {
+        if (chunkDone[c].get() == lateGeneration) continue;
+
+        const int begin = (c * active.size()) / numChunks;
+        const int end = ((c + 1) * active.size()) / numChunks;
+
+        for (int i = begin; i < end; i++) owned.add(active.getUnchecked(i));
+    }
+
+    owned.sort();
+
+    DefaultElementComparator<BKSynthesiserVoice*> comparator;
+
+    for (int i = 0; i < voices.size(); i++)
+    {
+        BKSynthesiserVoice* voice = voices.getUnchecked(i);
+
+        if (voice->isVoiceActive() && owned.indexOfSorted(comparator, voice) < 0) voice->renderNextBlock(buffer, startSample, numSamples);
+    }
+}
+
+bool BKVoiceRenderPool::render(const OwnedArray<BKSynthesiserVoice>& voices, AudioSampleBuffer& buffer, int startSample, int numSamples)
+{
+    if (lateGeneration >= 0)
+    {
+        if (!allChunksDone(lateGeneration))
+        {
+            renderAroundLateJob(voices, buffer, startSample, numSamples);
+            return true;
+        }
+
+        lateGeneration = -1;
+    }
+
+    const AudioSampleBuffer& first = *scratch.getUnchecked(0);
+
+    if (numSamples > first.getNumSamples() || buffer.getNumChannels() != first.getNumChannels()) return false;
+
+    active.clearQuick();
+
+    for (int i = 0; i < voices.size(); i++)
+    {
+        BKSynthesiserVoice* voice = voices.getUnchecked(i);
+
+        if (voice->isVoiceActive()) active.add(voice);
+    }
+
+    const int chunks = jmin(scratch.size(), active.size() / (int) minVoicesPerChunk);
+
+    // Not worth waking anyone for
+    if (chunks < 2) return false;
+
+    numChunks = chunks;
+    numSamplesToRender = numSamples;
+
+    generation = (generation + 1) & ((1 << (30 - chunkBits)) - 1);
+
+    // Publish
+    claim.set(generation << chunkBits);
+
+    for (int i = 0; i < workers.size(); i++)
+    {
+        if (workers.getUnchecked(i)->sleeping.get() != 0) workers.getUnchecked(i)->wakeUp.signal();
+    }
+
+    while (renderChunk(generation)) {}
+
+    // Every chunk is claimed, so this only waits on chunks being rendered right now, and not for long
+    const int64 deadline = Time::getHighResolutionTicks()
+                         + (int64) (numSamples / sampleRate * lateWaitFraction * Time::getHighResolutionTicksPerSecond());
+
+    while (!allChunksDone(generation) && Time::getHighResolutionTicks() < deadline) {}
+
+    claim.set((generation << chunkBits) | closedChunk);
+
+    for (int c = 0; c < numChunks; c++)
+    {
+        if (chunkDone[c].get() != generation)
+        {
+            lateGeneration = generation;
+            continue;
+        }
+
+        for (int ch = 0; ch < buffer.getNumChannels(); ch++)
+        {
+            buffer.addFrom(ch, startSample, *scratch.getUnchecked(c), ch, 0, numSamples);
+        }
+    }
+
+    if (lateGeneration >= 0) ++numLateRenders;
+
+    return true;
+}
+
+bool BKVoiceRenderPool::renderChunk(int jobGeneration)
+{
+    for (;;)
+    {
+        const int current = claim.get();
+        const int chunk = current & chunkMask;
+
+        if ((current >> chunkBits) != jobGeneration || chunk >= numChunks) return false;
+
+        if (!claim.compareAndSetBool(current + 1, current)) continue;
+
+        AudioSampleBuffer& out = *scratch.getUnchecked(chunk);
+        out.clear(0, numSamplesToRender);
+
+        const int begin = (chunk * active.size()) / numChunks;
+        const int end = ((chunk + 1) * active.size()) / numChunks;
+
+        for (int i = begin; i < end; i++) active.getUnchecked(i)->renderNextBlock(out, 0, numSamplesToRender);
+
+        chunkDone[chunk].set(jobGeneration);
+
+        return true;
+    }
+}
@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+
+    BKVoiceRenderPool.h
+    Created: 19 Oct 2026 7:40:15pm
+    Author:
+
+    Renders a synth's voices on worker threads as well as the audio thread.
+    The active voices are split into chunks, one per thread, and each chunk
+    is rendered into its own scratch buffer; the audio thread sums them into
+    the output once every chunk is done.
+
+    Chunks are claimed with a compare-and-set, and the audio thread claims
+    them too, so it never waits for a worker that hasn't started: once it
+    runs out of chunks it only waits for the ones already being rendered.
+    Too few voices to be worth splitting up and the synth renders them
+    itself, as before.
+
+    That wait is bounded. If a worker is still in its chunk half a block
+    after the audio thread finished its own (the OS took the core away),
+    the block goes out without that chunk and the render counts as late.
+    The worker still owns those voices until it finishes, so until then
+    the pool renders every other voice serially on the audio thread and
+    leaves those alone.
+
+  ==============================================================================
+*/
+
+#ifndef BKVOICERENDERPOOL_H_INCLUDED
+#define BKVOICERENDERPOOL_H_INCLUDED
+
+#include "BKUtilities.h"
+
+#include "BKSynthesiser.h"
+
+class BKVoiceRenderPool
+{
+public:
+    // Starts numThreads workers, each pinned to a core of its own where there are enough.
+    BKVoiceRenderPool(int numThreads);
+    ~BKVoiceRenderPool(void);
+
+    // Not on the audio thread. Blocks larger than maxBlockSize are rendered serially.
+    void prepare(int numChannels, int maxBlockSize, double sampleRate);
+
+    // Audio thread, holding the synth's lock. Renders every active voice into buffer and returns true,
+    // or returns false without rendering anything if there are too few voices to split up.
+    bool render(const OwnedArray<BKSynthesiserVoice>& voices, AudioSampleBuffer& buffer, int startSample, int numSamples);
+
+    // Blocks that went out without a chunk a worker didn't finish in time
+    int getNumLateRenders(void) const noexcept { return numLateRenders.get(); }
+
+    enum
+    {
+        minVoicesPerChunk = 16,
+        maxThreads = 8
+    };
+
+private:
+    class Worker : public Thread
+    {
+    public:
+        Worker(BKVoiceRenderPool& p, int index);
+
+        void run(void) override;
+
+        // Set while the worker sleeps instead of spinning; the audio thread wakes it for the next job.
+        Atomic<int> sleeping;
+        WaitableEvent wakeUp;
+
+    private:
+        BKVoiceRenderPool& pool;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Worker)
+    };
+
+    OwnedArray<Worker> workers;
+    OwnedArray<AudioSampleBuffer> scratch;      // one per chunk
+    Array<BKSynthesiserVoice*> active;
+
+    // The job. claim holds the job's generation above the next chunk to render;
+    // everything else is written before claim publishes it.
+    Atomic<int> claim;
+    Atomic<int> chunkDone[maxThreads + 1];      // the generation each chunk was last finished for
+    int generation;
+    int numChunks;
+    int numSamplesToRender;
+
+    double sampleRate;
+
+    // A job we stopped waiting for, -1 if none. Nothing new is published until it finishes,
+    // so active and the unfinished chunks' scratch buffers stay the late worker's.
+    int lateGeneration;
+    Array<BKSynthesiserVoice*> owned;           // sorted; voices of its unfinished chunks
+    Atomic<int> numLateRenders;
+
+    enum { chunkBits = 6, chunkMask = (1 << chunkBits) - 1, closedChunk = chunkMask };
+
+    bool renderChunk(int jobGeneration);
+    bool allChunksDone(int jobGeneration) const;
+    void renderAroundLateJob(const OwnedArray<BKSynthesiserVoice>& voices, AudioSampleBuffer& buffer, int startSample, int numSamples);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BKVoiceRenderPool)
+};
+
+
+#endif  // BKVOICERENDERPOOL_H_INCLUDED
@@ -12,12 +12,8 @@
 
 DirectProcessor::DirectProcessor(Direct::Ptr direct,
                                  TuningProcessor::Ptr tuning,
-                                 BKSynthesiser *s,
-                                 BKSynthesiser *res,
-                                 BKSynthesiser *ham):
+                                 BKSynthesiser *s):
 synth(s),
-resonanceSynth(res),
-hammerSynth(ham),
 direct(direct),
 tuner(tuning)
 {
@@ -85,41 +81,42 @@ void DirectProcessor::keyReleased(int noteNumber, float velocity, int channel)
             
             if (hGain > 0.0f)
             {
-                hammerSynth->keyOn(channel,
-                                   //synthNoteNumber,
-                                   noteNumber,
-                                   t,
-                                   0,
-                                   velocity,
-                                   hGain * HAMMER_GAIN_SCALE,
-                                   Forward,
-                                   Normal, //FixedLength,
-                                   HammerNote,
-                                   direct->getId(),
-                                   0,
-                                   2000,
-                                   3,
-                                   3 );
+                // Hammers and resonance play from their own sound sets, on the same voices
+                synth->keyOn(channel,
+                             //synthNoteNumber,
+                             noteNumber,
+                             t,
+                             0,
+                             velocity,
+                             hGain * HAMMER_GAIN_SCALE,
+                             Forward,
+                             Normal, //FixedLength,
+                             HammerNote,
+                             direct->getId(),
+                             0,
+                             2000,
+                             3,
+                             3 );
             }
             
             if (rGain > 0.0f)
             {
-                resonanceSynth->keyOn(channel,
-                                      //synthNoteNumber,
-                                      noteNumber,
-                                      t,
-                                      //synthOffset,
-                                      t_offset,
-                                      velocity,
-                                      rGain * RES_GAIN_SCALE,
-                                      Forward,
-                                      Normal, //FixedLength,
-                                      ResonanceNote,
-                                      direct->getId(),
-                                      0,
-                                      2000,
-                                      3,
-                                      3 );
+                synth->keyOn(channel,
+                                //synthNoteNumber,
+                                noteNumber,
+                                t,
+                                //synthOffset,
+                                t_offset,
+                                velocity,
+                                rGain * RES_GAIN_SCALE,
+                                Forward,
+                                Normal, //FixedLength,
+                                ResonanceNote,
+                                direct->getId(),
+                                0,
+                                2000,
+                                3,
+                                3 );
 
             }
         }
@@ -447,7 +447,7 @@ public:
     
     DirectProcessor(Direct::Ptr direct,
                     TuningProcessor::Ptr tuning,
-                    BKSynthesiser *s, BKSynthesiser *res, BKSynthesiser *ham);
+                    BKSynthesiser *s);
     
     ~DirectProcessor();
     
@@ -457,13 +457,11 @@ public:
     void    keyPressed(int noteNumber, float velocity, int channel);
     void    keyReleased(int noteNumber, float velocity, int channel);
     
-    inline void prepareToPlay(double sr, BKSynthesiser* main, BKSynthesiser* res, BKSynthesiser* hammer)
+    inline void prepareToPlay(double sr, BKSynthesiser* main)
     {
         sampleRate = sr;
         
         synth = main;
-        resonanceSynth = res;
-        hammerSynth = hammer;
     }
     
     inline void reset(void)
@@ -471,6 +469,14 @@ public:
         direct->aPrep->copy(direct->sPrep);
     }
     
+    // Pitches sounding for keys still down, over all keys
+    inline int getNumKeysPlayed(void) const noexcept
+    {
+        int numPlayed = 0;
+        for (int i = 0; i < 128; i++) numPlayed += keyPlayed[i].size();
+        return numPlayed;
+    }
+    
     inline int getId(void) const noexcept { return direct->getId(); }
     
     inline void setTuning(TuningProcessor::Ptr tuning)
@@ -485,8 +491,6 @@ public:
     
 private:
     BKSynthesiser*      synth;
-    BKSynthesiser*      resonanceSynth;
-    BKSynthesiser*      hammerSynth;
     
     Direct::Ptr             direct;
     TuningProcessor::Ptr    tuner;
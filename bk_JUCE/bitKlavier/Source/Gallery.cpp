@@ -110,6 +110,30 @@ Gallery::~Gallery()
     bkPianos.clear();
 }
 
+void Gallery::reportMemory(BKMemoryReport& report) const
+{
+    report.addBytes(sizeof(Gallery));
+    
+    // Each preparation keeps a static and an active copy
+    BKMemoryReport& preparations = report.add("preparations");
+    preparations.add("direct",      direct.size()       * (int64)(sizeof(Direct) + 2 * sizeof(DirectPreparation)),          direct.size());
+    preparations.add("synchronic",  synchronic.size()   * (int64)(sizeof(Synchronic) + 2 * sizeof(SynchronicPreparation)),  synchronic.size());
+    preparations.add("nostalgic",   nostalgic.size()    * (int64)(sizeof(Nostalgic) + 2 * sizeof(NostalgicPreparation)),    nostalgic.size());
+    preparations.add("tuning",      tuning.size()       * (int64)(sizeof(Tuning) + 2 * sizeof(TuningPreparation)),          tuning.size());
+    preparations.add("tempo",       tempo.size()        * (int64)(sizeof(Tempo) + 2 * sizeof(TempoPreparation)),            tempo.size());
+    
+    BKMemoryReport& mods = report.add("modifications");
+    mods.add("direct",      modDirect.size()        * (int64)sizeof(DirectModPreparation),      modDirect.size());
+    mods.add("synchronic",  modSynchronic.size()    * (int64)sizeof(SynchronicModPreparation),  modSynchronic.size());
+    mods.add("nostalgic",   modNostalgic.size()     * (int64)sizeof(NostalgicModPreparation),   modNostalgic.size());
+    mods.add("tuning",      modTuning.size()        * (int64)sizeof(TuningModPreparation),      modTuning.size());
+    mods.add("tempo",       modTempo.size()         * (int64)sizeof(TempoModPreparation),       modTempo.size());
+    
+    report.add("keymaps", bkKeymaps.size() * (int64)(sizeof(Keymap) + 128 * sizeof(int)), bkKeymaps.size());
+    
+    for (auto piano : bkPianos) piano->reportMemory(report.add("piano " + piano->getName()));
+}
+
 void Gallery::resetPreparations(void)
 {
     // Optimizations can be made here. Don't need to iterate through EVERY preparation.
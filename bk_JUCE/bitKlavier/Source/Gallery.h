@@ -22,7 +22,8 @@
 
 class BKAudioProcessor;
 
-class Gallery : public ReferenceCountedObject
+class Gallery : public ReferenceCountedObject,
+                public BKMemoryAccountable
 {
 public:
     typedef ReferenceCountedObjectPtr<Gallery>   Ptr;
@@ -665,6 +666,9 @@ public:
     
     inline void setName(String n) { name = n;}
     
+    // Preparations, modifications, keymaps and every piano
+    void reportMemory(BKMemoryReport& report) const override;
+    
     
     
 private:
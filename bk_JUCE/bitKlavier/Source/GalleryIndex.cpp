@@ -0,0 +1,301 @@
+/*
+  ==============================================================================
+
+    GalleryIndex.cpp
+    Created: 19 Oct 2026 11:40:02am
+    Author:
+
+  ==============================================================================
+*/
+
+#include "GalleryIndex.h"
+
+#if JUCE_LINUX
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#define GALLERY_POLL_INTERVAL_MS 3000
+#define GALLERY_WATCH_TIMEOUT_MS 250
+#define GALLERY_SETTLE_MS 100
+#define GALLERY_READ_CHUNK 65536
+
+GalleryIndex::GalleryIndex(void):
+Thread("gallery_index")
+{
+
+}
+
+GalleryIndex::~GalleryIndex(void)
+{
+    stop();
+}
+
+void GalleryIndex::start(const File& folder)
+{
+    stop();
+
+    root = folder;
+
+    startThread(1);
+}
+
+void GalleryIndex::stop(void)
+{
+    stopThread(2000);
+}
+
+Array<GalleryIndex::Entry> GalleryIndex::getEntries(void) const
+{
+    const ScopedLock sl (lock);
+
+    return entries;
+}
+
+StringArray GalleryIndex::getPaths(void) const
+{
+    const ScopedLock sl (lock);
+
+    StringArray paths;
+    paths.ensureStorageAllocated(entries.size());
+
+    for (auto& entry : entries) paths.add(entry.path);
+
+    return paths;
+}
+
+int GalleryIndex::countPianos(const File& file)
+{
+    if (file.hasFileExtension(".json")) return -1;
+
+    // Pianos are direct children of the gallery element, so counting their tags is enough and much
+    // cheaper than building the whole document. The file is streamed through in chunks rather than
+    // read in whole; the end of each chunk that could be the start of a tag is carried into the next.
+    FileInputStream in (file);
+
+    if (in.failedToOpen()) return 0;
+
+    const String tag = "<" + vtagPiano;
+    const char* pattern = tag.toRawUTF8();
+    const int patternLength = (int) tag.getNumBytesAsUTF8();
+
+    HeapBlock<char> buffer (GALLERY_READ_CHUNK + patternLength);
+    char* data = buffer.getData();
+
+    int count = 0, kept = 0;
+
+    while (!in.isExhausted())
+    {
+        const int numRead = in.read(data + kept, GALLERY_READ_CHUNK);
+
+        if (numRead <= 0) break;
+
+        const int available = kept + numRead;
+
+        // A match needs the character after the tag name too, to tell <piano from <pianoMap
+        int i = 0;
+        for (; i + patternLength < available; i++)
+        {
+            if (memcmp(data + i, pattern, (size_t) patternLength) != 0) continue;
+
+            const char next = data[i + patternLength];
+
+            if (next == ' ' || next == '>' || next == '/' || next == '\t' || next == '\r' || next == '\n') ++count;
+        }
+
+        kept = available - i;
+        memmove(data, data + i, (size_t) kept);
+    }
+
+    return count;
+}
+
+bool GalleryIndex::rescan(void)
+{
+    // The message thread (after saving or deleting) and the watcher both scan; without this, two scans could
+    // each compare against the same previous entries and the older result could land last.
+    const ScopedLock ssl (scanLock);
+
+    if (!root.isDirectory()) return false;
+
+    Array<Entry> previous = getEntries();
+
+    HashMap<String, int> previousIndex;
+    for (int i = 0; i < previous.size(); i++) previousIndex.set(previous.getReference(i).path, i);
+
+    Array<Entry> found;
+
+    StringArray patterns ("*.xml", "*.json");
+
+    for (auto pattern : patterns)
+    {
+        Array<Entry> ofType;
+
+        DirectoryIterator iter (root, true, pattern);
+        while (iter.next())
+        {
+            File galleryFile (iter.getFile());
+
+            Entry entry;
+            entry.path = galleryFile.getFullPathName();
+            entry.modified = galleryFile.getLastModificationTime().toMilliseconds();
+            entry.size = galleryFile.getSize();
+
+            if (previousIndex.contains(entry.path))
+            {
+                const Entry& old = previous.getReference(previousIndex[entry.path]);
+
+                if (old.modified == entry.modified && old.size == entry.size)
+                {
+                    ofType.add(old);
+                    continue;
+                }
+            }
+
+            entry.name = galleryFile.getFileNameWithoutExtension();
+            entry.folder = galleryFile.getParentDirectory().getFileName();
+            entry.topLevel = (galleryFile.getParentDirectory() == root ||
+                              galleryFile.getParentDirectory().getFileName() == "Inbox");
+            entry.numPianos = countPianos(galleryFile);
+
+            ofType.add(entry);
+        }
+
+        // Keep galleries of the same folder next to each other for the menu
+        struct PathSorter
+        {
+            static int compareElements (const Entry& a, const Entry& b) noexcept
+            {
+                return a.path.compareNatural(b.path);
+            }
+        } sorter;
+        ofType.sort(sorter);
+
+        found.addArray(ofType);
+    }
+
+    bool changed = (found.size() != previous.size());
+
+    for (int i = 0; !changed && i < found.size(); i++)
+    {
+        const Entry& a = found.getReference(i);
+        const Entry& b = previous.getReference(i);
+
+        changed = (a.path != b.path || a.modified != b.modified || a.size != b.size);
+    }
+
+    if (!changed) return false;
+
+    {
+        const ScopedLock sl (lock);
+        entries.swapWith(found);
+    }
+
+    ++version;
+
+    sendChangeMessage();
+
+    return true;
+}
+
+void GalleryIndex::run(void)
+{
+#if JUCE_LINUX
+    watch();
+#endif
+
+    // Falls through to polling if there is no watcher, or it could not be set up
+    poll();
+}
+
+void GalleryIndex::poll(void)
+{
+    while (!threadShouldExit())
+    {
+        rescan();
+
+        wait(GALLERY_POLL_INTERVAL_MS);
+    }
+}
+
+#if JUCE_LINUX
+void GalleryIndex::watchFolder(int fd, const File& folder)
+{
+    const uint32_t mask = IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF;
+
+    inotify_add_watch(fd, folder.getFullPathName().toRawUTF8(), mask);
+
+    DirectoryIterator iter (folder, true, "*", File::findDirectories);
+    while (iter.next())
+    {
+        inotify_add_watch(fd, iter.getFile().getFullPathName().toRawUTF8(), mask);
+    }
+}
+
+void GalleryIndex::watch(void)
+{
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if (fd < 0)
+    {
+        DBG("gallery index: inotify unavailable, polling instead");
+        return;
+    }
+
+    watchFolder(fd, root);
+
+    // The first scan, once the watches are in place so nothing saved meanwhile is missed
+    rescan();
+
+    HeapBlock<char> buffer (4096);
+
+    while (!threadShouldExit())
+    {
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+
+        if (::poll(&pfd, 1, GALLERY_WATCH_TIMEOUT_MS) <= 0) continue;
+
+        bool changed = false;
+
+        // Saving a gallery or copying a folder in raises a burst of events; let it settle and take it all at once
+        wait(GALLERY_SETTLE_MS);
+
+        ssize_t length;
+        while ((length = read(fd, buffer.getData(), 4096)) > 0)
+        {
+            for (char* p = buffer.getData(); p < buffer.getData() + length;)
+            {
+                const struct inotify_event* event = (const struct inotify_event*) p;
+
+                String name = (event->len > 0) ? String::fromUTF8(event->name) : String::empty;
+
+                if (event->mask & IN_ISDIR)
+                {
+                    changed = true;
+                }
+                else if (name.endsWithIgnoreCase(".xml") || name.endsWithIgnoreCase(".json") ||
+                         (event->mask & (IN_DELETE_SELF | IN_Q_OVERFLOW)))
+                {
+                    changed = true;
+                }
+
+                p += sizeof(struct inotify_event) + event->len;
+            }
+        }
+
+        if (changed)
+        {
+            // Pick up folders that were added since the last scan; watching one twice is harmless
+            watchFolder(fd, root);
+
+            rescan();
+        }
+    }
+
+    close(fd);
+}
+#endif
@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    GalleryIndex.h
+    Created: 19 Oct 2026 11:40:02am
+    Author:
+
+    Keeps the list of gallery files in the galleries folder up to date on a
+    background thread. On Linux the folder is watched with inotify; elsewhere
+    it is re-checked every few seconds. Each gallery's name and number of
+    pianos is cached by modification time, so a file is only read again when
+    it changes. Listeners get a change message only when the list changed.
+
+  ==============================================================================
+*/
+
+#ifndef GALLERYINDEX_H_INCLUDED
+#define GALLERYINDEX_H_INCLUDED
+
+#include "BKUtilities.h"
+
+class GalleryIndex : public Thread,
+                     public ChangeBroadcaster
+{
+public:
+    struct Entry
+    {
+        String path;
+        String name;        // file name, without its extension
+        String folder;      // name of the folder it lives in
+        bool topLevel;      // lives directly in the galleries folder
+        int numPianos;      // -1 if unknown (json)
+        int64 modified;
+        int64 size;
+    };
+
+    GalleryIndex(void);
+    ~GalleryIndex(void);
+
+    // Starts watching the folder on the index's own thread, which scans it first; listeners get a
+    // change message when that first scan finds anything.
+    void start(const File& folder);
+    void stop(void);
+
+    // Scans the folder now, from any thread; scans from different threads take turns.
+    // Returns true if anything changed since the last scan.
+    bool rescan(void);
+
+    Array<Entry> getEntries(void) const;
+    StringArray getPaths(void) const;
+
+    inline uint32 getVersion(void) const noexcept { return version.get(); }
+
+private:
+    File root;
+
+    CriticalSection scanLock;   // held for the whole of a rescan
+    CriticalSection lock;       // guards entries
+    Array<Entry> entries;   // xml galleries first, then json, each sorted by path
+    Atomic<uint32> version;
+
+    void run(void) override;
+
+#if JUCE_LINUX
+    void watchFolder(int fd, const File& folder);
+    void watch(void);
+#endif
+    void poll(void);
+
+    static int countPianos(const File& file);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GalleryIndex)
+};
+
+
+#endif  // GALLERYINDEX_H_INCLUDED
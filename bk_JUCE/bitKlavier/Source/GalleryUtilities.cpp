@@ -18,12 +18,14 @@ void Gallery::addPiano()
 {
     int newId = getNewId(PreparationTypePiano);
     bkPianos.add(new Piano(processor, newId));
+    bkPianos.getLast()->setGallery(this);
 }
 
 void Gallery::addPiano(Piano::Ptr thisPiano)
 {
     int newId = getNewId(PreparationTypePiano);
     thisPiano->setId(newId);
+    thisPiano->setGallery(this);
     bkPianos.add(thisPiano);
 }
 
@@ -31,6 +33,7 @@ void Gallery::addPiano(Piano::Ptr thisPiano)
 void Gallery::addPianoWithId(int Id)
 {
     bkPianos.add(new Piano(processor, Id));
+    bkPianos.getLast()->setGallery(this);
 }
 
 void Gallery::removePiano(int Id)
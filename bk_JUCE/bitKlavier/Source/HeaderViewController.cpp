@@ -161,12 +161,22 @@ PopupMenu HeaderViewController::getGalleryMenu(void)
 #else
     galleryMenu.addItem(OPEN_ID, "Open");
     galleryMenu.addItem(OPENOLD_ID, "Open (legacy)");
+    galleryMenu.addItem(SETLIST_ID, "Open Setlist");
 #endif
     
+    if (processor.setlist.isActive())
+    {
+        galleryMenu.addItem(SETLIST_NEXT_ID, "Next in Setlist (PgDn)", processor.setlist.getPosition() + 1 < processor.setlist.getNumEntries());
+    }
+    
     galleryMenu.addSeparator();
     galleryMenu.addItem(CLEAN_ID, "Clean");
     galleryMenu.addSeparator();
     galleryMenu.addSubMenu("Load Samples", getLoadMenu());
+    galleryMenu.addItem(MEMORY_ID, "Memory Usage");
+#if MIDI_CAPTURE
+    galleryMenu.addItem(CAPTURE_ID, processor.capture.isCapturing() ? "Stop Capture" : "Start Capture");
+#endif
     galleryMenu.addSeparator();
     
     // ~ ~ ~ share menu ~ ~ ~
@@ -416,6 +426,40 @@ void HeaderViewController::galleryMenuCallback(int result, HeaderViewController*
     {
         processor.loadJsonGalleryDialog();
     }
+    else if (result == SETLIST_ID)
+    {
+        processor.loadSetlistDialog();
+    }
+    else if (result == SETLIST_NEXT_ID)
+    {
+        processor.setlist.requestAdvance();
+    }
+    else if (result == MEMORY_ID)
+    {
+        BKMemoryReport report("bitKlavier");
+        
+        processor.reportMemory(report);
+        
+        DBG(report.toJSON());
+        
+        AlertWindow::showMessageBoxAsync (AlertWindow::InfoIcon, "Memory Usage", report.toString());
+    }
+    else if (result == CAPTURE_ID)
+    {
+        if (!processor.capture.isCapturing())
+        {
+            processor.capture.start();
+            return;
+        }
+        
+        File file = processor.capture.stop();
+        
+        if (file.existsAsFile())
+            AlertWindow::showMessageBoxAsync (AlertWindow::InfoIcon, "Capture", "Saved to " + file.getFullPathName()
+                                              + "\n\nReplay it with bitKlavier --replay=\"" + file.getFullPathName() + "\"");
+        else
+            AlertWindow::showMessageBoxAsync (AlertWindow::WarningIcon, "Capture", "Couldn't save the capture.");
+    }
     else if (result == NEWGALLERY_ID)
     {
         bool shouldContinue = gvc->handleGalleryChange();
@@ -522,14 +566,6 @@ void HeaderViewController::fillGalleryCB(void)
     {
         loadDefaultGalleries();
         
-        File bkGalleries;
-        
-        File moreGalleries = File::getSpecialLocation(File::userDocumentsDirectory);
-        
-#if JUCE_MAC || JUCE_WINDOWS
-        bkGalleries = bkGalleries.getSpecialLocation(File::userDocumentsDirectory).getChildFile("bitKlavier resources").getChildFile("galleries");
-#endif
-        
         PopupMenu* galleryCBPopUp = galleryCB.getRootMenu();
         
         int id = numberOfDefaultGalleryItems, index = 0;
@@ -539,23 +575,25 @@ void HeaderViewController::fillGalleryCB(void)
         StringArray submenuNames;
         OwnedArray<PopupMenu> submenus;
         
-        for (int i = 0; i < processor.galleryNames.size(); i++)
+        // names, folders and piano counts come cached from the gallery index, so building the menu doesn't touch the disk
+        for (int i = 0; i < processor.galleries.size(); i++)
         {
-            File thisFile(processor.galleryNames[i]);
+            const GalleryIndex::Entry& thisGallery = processor.galleries.getReference(i);
+            
+            String galleryName = thisGallery.name;
             
-            String galleryName = thisFile.getFileName().upToFirstOccurrenceOf(".xml", false, false);
+            if (thisGallery.numPianos >= 0)
+                galleryName << "  (" << thisGallery.numPianos << (thisGallery.numPianos == 1 ? " piano)" : " pianos)");
             
             //moving on to new submenu, if there is one, add add last submenu to popup now that it's done
-            if(creatingSubmenu && thisFile.getParentDirectory().getFileName() != submenuName)
+            if(creatingSubmenu && thisGallery.folder != submenuName)
             {
                 galleryCBPopUp->addSubMenu(submenuName, *submenus.getLast());
                 creatingSubmenu = false;
             }
             
             //add toplevel item, if there is one
-            if(thisFile.getParentDirectory().getFileName() == bkGalleries.getFileName() ||
-               thisFile.getParentDirectory().getFileName() == moreGalleries.getFileName() ||
-               thisFile.getParentDirectory().getFileName() == moreGalleries.getChildFile("Inbox").getFileName()) //if the file is in the main galleries directory....
+            if(thisGallery.topLevel) //if the file is in the main galleries directory....
             {
                 galleryCB.addItem(galleryName, ++id); //add to toplevel popup
             }
@@ -565,7 +603,7 @@ void HeaderViewController::fillGalleryCB(void)
             {
                 creatingSubmenu = true;
                 
-                submenuName = thisFile.getParentDirectory().getFileName(); //name of submenu
+                submenuName = thisGallery.folder; //name of submenu
                 
                 if(submenuNames.contains(submenuName)) //add to existing submenu
                 {
@@ -581,7 +619,7 @@ void HeaderViewController::fillGalleryCB(void)
                 }
             }
             
-            if (thisFile.getFileName() == processor.currentGallery)
+            if (thisGallery.path.fromLastOccurrenceOf(File::separatorString, false, false) == processor.currentGallery)
             {
                 index = i;
                 lastGalleryCBId = id;
@@ -42,6 +42,8 @@ public:
     
     bool handleGalleryChange(void);
     
+    inline bool isGalleryModalOpen(void) const noexcept { return galleryModalCallBackIsOpen; }
+    
 private:
     BKAudioProcessor& processor;
     
@@ -23,7 +23,9 @@ public:
     
     ItemMapper(BKPreparationType type, int Id):
     type(type),
-    Id(Id)
+    Id(Id),
+    pianoTarget(0),
+    active(false)
     {
         
     }
@@ -19,8 +19,7 @@ theGraph(p),
 header(p, &construction),
 construction(p, &theGraph),
 overtop(p, &theGraph),
-splash(p),
-timerCallbackCount(0)
+splash(p)
 {
     if (processor.platform == BKIOS)    display = DisplayConstruction;
     else                                display = DisplayDefault;
@@ -311,6 +310,10 @@ bool MainViewController::keyPressed (const KeyPress& e, Component*)
     
     int code = e.getKeyCode();
     
+#if TRY_UNDO
+    processor.updateHistory();
+#endif
+    
     if (code == KeyPress::escapeKey)
     {
         processor.updateState->setCurrentDisplay(DisplayNil);
@@ -346,6 +349,10 @@ bool MainViewController::keyPressed (const KeyPress& e, Component*)
     else if (code == KeyPress::tabKey)
     {
         
+    }
+    else if (code == KeyPress::pageDownKey)
+    {
+        processor.setlist.requestAdvance();
     }
     else if (code == 65) // A all
     {
@@ -422,6 +429,10 @@ bool MainViewController::keyPressed (const KeyPress& e, Component*)
 #endif
     }
     
+#if TRY_UNDO
+    processor.updateHistory();
+#endif
+    
     return true;
 }
 
@@ -431,16 +442,15 @@ void MainViewController::timerCallback()
 {
     BKUpdateState::Ptr state = processor.updateState;
     
-    if (++timerCallbackCount >= 50)
+    // Set when the gallery index sees files change; hold off while the header is in a modal dialog
+    if (state->galleryIndexDidChange && !header.isGalleryModalOpen())
     {
-        timerCallbackCount = 0;
-        processor.collectGalleries();
+        state->galleryIndexDidChange = false;
+        
         header.fillGalleryCB();
     }
     
-    Array<bool> noteOns = processor.getNoteOns();
-    keyboardState.setKeymap(noteOns);
-    keyboard->repaint();
+    handleEditorEvents();
     
     if (state->pianoSamplesAreLoading)
     {
@@ -451,6 +461,16 @@ void MainViewController::timerCallback()
     else
     {
         splash.setVisible(false);
+        
+        if (processor.memoryReportPath.isNotEmpty() && processor.didLoadMainPianoSamples) processor.writeMemoryReport();
+    }
+    
+    // The audio thread stepped the setlist to a new gallery; catch up before refreshing the header below
+    if (state->setlistDidAdvance)
+    {
+        state->setlistDidAdvance = false;
+        
+        processor.setlistDidAdvance();
     }
     
     if (state->galleriesUpdated)
@@ -556,4 +576,45 @@ void MainViewController::timerCallback()
     
 }
 
+// Hands what the audio thread changed to the keys and editors that show it, so that
+// nothing is redrawn on a tick where nothing happened
+void MainViewController::handleEditorEvents(void)
+{
+    BKUpdateState::Ptr state = processor.updateState;
+    
+    bool countersMoved = false, tempoChanged = false, tuningChanged = false, nostalgicPlaying = false;
+    
+    BKEditorEvent event;
+    while (state->editorEvents.pop(event))
+    {
+        if (event.type == EditorEventNoteOn)        keyboardState.addToKeymap(event.value);
+        else if (event.type == EditorEventNoteOff)  keyboardState.removeFromKeymap(event.value);
+        else if (event.type == EditorEventCountersMoved)
+        {
+            if (event.value == state->currentSynchronicId) countersMoved = true;
+        }
+        else if (event.type == EditorEventPreparationChanged)
+        {
+            if      (event.preparation == PreparationTypeTempo)     tempoChanged |= (event.value == state->currentTempoId);
+            else if (event.preparation == PreparationTypeTuning)    tuningChanged |= (event.value == state->currentTuningId);
+            else if (event.preparation == PreparationTypeNostalgic) nostalgicPlaying |= (event.value == state->currentNostalgicId);
+        }
+    }
+    
+    // Some events didn't fit in the queue, so catch everything up from the processor
+    if (state->editorEvents.didDropEvents())
+    {
+        keyboardState.setKeymap(processor.getNoteOns());
+        keyboard->repaintKeymap();
+        
+        countersMoved = tempoChanged = tuningChanged = nostalgicPlaying = true;
+    }
+    
+    // Each of these only redraws if its editor is the one showing
+    if (countersMoved)      overtop.svc.updateCounters();
+    if (tempoChanged)       overtop.ovc.updateAdaptedTempo();
+    if (tuningChanged)      overtop.tvc.updateLastNote();
+    if (nostalgicPlaying)   overtop.nvc.showPlayPositions();
+}
+
 
@@ -164,13 +164,13 @@ private:
     
     void timerCallback() override;
     
+    void handleEditorEvents(void);
+    
     void bkButtonClicked        (Button* b)                     override;
     void sliderValueChanged     (Slider* slider)                override;
     void mouseDown (const MouseEvent &event) override;
     
     void drawPreparationPanel(void);
-
-    int timerCallbackCount;
     
     bool keyPressed (const KeyPress& e, Component*) override;
     
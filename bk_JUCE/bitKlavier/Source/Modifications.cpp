@@ -74,11 +74,7 @@ void Modifications::removeSynchronicModification(int which)
 {
     for (int i = synchronicMods.size(); --i >= 0;)
     {
-        if (synchronicMods[i]->getId() == which)
-        {
-            synchronicMods.remove(i);
-            break;
-        }
+        if (synchronicMods[i]->getId() == which) synchronicMods.remove(i);
     }
 }
 
@@ -103,11 +99,7 @@ void Modifications::removeNostalgicModification(int which)
 {
     for (int i = nostalgicMods.size(); --i >= 0;)
     {
-        if (nostalgicMods[i]->getId() == which)
-        {
-            nostalgicMods.remove(i);
-            break;
-        }
+        if (nostalgicMods[i]->getId() == which) nostalgicMods.remove(i);
     }
 }
 
@@ -131,16 +123,9 @@ void Modifications::removeDirectModification(DirectModification::Ptr m)
 
 void Modifications::removeDirectModification(int which)
 {
-    for (int i = 0; i < directMods.size(); i++)
+    for (int i = directMods.size(); --i >= 0;)
     {
-        DBG("trying to remove: " + String(which));
-        DBG("dmod ID: " + String(directMods[i]->getId()));
-        if (directMods[i]->getId() == which)
-        {
-            directMods.remove(i);
-            break;
-        }
-        
+        if (directMods[i]->getId() == which) directMods.remove(i);
     }
 }
 
@@ -166,11 +151,7 @@ void Modifications::removeTuningModification(int which)
 {
     for (int i = tuningMods.size(); --i >= 0;)
     {
-        if (tuningMods[i]->getId() == which)
-        {
-            tuningMods.remove(i);
-            break;
-        }
+        if (tuningMods[i]->getId() == which) tuningMods.remove(i);
     }
 }
 
@@ -196,11 +177,7 @@ void Modifications::removeTempoModification(int which)
 {
     for (int i = tempoMods.size(); --i >= 0;)
     {
-        if (tempoMods[i]->getId() == which)
-        {
-            tempoMods.remove(i);
-            break;
-        }
+        if (tempoMods[i]->getId() == which) tempoMods.remove(i);
     }
 }
 
@@ -17,7 +17,9 @@ NostalgicProcessor::NostalgicProcessor(Nostalgic::Ptr nostalgic,
 synth(s),
 nostalgic(nostalgic),
 tuner(tuning),
-synchronic(synchronic)
+synchronic(synchronic),
+editorEvents(nullptr),
+wasPlaying(false)
 {
     noteLengthTimers.ensureStorageAllocated(128);
     velocities.ensureStorageAllocated(128);
@@ -268,6 +270,13 @@ void NostalgicProcessor::keyPressed(int midiNoteNumber, float midiNoteVelocity,
 //main scheduling function
 void NostalgicProcessor::processBlock(int numSamples, int midiChannel)
 {
+    // The editor shows play positions while there are any; tell it when there start to be some
+    const bool playing = (reverseNotes.size() > 0 || undertowNotes.size() > 0);
+    
+    if (playing && !wasPlaying && editorEvents != nullptr)
+        editorEvents->push(EditorEventPreparationChanged, PreparationTypeNostalgic, getId());
+    
+    wasPlaying = playing;
     
     incrementTimers(numSamples);
 
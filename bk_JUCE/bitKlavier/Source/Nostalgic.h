@@ -701,6 +701,11 @@ public:
     Array<int> getPlayPositions();
     Array<int> getUndertowPositions();
     
+    // Reverse and undertow notes in flight, which should drop back to 0 once everything has played out
+    inline int getNumNoteStuffs(void) const noexcept { return reverseNotes.size() + undertowNotes.size(); }
+    
+    inline void setEditorEvents(BKEditorEventQueue* events) { editorEvents = events; }
+    
 private:
     BKSynthesiser*              synth;
     
@@ -718,6 +723,9 @@ private:
     
     double sampleRate;
     
+    BKEditorEventQueue* editorEvents; // not owned; told when notes start playing back
+    bool wasPlaying;
+    
     //move timers forward by blocksize
     void incrementTimers(int numSamples);
     
@@ -174,8 +174,6 @@ NostalgicViewController(p, theGraph)
     beatsToSkipSlider->addMyListener(this);
     
     gainSlider->addMyListener(this);
-    
-    startTimer(20);
 }
 
 void NostalgicPreparationEditor::BKWaveDistanceUndertowSliderValueChanged(String name, double wavedist, double undertow)
@@ -438,21 +436,31 @@ void NostalgicPreparationEditor::fillSelectCB(int last, int current)
     
 }
 
+void NostalgicPreparationEditor::showPlayPositions(void)
+{
+    if (!isTimerRunning()) startTimer(20);
+}
+
 void NostalgicPreparationEditor::timerCallback()
 {
+    Array<int> currentPlayPositions;
+    
     if (processor.updateState->currentDisplay == DisplayNostalgic)
     {
         NostalgicProcessor::Ptr nProcessor = processor.currentPiano->getNostalgicProcessor(processor.updateState->currentNostalgicId);
         
         if (nProcessor != nullptr)
         {
-            Array<int> currentPlayPositions = nProcessor->getPlayPositions();
+            currentPlayPositions = nProcessor->getPlayPositions();
             Array<int> currentUndertowPositions = nProcessor->getUndertowPositions();
             currentPlayPositions.addArray(currentUndertowPositions);
-            
-            nDisplaySlider.updateSliderPositions(currentPlayPositions);
         }
     }
+    
+    nDisplaySlider.updateSliderPositions(currentPlayPositions);
+    
+    // Nothing left playing back: this update cleared the positions, so stop until the next note
+    if (currentPlayPositions.size() == 0) stopTimer();
 }
 
 
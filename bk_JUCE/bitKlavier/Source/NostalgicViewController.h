@@ -74,6 +74,8 @@ public:
     
     void fillSelectCB(int last, int current);
     
+    // Follows the play positions while notes are playing back; the timer stops once they're done
+    void showPlayPositions(void);
     void timerCallback() override;
     
     static void actionButtonCallback(int action, NostalgicPreparationEditor*);
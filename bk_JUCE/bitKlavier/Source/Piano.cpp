@@ -20,7 +20,12 @@ currentPMap(PreparationMap::Ptr()),
 activePMaps(PreparationMap::CSPtrArr()),
 prepMaps(PreparationMap::CSPtrArr()),
 processor(p),
-Id(Id)
+gallery(nullptr),
+history(new PianoHistory(*this, p)),
+Id(Id),
+indexedItems(0),
+indexedIdentity(0),
+lastIndexedItem(nullptr)
 {
     numPMaps = 0;
     pianoMap.ensureStorageAllocated(128);
@@ -41,13 +46,58 @@ Id(Id)
 
 Piano::~Piano()
 {
-    for (int i = 0; i < items.size(); i++)  items[i]->connections.clear();;
+    for (int i = 0; i < items.size(); i++)  items[i]->clearConnections();
     items.clear();
 }
 
+void Piano::reportMemory(BKMemoryReport& report) const
+{
+    // The audio thread adds and drops nostalgic notes, keys played and tempo history while it holds this
+    const ScopedLock sl (getConfigurationLock());
+    
+    report.addBytes(sizeof(Piano) + (pianoMap.size() + 128) * (int64)sizeof(int));
+    
+    int64 itemBytes = 0;
+    for (auto item : items) itemBytes += sizeof(BKItem) + item->getConnections().size() * (int64)sizeof(BKItem::Ptr);
+    
+    report.add("items", itemBytes + itemIndex.size() * (int64)sizeof(BKItem*), items.size());
+    
+    report.add("modifications", modificationMap.size() * (int64)sizeof(Modifications), modificationMap.size());
+    
+    BKMemoryReport& processors = report.add("processors");
+    processors.add("direct",        dprocessor.size() * (int64)sizeof(DirectProcessor),        dprocessor.size());
+    processors.add("synchronic",    sprocessor.size() * (int64)sizeof(SynchronicProcessor),    sprocessor.size());
+    processors.add("nostalgic",     nprocessor.size() * (int64)sizeof(NostalgicProcessor),     nprocessor.size());
+    processors.add("tuning",        tprocessor.size() * (int64)sizeof(TuningProcessor),        tprocessor.size());
+    processors.add("tempo",         mprocessor.size() * (int64)sizeof(TempoProcessor),         mprocessor.size());
+    
+    int numNoteStuffs = 0;
+    for (auto proc : nprocessor) numNoteStuffs += proc->getNumNoteStuffs();
+    
+    processors.add("nostalgic notes", numNoteStuffs * (int64)sizeof(NostalgicNoteStuff), numNoteStuffs);
+    
+    int numKeysPlayed = 0;
+    for (auto proc : dprocessor) numKeysPlayed += proc->getNumKeysPlayed();
+    
+    processors.add("direct keys played", numKeysPlayed * (int64)(sizeof(int) + sizeof(float)), numKeysPlayed);
+    
+    int numAtDeltas = 0;
+    for (auto proc : mprocessor) numAtDeltas += proc->getNumAtDeltas();
+    
+    processors.add("tempo history", numAtDeltas * (int64)sizeof(int), numAtDeltas);
+    
+    if (history != nullptr) report.add("undo history", (int64)history->getMemoryUsage(), history->getNumSteps());
+    
+    BKMemoryReport& maps = report.add("preparation maps", 0, prepMaps.size());
+    for (auto pmap : prepMaps) pmap->reportMemory(maps.add("keymap " + String(pmap->getKeymapId())));
+}
+
 void Piano::clear(void)
 {
     items.clear();
+    clearItemIndex();
+    
+    ++BKItem::structureRevision;
 }
 
 void Piano::deconfigure(void)
@@ -76,9 +126,30 @@ void Piano::deconfigure(void)
     }
 }
 
+Gallery* Piano::getGallery(void)
+{
+    return (gallery != nullptr) ? gallery : processor.gallery.get();
+}
+
+CriticalSection& Piano::getConfigurationLock(void) const
+{
+    return (gallery == nullptr || gallery == processor.gallery.get()) ? processor.configurationLock : offlineLock;
+}
+
 #define DEFAULT_ID -1
+void Piano::configureDefaults(void)
+{
+    if (defaultT == nullptr || !tprocessor.contains(defaultT))  defaultT = getTuningProcessor(DEFAULT_ID);
+    
+    if (defaultM == nullptr || !mprocessor.contains(defaultM))  defaultM = getTempoProcessor(DEFAULT_ID);
+    
+    if (defaultS == nullptr || !sprocessor.contains(defaultS))  defaultS = getSynchronicProcessor(DEFAULT_ID);
+}
+
 void Piano::configure(void)
 {
+    const ScopedLock sl (getConfigurationLock());
+    
     deconfigure();
     
     defaultT = getTuningProcessor(DEFAULT_ID);
@@ -96,7 +167,7 @@ void Piano::configure(void)
         DBG("type: " + cPreparationTypes[thisType] + " Id: " + String(thisId));
         DBG("bounds: " + rectangleToString(item->getBounds()));
         
-        if (thisId > processor.gallery->getIdCount(thisType)) processor.gallery->setIdCount(thisType, thisId);
+        if (thisId > getGallery()->getIdCount(thisType)) getGallery()->setIdCount(thisType, thisId);
         
         addProcessor(thisType, thisId);
     }
@@ -107,7 +178,7 @@ void Piano::configure(void)
         int Id = item->getId();
         
         
-        // Connect keymaps to everything
+        // Connect keymaps to preparations
         // Connect tunings, tempos, synchronics to preparations
         // Connect mods and resets to all their targets
         // Configure piano maps
@@ -124,23 +195,24 @@ void Piano::configure(void)
                 {
                     linkPreparationWithKeymap(targetType, targetId, Id);
                 }
-                else if (targetType >= PreparationTypeDirectMod && targetType <= PreparationTypeTempoMod)
-                {
-                    configureModification(target);
-                }
-                else if (targetType == PreparationTypePianoMap)
-                {
-                    configurePianoMap(target);
-                }
-                else if (targetType == PreparationTypeReset)
-                {
-                    configureReset(target);
-                }
             }
             
             connex.clear();
 
         }
+        else if (type >= PreparationTypeDirectMod && type <= PreparationTypeTempoMod)
+        {
+            // Each mod is configured once from its own connections, rather than once per keymap
+            configureModification(item);
+        }
+        else if (type == PreparationTypePianoMap)
+        {
+            configurePianoMap(item);
+        }
+        else if (type == PreparationTypeReset)
+        {
+            configureReset(item);
+        }
         else if (type == PreparationTypeTuning)
         {
             // Look for synchronic, direct, and nostalgic targets
@@ -151,7 +223,7 @@ void Piano::configure(void)
                 
                 if (targetType >= PreparationTypeDirect && targetType <= PreparationTypeNostalgic)
                 {
-                    linkPreparationWithTuning(targetType, targetId, processor.gallery->getTuning(Id));
+                    linkPreparationWithTuning(targetType, targetId, getGallery()->getTuning(Id));
                 }
             }
         }
@@ -165,7 +237,7 @@ void Piano::configure(void)
                 
                 if (targetType == PreparationTypeSynchronic)
                 {
-                    linkSynchronicWithTempo(processor.gallery->getSynchronic(targetId), processor.gallery->getTempo(Id));
+                    linkSynchronicWithTempo(getGallery()->getSynchronic(targetId), getGallery()->getTempo(Id));
                 }
             }
         }
@@ -179,7 +251,7 @@ void Piano::configure(void)
                 
                 if (targetType == PreparationTypeNostalgic)
                 {
-                    linkNostalgicWithSynchronic(processor.gallery->getNostalgic(targetId), processor.gallery->getSynchronic(Id));
+                    linkNostalgicWithSynchronic(getGallery()->getNostalgic(targetId), getGallery()->getSynchronic(Id));
                 }
             }
         }
@@ -188,14 +260,246 @@ void Piano::configure(void)
     processor.updateState->pianoDidChangeForGraph = true;
 }
 
+// Incremental counterparts to configure(). The construction site changes one item or one connection at a time,
+// so rather than tearing everything down we only touch the PreparationMap, modification map entries and links
+// that depend on the edit. Everything happens under the processor's configurationLock. processBlock only
+// dispatches to the current piano when it gets that lock, so the audio thread never sees a half-applied edit.
+void Piano::configureItem(BKItem::Ptr item)
+{
+    const ScopedLock sl (getConfigurationLock());
+    
+    configureDefaults();
+    
+    BKPreparationType type = item->getType();
+    int Id = item->getId();
+    
+    if (type >= PreparationTypeDirect && type <= PreparationTypeTempo)
+    {
+        if (Id > getGallery()->getIdCount(type)) getGallery()->setIdCount(type, Id);
+        
+        if (!containsProcessor(type, Id)) addProcessor(type, Id);
+    }
+    
+    for (auto target : item->getConnections()) configureConnection(item, target);
+    
+    processor.updateState->pianoDidChangeForGraph = true;
+}
+
+// Removes what this item owns in the configuration (its processor, PreparationMap or map entries).
+// Links that go through its connections are handled by deconfigureConnection as those are removed.
+void Piano::deconfigureItem(BKItem::Ptr item)
+{
+    const ScopedLock sl (getConfigurationLock());
+    
+    BKPreparationType type = item->getType();
+    int Id = item->getId();
+    
+    if (type >= PreparationTypeDirect && type <= PreparationTypeTempo)
+    {
+        removeProcessor(type, Id);
+    }
+    else if (type == PreparationTypeKeymap)
+    {
+        if (getPreparationMapWithKeymap(Id) != nullptr) removePreparationMapWithKeymap(Id);
+    }
+    else if (type >= PreparationTypeDirectMod && type <= PreparationTypeTempoMod)
+    {
+        deconfigureModification(item);
+    }
+    else if (type == PreparationTypePianoMap)
+    {
+        configurePianoMaps();
+    }
+    else if (type == PreparationTypeReset)
+    {
+        configureResets();
+    }
+    
+    processor.updateState->pianoDidChangeForGraph = true;
+}
+
+void Piano::configureConnection(BKItem::Ptr item1, BKItem::Ptr item2)
+{
+    updateConnection(item1, item2, true);
+}
+
+void Piano::deconfigureConnection(BKItem::Ptr item1, BKItem::Ptr item2)
+{
+    updateConnection(item1, item2, false);
+}
+
+void Piano::updateConnection(BKItem::Ptr item1, BKItem::Ptr item2, bool connected)
+{
+    const ScopedLock sl (getConfigurationLock());
+    
+    configureDefaults();
+    
+    // Order so that item1 has the lower type (preparations < keymap < mods < piano maps < resets)
+    if (item2->getType() < item1->getType())
+    {
+        BKItem::Ptr temp = item1;
+        item1 = item2;
+        item2 = temp;
+    }
+    
+    BKPreparationType type1 = item1->getType(), type2 = item2->getType();
+    int Id1 = item1->getId(), Id2 = item2->getId();
+    
+    if (type2 >= PreparationTypeDirectMod && type2 <= PreparationTypeTempoMod)
+    {
+        // Mods are rebuilt from their remaining connections
+        deconfigureModification(item2);
+        configureModification(item2);
+    }
+    else if (type2 == PreparationTypePianoMap)
+    {
+        configurePianoMaps();
+    }
+    else if (type2 == PreparationTypeReset)
+    {
+        configureResets();
+    }
+    else if (type2 == PreparationTypeKeymap && type1 >= PreparationTypeDirect && type1 <= PreparationTypeTempo)
+    {
+        if (connected)  linkPreparationWithKeymap(type1, Id1, Id2);
+        else            removePreparationFromKeymap(type1, Id1, Id2);
+    }
+    else if (type2 == PreparationTypeTuning && type1 >= PreparationTypeDirect && type1 <= PreparationTypeNostalgic)
+    {
+        if (connected)  linkPreparationWithTuning(type1, Id1, getGallery()->getTuning(Id2));
+        else            unlinkPreparationFromTuning(type1, Id1);
+    }
+    else if (type1 == PreparationTypeSynchronic && type2 == PreparationTypeTempo)
+    {
+        if (connected)  linkSynchronicWithTempo(getGallery()->getSynchronic(Id1), getGallery()->getTempo(Id2));
+        else
+        {
+            // Disconnecting shouldn't make a processor that wasn't there
+            SynchronicProcessor::Ptr sproc = getSynchronicProcessor(Id1, false);
+            if (sproc != nullptr) sproc->setTempo(defaultM);
+        }
+    }
+    else if (type1 == PreparationTypeSynchronic && type2 == PreparationTypeNostalgic)
+    {
+        if (connected)  linkNostalgicWithSynchronic(getGallery()->getNostalgic(Id2), getGallery()->getSynchronic(Id1));
+        else
+        {
+            NostalgicProcessor::Ptr nproc = getNostalgicProcessor(Id2, false);
+            if (nproc != nullptr) nproc->setSynchronic(defaultS);
+        }
+    }
+    
+    processor.updateState->pianoDidChangeForGraph = true;
+}
+
+void Piano::removeProcessor(BKPreparationType thisType, int thisId)
+{
+    if (thisId == DEFAULT_ID) return;
+    
+    // Drop it from every PreparationMap, and drop any map left with nothing to play
+    Array<int> emptyKeymaps;
+    for (auto pmap : prepMaps)
+    {
+        if (thisType == PreparationTypeDirect)          pmap->removeDirectProcessor(thisId);
+        else if (thisType == PreparationTypeSynchronic) pmap->removeSynchronicProcessor(thisId);
+        else if (thisType == PreparationTypeNostalgic)  pmap->removeNostalgicProcessor(thisId);
+        else if (thisType == PreparationTypeTuning)     pmap->removeTuningProcessor(thisId);
+        else if (thisType == PreparationTypeTempo)      pmap->removeTempoProcessor(thisId);
+        
+        if (!pmap->isActive) emptyKeymaps.add(pmap->getKeymapId());
+    }
+    
+    for (auto keymap : emptyKeymaps) removePreparationMapWithKeymap(keymap);
+    
+    // Anything linked to it falls back to the piano defaults
+    if (thisType == PreparationTypeDirect)
+    {
+        DirectProcessor::Ptr dproc = getDirectProcessor(thisId, false);
+        if (dproc != nullptr) dprocessor.removeFirstMatchingValue(dproc);
+    }
+    else if (thisType == PreparationTypeSynchronic)
+    {
+        SynchronicProcessor::Ptr sproc = getSynchronicProcessor(thisId, false);
+        if (sproc == nullptr) return;
+        
+        for (auto nproc : nprocessor) if (nproc->getSynchronic() == sproc) nproc->setSynchronic(defaultS);
+        
+        sprocessor.removeFirstMatchingValue(sproc);
+    }
+    else if (thisType == PreparationTypeNostalgic)
+    {
+        NostalgicProcessor::Ptr nproc = getNostalgicProcessor(thisId, false);
+        if (nproc != nullptr) nprocessor.removeFirstMatchingValue(nproc);
+    }
+    else if (thisType == PreparationTypeTuning)
+    {
+        TuningProcessor::Ptr tproc = getTuningProcessor(thisId, false);
+        if (tproc == nullptr) return;
+        
+        for (auto dproc : dprocessor) if (dproc->getTuning() == tproc) dproc->setTuning(defaultT);
+        for (auto sproc : sprocessor) if (sproc->getTuning() == tproc) sproc->setTuning(defaultT);
+        for (auto nproc : nprocessor) if (nproc->getTuning() == tproc) nproc->setTuning(defaultT);
+        
+        tprocessor.removeFirstMatchingValue(tproc);
+    }
+    else if (thisType == PreparationTypeTempo)
+    {
+        TempoProcessor::Ptr mproc = getTempoProcessor(thisId, false);
+        if (mproc == nullptr) return;
+        
+        for (auto sproc : sprocessor) if (sproc->getTempo() == mproc) sproc->setTempo(defaultM);
+        
+        mprocessor.removeFirstMatchingValue(mproc);
+    }
+}
+
+void Piano::unlinkPreparationFromTuning(BKPreparationType thisType, int thisId)
+{
+    // Only processors that are already there; unlinking shouldn't make one
+    if (thisType == PreparationTypeDirect)
+    {
+        DirectProcessor::Ptr dproc = getDirectProcessor(thisId, false);
+        if (dproc != nullptr) dproc->setTuning(defaultT);
+    }
+    else if (thisType == PreparationTypeSynchronic)
+    {
+        SynchronicProcessor::Ptr sproc = getSynchronicProcessor(thisId, false);
+        if (sproc != nullptr) sproc->setTuning(defaultT);
+    }
+    else if (thisType == PreparationTypeNostalgic)
+    {
+        NostalgicProcessor::Ptr nproc = getNostalgicProcessor(thisId, false);
+        if (nproc != nullptr) nproc->setTuning(defaultT);
+    }
+}
+
+void Piano::removePreparationFromKeymap(BKPreparationType thisType, int thisId, int keymapId)
+{
+    PreparationMap::Ptr thisPreparationMap = getPreparationMapWithKeymap(keymapId);
+    
+    if (thisPreparationMap == nullptr) return;
+    
+    if (thisType == PreparationTypeDirect)          thisPreparationMap->removeDirectProcessor(thisId);
+    else if (thisType == PreparationTypeSynchronic) thisPreparationMap->removeSynchronicProcessor(thisId);
+    else if (thisType == PreparationTypeNostalgic)  thisPreparationMap->removeNostalgicProcessor(thisId);
+    else if (thisType == PreparationTypeTempo)      thisPreparationMap->removeTempoProcessor(thisId);
+    else if (thisType == PreparationTypeTuning)     thisPreparationMap->removeTuningProcessor(thisId);
+    
+    if (!thisPreparationMap->isActive) removePreparationMapWithKeymap(keymapId);
+}
+
 SynchronicProcessor::Ptr Piano::addSynchronicProcessor(int thisId)
 {
-    SynchronicProcessor::Ptr sproc = new SynchronicProcessor(processor.gallery->getSynchronic(thisId),
+    SynchronicProcessor::Ptr sproc = new SynchronicProcessor(getGallery()->getSynchronic(thisId),
                                         defaultT,
                                         defaultM,
                                         &processor.mainPianoSynth,
-                                        processor.gallery->getGeneralSettings());
+                                        getGallery()->getGeneralSettings());
     sproc->prepareToPlay(sampleRate, &processor.mainPianoSynth);
+    sproc->setEditorEvents(&processor.updateState->editorEvents);
+#if OVERRUN_WATCHDOG
+    sproc->setBlackBox(&processor.blackBox);
+#endif
     sprocessor.add(sproc);
     
     return sproc;
@@ -254,11 +558,12 @@ TempoProcessor::Ptr Piano::getTempoProcessor(int Id, bool add)
 
 NostalgicProcessor::Ptr Piano::addNostalgicProcessor(int thisId)
 {
-    NostalgicProcessor::Ptr nproc = new NostalgicProcessor(processor.gallery->getNostalgic(thisId),
+    NostalgicProcessor::Ptr nproc = new NostalgicProcessor(getGallery()->getNostalgic(thisId),
                                        defaultT,
                                        defaultS,
                                        &processor.mainPianoSynth);
     nproc->prepareToPlay(sampleRate, &processor.mainPianoSynth);
+    nproc->setEditorEvents(&processor.updateState->editorEvents);
     nprocessor.add(nproc);
     
     return nproc;
@@ -266,12 +571,10 @@ NostalgicProcessor::Ptr Piano::addNostalgicProcessor(int thisId)
 
 DirectProcessor::Ptr Piano::addDirectProcessor(int thisId)
 {
-    DirectProcessor::Ptr dproc = new DirectProcessor(processor.gallery->getDirect(thisId),
+    DirectProcessor::Ptr dproc = new DirectProcessor(getGallery()->getDirect(thisId),
                                     defaultT,
-                                    &processor.mainPianoSynth,
-                                    &processor.resonanceReleaseSynth,
-                                    &processor.hammerReleaseSynth);
-    dproc->prepareToPlay(sampleRate, &processor.mainPianoSynth, &processor.resonanceReleaseSynth,&processor.hammerReleaseSynth);
+                                    &processor.mainPianoSynth);
+    dproc->prepareToPlay(sampleRate, &processor.mainPianoSynth);
     dprocessor.add(dproc);
     
     return dproc;
@@ -279,8 +582,9 @@ DirectProcessor::Ptr Piano::addDirectProcessor(int thisId)
 
 TuningProcessor::Ptr Piano::addTuningProcessor(int thisId)
 {
-    TuningProcessor::Ptr tproc = new TuningProcessor(processor.gallery->getTuning(thisId));
+    TuningProcessor::Ptr tproc = new TuningProcessor(getGallery()->getTuning(thisId));
     tproc->prepareToPlay(sampleRate);
+    tproc->setEditorEvents(&processor.updateState->editorEvents);
     tprocessor.add(tproc);
     
     return tproc;
@@ -288,8 +592,9 @@ TuningProcessor::Ptr Piano::addTuningProcessor(int thisId)
 
 TempoProcessor::Ptr Piano::addTempoProcessor(int thisId)
 {
-    TempoProcessor::Ptr mproc = new TempoProcessor(processor.gallery->getTempo(thisId));
+    TempoProcessor::Ptr mproc = new TempoProcessor(getGallery()->getTempo(thisId));
     mproc->prepareToPlay(sampleRate);
+    mproc->setEditorEvents(&processor.updateState->editorEvents);
     mprocessor.add(mproc);
 
     return mproc;
@@ -304,23 +609,23 @@ bool Piano::containsProcessor(BKPreparationType thisType, int thisId)
 {
     if (thisType == PreparationTypeDirect)
     {
-        return (getDirectProcessor(thisId) == nullptr) ? false : true;
+        return (getDirectProcessor(thisId, false) == nullptr) ? false : true;
     }
     else if (thisType == PreparationTypeSynchronic)
     {
-        return (getSynchronicProcessor(thisId) == nullptr) ? false : true;
+        return (getSynchronicProcessor(thisId, false) == nullptr) ? false : true;
     }
     else if (thisType == PreparationTypeNostalgic)
     {
-        return (getNostalgicProcessor(thisId) == nullptr) ? false : true;
+        return (getNostalgicProcessor(thisId, false) == nullptr) ? false : true;
     }
     else if (thisType == PreparationTypeTuning)
     {
-        return (getTuningProcessor(thisId) == nullptr) ? false : true;
+        return (getTuningProcessor(thisId, false) == nullptr) ? false : true;
     }
     else if (thisType == PreparationTypeTempo)
     {
-        return (getTempoProcessor(thisId) == nullptr) ? false : true;
+        return (getTempoProcessor(thisId, false) == nullptr) ? false : true;
     }
     
     return false;
@@ -352,6 +657,14 @@ void Piano::addProcessor(BKPreparationType thisType, int thisId)
 
 bool Piano::contains(BKItem::Ptr thisItem)
 {
+    updateItemIndex();
+    
+    BKItem* found = itemIndex[thisItem->getKey()];
+    
+    if (found == thisItem)  return true;
+    if (found == nullptr)   return false;
+    
+    // Another item has its type and Id (comments all do)
     for (auto item : items) if (item == thisItem) return true;
     
     return false;
@@ -359,18 +672,21 @@ bool Piano::contains(BKItem::Ptr thisItem)
 
 void Piano::add(BKItem::Ptr item)
 {
-    bool added = items.addIfNotAlreadyThere(item);
+    if (contains(item)) return;
     
-    if (added)  configure();
+    items.add(item);
+    ++BKItem::structureRevision;
+    
+    configureItem(item);
 }
 
 void Piano::remove(BKItem::Ptr item)
 {
+    updateItemIndex();
+    
     bool removed = false;
     for (int i = items.size(); --i >= 0; )
     {
-        items[i]->print();
-
         if (items[i] == item)
         {
             items.remove(i);
@@ -378,7 +694,73 @@ void Piano::remove(BKItem::Ptr item)
         }
     }
     
-    if (removed) configure();
+    if (!removed) return;
+    
+    ++BKItem::structureRevision;
+    
+    const int64 key = item->getKey();
+    
+    if (itemIndex[key] == item)
+    {
+        itemIndex.remove(key);
+        
+        for (auto other : items)
+        {
+            if (other->getKey() == key)
+            {
+                itemIndex.set(key, other);
+                break;
+            }
+        }
+    }
+    
+    indexedItems = items.size();
+    lastIndexedItem = items.getLast();
+    
+    deconfigureItem(item);
+}
+
+// The item index is checked against the number of items and BKItem::identityRevision on every lookup.
+// Items are mostly appended (adding, pasting, loading, undo), so as long as nothing indexed changed type
+// or Id and the last item we indexed is still where we left it, only the new ones need indexing.
+// Anything else (an item changing type or Id) rebuilds it. Removing and clearing keep it up to date themselves.
+void Piano::updateItemIndex(void)
+{
+    const int numItems = items.size();
+    const int identity = BKItem::identityRevision.get();
+    
+    if (numItems == indexedItems && identity == indexedIdentity) return;
+    
+    const bool appended = (numItems > indexedItems && identity == indexedIdentity &&
+                           (indexedItems == 0 || items.getUnchecked(indexedItems - 1) == lastIndexedItem));
+    
+    if (!appended)
+    {
+        itemIndex.clear();
+        indexedItems = 0;
+    }
+    
+    for (int i = indexedItems; i < numItems; i++) indexItem(items.getUnchecked(i));
+    
+    indexedItems = numItems;
+    indexedIdentity = identity;
+    lastIndexedItem = items.getLast();
+}
+
+void Piano::clearItemIndex(void)
+{
+    itemIndex.clear();
+    indexedItems = 0;
+    lastIndexedItem = nullptr;
+}
+
+void Piano::indexItem(BKItem* item)
+{
+    const int64 key = item->getKey();
+    
+    if (!itemIndex.contains(key)) itemIndex.set(key, item);
+    
+    item->setIndexed();
 }
 
 void Piano::linkSynchronicWithTempo(Synchronic::Ptr synchronic, Tempo::Ptr thisTempo)
@@ -425,7 +807,7 @@ void Piano::linkPreparationWithKeymap(BKPreparationType thisType, int thisId, in
     
     if (thisPreparationMap == nullptr)
     {
-        addPreparationMap(processor.gallery->getKeymap(keymapId));
+        addPreparationMap(getGallery()->getKeymap(keymapId));
         
         thisPreparationMap = getPreparationMaps().getLast();
     }
@@ -491,7 +873,7 @@ void Piano::configureDirectModification(DirectModPreparation::Ptr mod, Array<int
     
     for (auto keymap : whichKeymaps)
     {
-        for (auto key : processor.gallery->getKeymap(keymap)->keys())
+        for (auto key : getGallery()->getKeymap(keymap)->keys())
         {
             configureDirectModification(key, mod, whichPreps);
             
@@ -539,8 +921,6 @@ void Piano::configureNostalgicModification(int key, NostalgicModPreparation::Ptr
 
 void Piano::configureReset(BKItem::Ptr item)
 {
-    Array<int> otherKeys;
-    
     Array<int> whichKeymaps = item->getConnectionIdsOfType(PreparationTypeKeymap);
     
     Array<int> direct = item->getConnectionIdsOfType(PreparationTypeDirect);
@@ -549,11 +929,9 @@ void Piano::configureReset(BKItem::Ptr item)
     Array<int> tempo = item->getConnectionIdsOfType(PreparationTypeTempo);
     Array<int> tuning = item->getConnectionIdsOfType(PreparationTypeTuning);
     
-    for (int i = 0; i < 128; i++) otherKeys.add(i);
-    
     for (auto keymap : whichKeymaps)
     {
-        for (auto key : processor.gallery->getKeymap(keymap)->keys())
+        for (auto key : getGallery()->getKeymap(keymap)->keys())
         {
             for (auto id : direct) modificationMap[key]->directReset.add(id);
             
@@ -564,17 +942,20 @@ void Piano::configureReset(BKItem::Ptr item)
             for (auto id : tuning) modificationMap[key]->tuningReset.add(id);
             
             for (auto id : tempo) modificationMap[key]->tempoReset.add(id);
-            
-            for (int i = otherKeys.size(); --i>=0;)
-            {
-                if (otherKeys[i] == key) otherKeys.remove(i);
-            }
         }
     }
+}
+
+void Piano::configureResets(void)
+{
+    const ScopedLock sl (getConfigurationLock());
     
+    for (int key = 0; key < 128; key++) modificationMap[key]->clearResets();
     
-    deconfigureResetForKeys(item, otherKeys);
-    
+    for (auto item : items)
+    {
+        if (item->getType() == PreparationTypeReset) configureReset(item);
+    }
 }
 
 void Piano::deconfigureResetForKeys(BKItem::Ptr item, Array<int> otherKeys)
@@ -641,7 +1022,7 @@ void Piano::configurePianoMap(BKItem::Ptr map)
     
     for (auto keymap : keymaps)
     {
-        Keymap::Ptr thisKeymap = processor.gallery->getKeymap(keymap);
+        Keymap::Ptr thisKeymap = getGallery()->getKeymap(keymap);
         for (auto key : thisKeymap->keys())
         {
             pianoMap.set(key, pianoTarget);
@@ -651,6 +1032,33 @@ void Piano::configurePianoMap(BKItem::Ptr map)
     }
 }
 
+void Piano::configurePianoMaps(void)
+{
+    const ScopedLock sl (getConfigurationLock());
+    
+    for (int key = 0; key < 128; key++) pianoMap.set(key, -1);
+    
+    for (auto item : items)
+    {
+        if (item->getType() == PreparationTypePianoMap) configurePianoMap(item);
+    }
+}
+
+void Piano::deconfigureModification(BKItem::Ptr map)
+{
+    BKPreparationType modType = map->getType();
+    int Id = map->getId();
+    
+    for (int key = 0; key < 128; key++)
+    {
+        if (modType == PreparationTypeDirectMod)            modificationMap[key]->removeDirectModification(Id);
+        else if (modType == PreparationTypeSynchronicMod)   modificationMap[key]->removeSynchronicModification(Id);
+        else if (modType == PreparationTypeNostalgicMod)    modificationMap[key]->removeNostalgicModification(Id);
+        else if (modType == PreparationTypeTuningMod)       modificationMap[key]->removeTuningModification(Id);
+        else if (modType == PreparationTypeTempoMod)        modificationMap[key]->removeTempoModification(Id);
+    }
+}
+
 void Piano::configureModification(BKItem::Ptr map)
 {
     map->print();
@@ -668,23 +1076,23 @@ void Piano::configureModification(BKItem::Ptr map)
     if (modType == BKPreparationTypeNil) return;
     else if (modType == PreparationTypeDirectMod)
     {
-        configureDirectModification(processor.gallery->getDirectModPreparation(Id), whichKeymaps, whichPreps);
+        configureDirectModification(getGallery()->getDirectModPreparation(Id), whichKeymaps, whichPreps);
     }
     else if (modType == PreparationTypeSynchronicMod)
     {
-        configureSynchronicModification(processor.gallery->getSynchronicModPreparation(Id), whichKeymaps, whichPreps);
+        configureSynchronicModification(getGallery()->getSynchronicModPreparation(Id), whichKeymaps, whichPreps);
     }
     else if (modType == PreparationTypeNostalgicMod)
     {
-        configureNostalgicModification(processor.gallery->getNostalgicModPreparation(Id), whichKeymaps, whichPreps);
+        configureNostalgicModification(getGallery()->getNostalgicModPreparation(Id), whichKeymaps, whichPreps);
     }
     else if (modType == PreparationTypeTuningMod)
     {
-        configureTuningModification(processor.gallery->getTuningModPreparation(Id), whichKeymaps, whichPreps);
+        configureTuningModification(getGallery()->getTuningModPreparation(Id), whichKeymaps, whichPreps);
     }
     else if (modType == PreparationTypeTempoMod)
     {
-        configureTempoModification(processor.gallery->getTempoModPreparation(Id), whichKeymaps, whichPreps);
+        configureTempoModification(getGallery()->getTempoModPreparation(Id), whichKeymaps, whichPreps);
     }
 
 }
@@ -697,7 +1105,7 @@ void Piano::configureNostalgicModification(NostalgicModPreparation::Ptr mod, Arr
     
     for (auto keymap : whichKeymaps)
     {
-        for (auto key : processor.gallery->getKeymap(keymap)->keys())
+        for (auto key : getGallery()->getKeymap(keymap)->keys())
         {
             configureNostalgicModification(key, mod, whichPreps);
             otherKeys.remove(key);
@@ -746,7 +1154,7 @@ void Piano::configureSynchronicModification(SynchronicModPreparation::Ptr mod, A
     
     for (auto keymap : whichKeymaps)
     {
-        for (auto key : processor.gallery->getKeymap(keymap)->keys())
+        for (auto key : getGallery()->getKeymap(keymap)->keys())
         {
             configureSynchronicModification(key, mod, whichPreps);
             otherKeys.remove(key);
@@ -797,7 +1205,7 @@ void Piano::configureTempoModification(TempoModPreparation::Ptr mod, Array<int>
     
     for (auto keymap : whichKeymaps)
     {
-        for (auto key : processor.gallery->getKeymap(keymap)->keys())
+        for (auto key : getGallery()->getKeymap(keymap)->keys())
         {
             configureTempoModification(key, mod, whichPreps);
             otherKeys.remove(key);
@@ -850,7 +1258,7 @@ void Piano::configureTuningModification(TuningModPreparation::Ptr mod, Array<int
     
     for (auto keymap : whichKeymaps)
     {
-        for (auto key : processor.gallery->getKeymap(keymap)->keys())
+        for (auto key : getGallery()->getKeymap(keymap)->keys())
         {
             configureTuningModification(key, mod, whichPreps);
             otherKeys.remove(key);
@@ -876,7 +1284,7 @@ void Piano::deconfigureTuningModificationForKeys(TuningModPreparation::Ptr mod,
 // Add preparation map, return its Id.
 int Piano::addPreparationMap(void)
 {
-    PreparationMap::Ptr thisPreparationMap = new PreparationMap(processor.gallery->getKeymap(0), numPMaps);
+    PreparationMap::Ptr thisPreparationMap = new PreparationMap(getGallery()->getKeymap(0), numPMaps);
     
     prepMaps.add(thisPreparationMap);
     
@@ -884,6 +1292,8 @@ int Piano::addPreparationMap(void)
     
     activePMaps.add(thisPreparationMap);
     
+    numPMaps = prepMaps.size();
+    
     return prepMaps.size()-1;
 }
 
@@ -900,6 +1310,8 @@ int Piano::addPreparationMap(Keymap::Ptr keymap)
     
     activePMaps.add(thisPreparationMap);
     
+    numPMaps = prepMaps.size();
+    
     return prepMaps.size()-1;
 }
 
@@ -939,7 +1351,7 @@ int Piano::removePreparationMapWithKeymap(int Id)
         }
     }
     
-    --numPMaps;
+    numPMaps = prepMaps.size();
     
     return numPMaps;
 }
@@ -968,7 +1380,7 @@ void Piano::prepareToPlay(double sr)
     sampleRate = sr;
 
     for (auto dproc : dprocessor)
-        dproc->prepareToPlay(sampleRate, &processor.mainPianoSynth, &processor.resonanceReleaseSynth, &processor.hammerReleaseSynth);
+        dproc->prepareToPlay(sampleRate, &processor.mainPianoSynth);
     
     for (auto mproc : mprocessor)
         mproc->prepareToPlay(sampleRate);
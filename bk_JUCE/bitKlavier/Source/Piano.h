@@ -25,9 +25,14 @@
 
 class BKAudioProcessor;
 
+class Gallery;
+
 #include "BKGraph.h"
 
-class Piano : public ReferenceCountedObject
+#include "PianoHistory.h"
+
+class Piano : public ReferenceCountedObject,
+              public BKMemoryAccountable
 {
 public:
     typedef ReferenceCountedObjectPtr<Piano>   Ptr;
@@ -55,7 +60,7 @@ public:
             newItem->setTopLeftPosition(item->getPosition());
             newItem->setName(item->getName());
             
-            copyPiano->add(newItem);
+            copyPiano->items.add(newItem);
             newItems.add(newItem);
             
         }
@@ -69,14 +74,9 @@ public:
             
             for (auto connection : item->getConnections())
             {
-                for (auto newConnection : newItems)
-                {
-                    if ((newConnection->getType() == connection->getType()) &&
-                        (newConnection->getId() == connection->getId()))
-                    {
-                        newItem->addConnection(newConnection);
-                    }
-                }
+                BKItem* newConnection = copyPiano->itemWithTypeAndId(connection->getType(), connection->getId());
+                
+                if (newConnection != nullptr) newItem->addConnection(newConnection);
             }
         }
         
@@ -183,32 +183,24 @@ public:
     OwnedArray<Modifications> modificationMap;
     
     inline BKItem::PtrArr getItems(void) const noexcept { return items; }
+    inline int getNumItems(void) const noexcept { return items.size(); }
     
     inline BKItem* itemWithTypeAndId(BKPreparationType type, int thisId)
     {
-        for (auto item : items)
-        {
-            if ((item->getType() == type) && (item->getId() == thisId)) return item;
-        }
-        return nullptr;
+        updateItemIndex();
+        return itemIndex[BKItem::getKey(type, thisId)];
     }
     
     inline bool contains(BKPreparationType type, int thisId)
     {
-        for (auto item : items)
-        {
-            if ((item->getType() == type) && (item->getId() == thisId)) return true;
-        }
-        return false;
+        updateItemIndex();
+        return itemIndex.contains(BKItem::getKey(type, thisId));
     }
     
     inline bool isActive(BKPreparationType type, int thisId)
     {
-        for (auto item : items)
-        {
-            if (item->getType() == type && item->getId() == thisId) return item->isActive();
-        }
-        return false;
+        BKItem* item = itemWithTypeAndId(type, thisId);
+        return (item != nullptr) && item->isActive();
     }
     
     inline void setActive(BKPreparationType type, int thisId, bool active)
@@ -219,13 +211,20 @@ public:
         }
     }
     
-    inline void clearItems(void) { items.clear(); }
+    inline void clearItems(void) { items.clear(); clearItemIndex(); }
     
     void add(BKItem::Ptr item);
     bool contains(BKItem::Ptr item);
     void remove(BKItem::Ptr item);
     void configure(void);
     void deconfigure(void);
+    
+    // Incremental configuration for single edits (see Piano.cpp)
+    void configureItem(BKItem::Ptr item);
+    void deconfigureItem(BKItem::Ptr item);
+    void configureConnection(BKItem::Ptr item1, BKItem::Ptr item2);
+    void deconfigureConnection(BKItem::Ptr item1, BKItem::Ptr item2);
+    void removeProcessor(BKPreparationType thisType, int thisId);
 
     BKItem::PtrArr    items;
     
@@ -239,6 +238,8 @@ public:
     
     void linkPreparationWithTuning(BKPreparationType thisType, int thisId, Tuning::Ptr thisTuning);
     
+    void unlinkPreparationFromTuning(BKPreparationType thisType, int thisId);
+    
     ValueTree getState(void);
     
     void setState(XmlElement* e);
@@ -290,8 +291,10 @@ public:
     
     void configurePianoMap(BKItem::Ptr map);
     void deconfigurePianoMap(BKItem::Ptr map);
+    void configurePianoMaps(void);
     
     void configureReset(BKItem::Ptr item);
+    void configureResets(void);
     void deconfigureResetForKeys(BKItem::Ptr item, Array<int> otherKeys);
 
     void configureModification(BKItem::Ptr map);
@@ -306,9 +309,27 @@ public:
     Array<Array<int>> pianoMaps;
     
     void reset(void);
+    
+    inline PianoHistory* getHistory(void) { return history; }
+    
+    // Items, processors (with the notes they have in flight), modifications, undo history and preparation maps
+    void reportMemory(BKMemoryReport& report) const override;
+    
+    // The gallery this piano belongs to, which it configures against. Falls back to the processor's current gallery.
+    inline void setGallery(Gallery* g) { gallery = g; }
+    Gallery* getGallery(void);
+    
 private:
     BKAudioProcessor& processor;
     
+    Gallery* gallery; // not owned, the gallery owns us
+    
+    // Pianos of a gallery that isn't playing (e.g. prefetched by the setlist) configure without holding up the audio thread
+    mutable CriticalSection offlineLock;
+    CriticalSection& getConfigurationLock(void) const;
+    
+    ScopedPointer<PianoHistory> history;
+    
     int Id;
     String pianoName;
     
@@ -319,6 +340,19 @@ private:
     TempoProcessor::Ptr defaultM;
     SynchronicProcessor::Ptr defaultS;
     
+    void configureDefaults(void);
+    void updateConnection(BKItem::Ptr item1, BKItem::Ptr item2, bool connected);
+    
+    // Items by BKItem::getKey, for lookups by type and Id. Where two items share a key the first one
+    // wins, as a search through items would find. Brought up to date on the next lookup (see Piano.cpp).
+    HashMap<int64, BKItem*> itemIndex;
+    int indexedItems, indexedIdentity;
+    BKItem* lastIndexedItem;
+    
+    void updateItemIndex(void);
+    void indexItem(BKItem* item);
+    void clearItemIndex(void);
+    
     inline Array<int> getAllIds(Direct::PtrArr direct)
     {
         Array<int> which;
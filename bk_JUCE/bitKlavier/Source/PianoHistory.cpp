@@ -0,0 +1,339 @@
+/*
+  ==============================================================================
+
+    PianoHistory.cpp
+    Created: 19 Oct 2026 10:12:31am
+    Author:
+
+  ==============================================================================
+*/
+
+#include "PianoHistory.h"
+
+#include "Piano.h"
+
+#include "PluginProcessor.h"
+
+PianoHistory::PianoHistory(Piano& piano, BKAudioProcessor& p):
+piano(piano),
+processor(p),
+position(0),
+hasShadow(false),
+seenStructure(-1),
+seenGeometry(-1),
+seenIdentity(-1),
+seenSettings(-1),
+seenNumItems(-1)
+{
+
+}
+
+PianoHistory::~PianoHistory()
+{
+    steps.clear();
+    shadow.clear();
+}
+
+bool PianoHistory::ItemState::operator== (const ItemState& other) const
+{
+    return (inPiano == other.inPiano &&
+            type == other.type &&
+            Id == other.Id &&
+            pianoTarget == other.pianoTarget &&
+            active == other.active &&
+            bounds == other.bounds &&
+            name == other.name &&
+            comment == other.comment &&
+            connections == other.connections);
+}
+
+PianoHistory::ItemState PianoHistory::captureState(BKItem* item)
+{
+    ItemState state;
+
+    state.inPiano = true;
+    state.type = item->getType();
+    state.Id = item->getId();
+    state.pianoTarget = item->getPianoTarget();
+    state.active = item->isActive();
+    state.bounds = item->getBounds();
+    state.name = item->getItemName();
+
+    if (state.type == PreparationTypeComment) state.comment = item->getCommentText();
+
+    for (auto connection : item->getConnections()) state.connections.add(connection);
+
+    state.connections.sort();
+
+    return state;
+}
+
+Array<PianoHistory::Record> PianoHistory::snapshot(void)
+{
+    Array<Record> records;
+
+    BKItem::PtrArr items = piano.getItems();
+
+    records.ensureStorageAllocated(items.size());
+
+    for (auto item : items)
+    {
+        Record record;
+        record.item = item;
+        record.state = captureState(item);
+        records.add(record);
+    }
+
+    RecordSorter sorter;
+    records.sort(sorter);
+
+    return records;
+}
+
+bool PianoHistory::graphMayHaveChanged(void) const
+{
+    return (BKItem::structureRevision.get() != seenStructure ||
+            BKItem::geometryRevision.get() != seenGeometry ||
+            BKItem::identityRevision.get() != seenIdentity ||
+            BKItem::settingsRevision.get() != seenSettings ||
+            piano.getNumItems() != seenNumItems);
+}
+
+void PianoHistory::markSeen(void)
+{
+    seenStructure = BKItem::structureRevision.get();
+    seenGeometry = BKItem::geometryRevision.get();
+    seenIdentity = BKItem::identityRevision.get();
+    seenSettings = BKItem::settingsRevision.get();
+    seenNumItems = piano.getNumItems();
+}
+
+void PianoHistory::clear(void)
+{
+    steps.clear();
+    position = 0;
+
+    markSeen();
+    shadow = snapshot();
+    hasShadow = true;
+}
+
+bool PianoHistory::commit(void)
+{
+    if (hasShadow && !graphMayHaveChanged()) return false;
+
+    // Taken before the snapshot, so an edit made while we look is seen next time
+    markSeen();
+
+    Array<Record> current = snapshot();
+
+    if (!hasShadow)
+    {
+        shadow = current;
+        hasShadow = true;
+        return false;
+    }
+
+    ScopedPointer<Step> step = new Step();
+
+    // Both snapshots are sorted by item, so one merge pass finds what was added, removed or changed
+    int i = 0, j = 0;
+    while (i < shadow.size() || j < current.size())
+    {
+        BKItem* before = (i < shadow.size()) ? shadow.getReference(i).item.get() : nullptr;
+        BKItem* after = (j < current.size()) ? current.getReference(j).item.get() : nullptr;
+
+        Change change;
+
+        if (after == nullptr || (before != nullptr && before < after))
+        {
+            // Removed
+            change.item = before;
+            change.before = shadow.getReference(i).state;
+            change.after = change.before;
+            change.after.inPiano = false;
+            change.after.connections.clear();
+            ++i;
+        }
+        else if (before == nullptr || after < before)
+        {
+            // Added
+            change.item = after;
+            change.after = current.getReference(j).state;
+            change.before = change.after;
+            change.before.inPiano = false;
+            change.before.connections.clear();
+            ++j;
+        }
+        else
+        {
+            const ItemState& was = shadow.getReference(i).state;
+            const ItemState& is = current.getReference(j).state;
+            ++i; ++j;
+
+            if (was == is) continue;
+
+            change.item = after;
+            change.before = was;
+            change.after = is;
+        }
+
+        for (auto connection : change.before.connections)  change.retained.addIfNotAlreadyThere(connection);
+        for (auto connection : change.after.connections)   change.retained.addIfNotAlreadyThere(connection);
+
+        step->changes.add(change);
+    }
+
+    if (step->changes.size() == 0) return false;
+
+    // A new edit drops anything that could have been redone
+    if (position < steps.size()) steps.removeRange(position, steps.size() - position);
+
+    steps.add(step.release());
+    ++position;
+
+    while (steps.size() > NUM_EPOCHS)
+    {
+        steps.remove(0);
+        --position;
+    }
+
+    shadow = current;
+
+    return true;
+}
+
+bool PianoHistory::undo(void)
+{
+    // Anything not yet committed becomes its own step so it can be undone too
+    commit();
+
+    if (!canUndo()) return false;
+
+    apply(steps.getUnchecked(--position), false);
+
+    return true;
+}
+
+bool PianoHistory::redo(void)
+{
+    if (!canRedo()) return false;
+
+    apply(steps.getUnchecked(position++), true);
+
+    return true;
+}
+
+void PianoHistory::apply(Step* step, bool forward)
+{
+    const ScopedLock sl (processor.configurationLock);
+
+    Array<BKItem*> toConfigure;
+
+    // Take out items that should not be in the piano
+    for (auto& change : step->changes)
+    {
+        const ItemState& target = forward ? change.after : change.before;
+        BKItem* item = change.item;
+
+        if (target.inPiano || !piano.contains(item)) continue;
+
+        BKItem::PtrArr connections = item->getConnections();
+        for (auto connection : connections)
+        {
+            connection->removeConnection(item);
+            item->removeConnection(connection);
+
+            piano.deconfigureConnection(item, connection);
+        }
+
+        item->setSelected(false);
+
+        piano.remove(item);
+    }
+
+    // Bring back and update the items that should be
+    for (auto& change : step->changes)
+    {
+        const ItemState& target = forward ? change.after : change.before;
+        BKItem* item = change.item;
+
+        if (!target.inPiano) continue;
+
+        bool wasInPiano = piano.contains(item);
+        bool identityChanged = (item->getType() != target.type) || (item->getId() != target.Id);
+
+        if (wasInPiano && identityChanged) piano.deconfigureItem(item);
+
+        item->setId(target.Id);
+
+        if (item->getType() != target.type) item->setItemType(target.type, false);
+
+        item->setPianoTarget(target.pianoTarget);
+        item->setActive(target.active);
+        item->setItemName(target.name);
+        item->setBounds(target.bounds);
+
+        if (target.type == PreparationTypeComment) item->setCommentText(target.comment);
+
+        if (!piano.contains(item)) piano.items.add(item);
+
+        if (!wasInPiano || identityChanged) toConfigure.add(item);
+    }
+
+    // Restore connections, touching the configuration only for the links that differ
+    for (auto& change : step->changes)
+    {
+        const ItemState& target = forward ? change.after : change.before;
+        BKItem* item = change.item;
+
+        if (!target.inPiano) continue;
+
+        BKItem::PtrArr connections = item->getConnections();
+        for (auto connection : connections)
+        {
+            if (target.connections.contains(connection)) continue;
+
+            connection->removeConnection(item);
+            item->removeConnection(connection);
+
+            piano.deconfigureConnection(item, connection);
+        }
+
+        for (auto connection : target.connections)
+        {
+            if (item->getConnections().contains(connection)) continue;
+
+            item->addConnection(connection);
+            connection->addConnection(item);
+
+            piano.configureConnection(item, connection);
+        }
+    }
+
+    for (auto item : toConfigure) piano.configureItem(item);
+
+    markSeen();
+    shadow = snapshot();
+
+    processor.updateState->pianoDidChangeForGraph = true;
+}
+
+size_t PianoHistory::getMemoryUsage(void) const
+{
+    size_t bytes = sizeof(PianoHistory) + (size_t)steps.size() * sizeof(Step);
+
+    for (auto step : steps)
+    {
+        for (auto& change : step->changes)
+        {
+            bytes += sizeof(Change);
+            bytes += (size_t)(change.before.connections.size() + change.after.connections.size()) * sizeof(BKItem*);
+            bytes += (size_t)change.retained.size() * sizeof(BKItem::Ptr);
+            bytes += change.before.name.getNumBytesAsUTF8() + change.after.name.getNumBytesAsUTF8();
+            bytes += change.before.comment.getNumBytesAsUTF8() + change.after.comment.getNumBytesAsUTF8();
+        }
+    }
+
+    return bytes;
+}
@@ -0,0 +1,128 @@
+/*
+  ==============================================================================
+
+    PianoHistory.h
+    Created: 19 Oct 2026 10:12:31am
+    Author:
+
+    Undo/redo for edits to a Piano's graph. Instead of keeping a full
+    duplicate of the piano per step, each step stores only the items whose
+    state changed (before and after), so memory grows with the size of the
+    edit rather than the size of the piano. Items removed from the piano are
+    kept alive by reference, not copied.
+
+  ==============================================================================
+*/
+
+#ifndef PIANOHISTORY_H_INCLUDED
+#define PIANOHISTORY_H_INCLUDED
+
+#include "BKUtilities.h"
+
+#include "BKGraph.h"
+
+class Piano;
+
+class PianoHistory
+{
+public:
+    PianoHistory(Piano& piano, BKAudioProcessor& p);
+    ~PianoHistory();
+
+    // Records whatever changed since the last call as one undo step. Cheap when nothing changed: the graph
+    // is only looked at once one of BKItem's revision counters has moved. Returns true if a step was added.
+    bool commit(void);
+
+    bool undo(void);
+    bool redo(void);
+
+    inline bool canUndo(void) const noexcept { return position > 0; }
+    inline bool canRedo(void) const noexcept { return position < steps.size(); }
+
+    inline int getNumSteps(void) const noexcept { return steps.size(); }
+
+    // Approximate bytes held by the undo steps (excludes the items themselves, which are shared with the piano).
+    size_t getMemoryUsage(void) const;
+
+    // Drops all steps and takes the current graph as the new starting point.
+    void clear(void);
+
+private:
+    struct ItemState
+    {
+        ItemState(void):
+        inPiano(false),
+        type(BKPreparationTypeNil),
+        Id(-1),
+        pianoTarget(-1),
+        active(false)
+        {
+        }
+
+        bool operator== (const ItemState& other) const;
+        bool operator!= (const ItemState& other) const { return !(*this == other); }
+
+        bool inPiano;
+        BKPreparationType type;
+        int Id;
+        int pianoTarget;
+        bool active;
+        Rectangle<int> bounds;
+        String name;
+        String comment;
+        Array<BKItem*> connections; // sorted, kept alive by the owning Record/Change
+    };
+
+    struct Record
+    {
+        BKItem::Ptr item;
+        ItemState state;
+    };
+
+    struct Change
+    {
+        BKItem::Ptr item;
+        ItemState before, after;
+
+        // Connected items we must keep alive so this step can be replayed after they leave the piano
+        Array<BKItem::Ptr> retained;
+    };
+
+    struct Step
+    {
+        Array<Change> changes;
+    };
+
+    struct RecordSorter
+    {
+        static int compareElements (const Record& a, const Record& b) noexcept
+        {
+            return (a.item.get() < b.item.get()) ? -1 : ((a.item.get() == b.item.get()) ? 0 : 1);
+        }
+    };
+
+    Piano& piano;
+    BKAudioProcessor& processor;
+
+    OwnedArray<Step> steps;
+    int position;       // number of steps currently applied
+
+    Array<Record> shadow;   // state of the graph as of the last commit/undo/redo, sorted by item
+    bool hasShadow;
+
+    // BKItem's revision counters and our item count when the shadow was taken
+    int seenStructure, seenGeometry, seenIdentity, seenSettings, seenNumItems;
+
+    ItemState captureState(BKItem* item);
+    Array<Record> snapshot(void);
+
+    bool graphMayHaveChanged(void) const;
+    void markSeen(void);
+
+    void apply(Step* step, bool forward);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PianoHistory)
+};
+
+
+#endif  // PIANOHISTORY_H_INCLUDED
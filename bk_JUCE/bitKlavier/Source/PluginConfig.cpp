@@ -49,7 +49,12 @@ bool BKAudioProcessor::setPreferredBusArrangement (bool isInput, int bus, const
 //==============================================================================
 void BKAudioProcessor::changeListenerCallback(ChangeBroadcaster *source)
 {
-    
+    if (source == &galleryIndex)
+    {
+        collectGalleries();
+        
+        updateState->galleryIndexDidChange = true;
+    }
 }
 
 //==============================================================================
@@ -86,6 +91,8 @@ void BKAudioProcessor::getStateInformation (MemoryBlock& destData)
         
         galleryVT.setProperty("invertSustain", getSustainInversion(), 0);
         
+        galleryVT.setProperty("voicePoolSize", getVoicePoolSize(), 0);
+        
         DBG("sustain inversion saved: " + String((int)getSustainInversion()));
         
         DBG("saving gallery and piano to plugin state: getStateInformation() "
@@ -148,6 +155,8 @@ void BKAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
             bool invertSustain = (bool)galleryXML->getStringAttribute("invertSustain").getIntValue();
             
             setSustainInversion(invertSustain);
+            
+            setVoicePoolSize(galleryXML->getStringAttribute("voicePoolSize").getIntValue());
             
             //override gallery-saved defaultPiano with pluginHost-saved defaultPiano
             setCurrentPiano(galleryXML->getStringAttribute("defaultPiano").getIntValue());
@@ -21,19 +21,35 @@ BKAudioProcessor::BKAudioProcessor(void):
 firstTime(true),
 updateState(new BKUpdateState()),
 mainPianoSynth(),
-hammerReleaseSynth(),
-resonanceReleaseSynth(),
 currentSampleType(BKLoadNil),
-loader(*this)
-#if TRY_UNDO
-,epoch(0),
-#endif
+setlist(*this),
+loader(*this),
+capture(*this)
 {
     didLoadHammersAndRes            = false;
     didLoadMainPianoSamples         = false;
+    blackBoxPiano                   = nullptr;
+    deferredMidiBytes               = 0;
+    sustainIsDown                   = false;
     
-#if TRY_UNDO
-    history.ensureStorageAllocated(10);
+#if OVERRUN_WATCHDOG
+    blackBox.setFolder(File::getSpecialLocation(File::userDocumentsDirectory).getChildFile("bitKlavier resources").getChildFile("overruns"));
+    blackBox.startThread();
+#endif
+    
+#if PARALLEL_VOICE_RENDERING
+    renderPool = new BKVoiceRenderPool(PARALLEL_VOICE_THREADS);
+    mainPianoSynth.setRenderPool(renderPool);
+#endif
+    
+    setVoicePoolSize(0);
+    
+#if VOICE_CULLING
+    mainPianoSynth.setVoiceCulling(VOICE_CULL_DB, VOICE_CULL_MS);
+#endif
+    
+#if VOICE_CPU_GOVERNOR
+    mainPianoSynth.setRenderBudget(VOICE_CPU_BUDGET * 0.01);
 #endif
     
     Process::setPriority(juce::Process::RealtimePriority);
@@ -69,8 +85,38 @@ loader(*this)
     
     uiScaleFactor = (uiScaleFactor > 1.0f) ? 1.0f : uiScaleFactor;
     
+    // Empty in a plugin; the standalone app gets its own. Only the first instance reads it,
+    // so the processor a replay makes for itself doesn't start another one.
+    static bool didReadCommandLine = false;
+    
+    if (!didReadCommandLine)
+    {
+        didReadCommandLine = true;
+        
+        const StringArray args = JUCEApplicationBase::getCommandLineParameterArray();
+        
+        for (auto arg : args)
+        {
+            if (arg.startsWith("--memory-report"))
+            {
+                memoryReportPath = arg.fromFirstOccurrenceOf("=", false, false).unquoted();
+                if (memoryReportPath.isEmpty()) memoryReportPath = "-";
+            }
+        }
+        
+        replay = BKReplay::fromCommandLine(args);
+        soak = BKSoak::fromCommandLine(args);
+        golden = BKGolden::fromCommandLine(args);
+    }
+    
+    galleryIndex.addChangeListener(this);
+    galleryIndex.start(getGalleriesFolder());
+    
     collectGalleries();
     
+    // Room for the pianos still sounding after switches, so the audio thread doesn't allocate
+    prevPianos.ensureStorageAllocated(maxPrevPianos);
+    
     updateUI();
     
     String xmlData = CharPointer_UTF8 (BinaryData::Basic_Piano_xml);
@@ -176,15 +222,16 @@ void BKAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
     bkSampleRate = sampleRate;
     
     mainPianoSynth.setCurrentPlaybackSampleRate(sampleRate);
-    hammerReleaseSynth.setCurrentPlaybackSampleRate(sampleRate);
-    resonanceReleaseSynth.setCurrentPlaybackSampleRate(sampleRate);
     
     mainPianoSynth.setGeneralSettings(gallery->getGeneralSettings());
-    resonanceReleaseSynth.setGeneralSettings(gallery->getGeneralSettings());
-    hammerReleaseSynth.setGeneralSettings(gallery->getGeneralSettings());
     
     levelBuf.setSize(2, 25);
     
+    deferredMidi.ensureSize(maxDeferredMidiBytes);
+    mergedMidi.ensureSize(maxDeferredMidiBytes * 2);
+    
+    if (renderPool != nullptr) renderPool->prepare(jmax(getTotalNumInputChannels(), getTotalNumOutputChannels()), samplesPerBlock, sampleRate);
+    
     gallery->prepareToPlay(sampleRate);
     
 #if JUCE_IOS
@@ -203,18 +250,25 @@ void BKAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
     loadPianoSamples(BKLoadHeavy); // CHANGE THIS BACK TO HEAVY
 #endif
 
-    
-#if TRY_UNDO
-    for (int i = 0; i < NUM_EPOCHS; i++)
-    {
-        history.set(i, currentPiano);
-    }
-#endif
 
 }
 
 BKAudioProcessor::~BKAudioProcessor()
 {
+    setlist.clear();
+    
+    loader.stopThread(-1);
+    
+    mainPianoSynth.setRenderPool(nullptr);
+    renderPool = nullptr;
+    
+    // Let the bank drop the samples no other instance is using
+    mainPianoSynth.clearSounds();
+    sampleBank->removeUnused();
+    
+    galleryIndex.removeChangeListener(this);
+    galleryIndex.stop();
+    
     clipboard.clear();
 }
 
@@ -223,6 +277,8 @@ void BKAudioProcessor::deleteGallery(void)
     File file(gallery->getURL());
     file.deleteFile();
     
+    galleryIndex.rescan();
+    
     loadGalleryFromPath(firstGallery());
 }
 
@@ -253,8 +309,6 @@ void BKAudioProcessor::clearBitKlavier(void)
 {
     for (int i = 0; i < 15; i++)
     {
-        hammerReleaseSynth.allNotesOff(i, true);
-        resonanceReleaseSynth.allNotesOff(i, true);
         mainPianoSynth.allNotesOff(i, true);
     }
     
@@ -311,7 +365,9 @@ void BKAudioProcessor::createNewGallery(String name, ScopedPointer<XmlElement> x
     xml->writeToFile(myFile, "");
     
     
-    galleryNames.add(myFile.getFullPathName());
+    // Pick the new file up now rather than waiting for the index to notice it
+    galleryIndex.rescan();
+    collectGalleries();
     
     if (xml != nullptr)
     {
@@ -374,6 +430,11 @@ void BKAudioProcessor::handleNoteOn(int noteNumber, float velocity, int channel)
     
     ++noteOnCount;
     noteOn.set(noteNumber, true);
+    updateState->editorEvents.pushNote(true, noteNumber);
+    
+#if OVERRUN_WATCHDOG
+    blackBox.record(BlackBoxNoteOn, noteNumber, channel, velocity);
+#endif
     
     if (allNotesOff)   allNotesOff = false;
     
@@ -410,6 +471,11 @@ void BKAudioProcessor::handleNoteOff(int noteNumber, float velocity, int channel
     int p, pm;
     
     noteOn.set(noteNumber, false);
+    updateState->editorEvents.pushNote(false, noteNumber);
+    
+#if OVERRUN_WATCHDOG
+    blackBox.record(BlackBoxNoteOff, noteNumber, channel, velocity);
+#endif
     //DBG("noteoff velocity = " + String(velocity));
     
     // Send key off to each pmap in current piano
@@ -434,6 +500,9 @@ void BKAudioProcessor::sustainActivate(void)
 {
     if(!sustainIsDown)
     {
+#if OVERRUN_WATCHDOG
+        blackBox.record(BlackBoxSustain, 1);
+#endif
         sustainIsDown = true;
         DBG("SUSTAIN ON");
         
@@ -448,6 +517,9 @@ void BKAudioProcessor::sustainDeactivate(void)
     
     if(sustainIsDown)
     {
+#if OVERRUN_WATCHDOG
+        blackBox.record(BlackBoxSustain, 0);
+#endif
         sustainIsDown = false;
         DBG("SUSTAIN OFF");
         
@@ -475,6 +547,58 @@ void BKAudioProcessor::processBlock (AudioSampleBuffer& buffer, MidiBuffer& midi
     int numSamples = buffer.getNumSamples();
     if(numSamples != levelBuf.getNumSamples()) levelBuf.setSize(buffer.getNumChannels(), numSamples);
     
+    // The message thread holds configurationLock while it reconfigures a piano. Rather than wait on it, this
+    // block only renders the voices that are already sounding and holds its MIDI over to the next block that
+    // gets the lock. UI notes and setlist advances simply stay queued until then.
+    const ScopedTryLock sl (configurationLock);
+    
+    if (!sl.isLocked())
+    {
+        for (MidiBuffer::Iterator i (midiMessages); i.getNextEvent (m, time);)
+        {
+#if MIDI_CAPTURE
+            // Captured where it arrived, not where it's played, so a replay gets the input as it was
+            capture.addMessage(m, time);
+#endif
+            addMidiWithin(deferredMidi, deferredMidiBytes, maxDeferredMidiBytes, m, 0);
+        }
+        
+        mainPianoSynth.renderNextBlock(buffer, noMidi, 0, numSamples);
+        
+        finishBlock(buffer, numSamples);
+        
+#if MIDI_CAPTURE
+        capture.blockDone(numSamples);
+#endif
+        return;
+    }
+    
+#if MIDI_CAPTURE
+    {
+        // Only this block's own MIDI; what was deferred was captured in the block it arrived in.
+        // Not read into m, which the preparations below are handed the channel of.
+        MidiMessage message;
+        int sample;
+        
+        for (MidiBuffer::Iterator i (midiMessages); i.getNextEvent (message, sample);)
+            capture.addMessage(message, sample);
+    }
+#endif
+    
+    MidiBuffer& midi = deferredMidi.isEmpty() ? midiMessages : mergeDeferredMidi(midiMessages);
+    
+    if (setlist.takeAdvanceRequest()) setlist.advance();
+    
+#if OVERRUN_WATCHDOG
+    blackBox.blockStarted(getSampleRate(), numSamples);
+    
+    if (currentPiano.get() != blackBoxPiano)
+    {
+        blackBoxPiano = currentPiano.get();
+        blackBox.record(BlackBoxPianoSwitch, currentPiano->getId());
+    }
+#endif
+    
     // Process all active prep maps in current piano
     for (auto pmap : currentPiano->activePMaps)
         pmap->processBlock(numSamples, m.getChannel(), false);
@@ -485,21 +609,33 @@ void BKAudioProcessor::processBlock (AudioSampleBuffer& buffer, MidiBuffer& midi
         for (auto pmap : prevPiano->activePMaps)
             pmap->processBlock(numSamples, m.getChannel(), true); // true for onlyNostalgic
     }
+    
+#if OVERRUN_WATCHDOG
+    blackBox.stageFinished(BlackBoxStagePreparations);
+#endif
 
     
     for(int i=0; i<notesOnUI.size(); i++)
     {
         handleNoteOn(notesOnUI.getUnchecked(i), 0.6, channel);
+        
+#if MIDI_CAPTURE
+        capture.addMessage(MidiMessage::noteOn(jmax(1, channel), notesOnUI.getUnchecked(i), 0.6f), 0);
+#endif
         notesOnUI.remove(i);
     }
     
     for(int i=0; i<notesOffUI.size(); i++)
     {
         handleNoteOff(notesOffUI.getUnchecked(i), 0.6, channel);
+        
+#if MIDI_CAPTURE
+        capture.addMessage(MidiMessage::noteOff(jmax(1, channel), notesOffUI.getUnchecked(i), 0.6f), 0);
+#endif
         notesOffUI.remove(i);
     }
     
-    for (MidiBuffer::Iterator i (midiMessages); i.getNextEvent (m, time);)
+    for (MidiBuffer::Iterator i (midi); i.getNextEvent (m, time);)
     {
         int noteNumber = m.getNoteNumber();
         //DBG("note: " + String(noteNumber) + " " + String(m.getVelocity()));
@@ -507,6 +643,13 @@ void BKAudioProcessor::processBlock (AudioSampleBuffer& buffer, MidiBuffer& midi
          
         channel = m.getChannel();
         
+        // In a setlist, program changes and the advance key step to the next entry instead of playing
+        if (setlist.isActive() && (m.isProgramChange() || (m.isNoteOnOrOff() && noteNumber == setlist.getAdvanceKey())))
+        {
+            if (!m.isNoteOff()) setlist.advance();
+            continue;
+        }
+        
         if (m.isNoteOn())
         {
             handleNoteOn(noteNumber, velocity, channel);
@@ -541,11 +684,66 @@ void BKAudioProcessor::processBlock (AudioSampleBuffer& buffer, MidiBuffer& midi
         prevPianos.clearQuick();
         allNotesOff = true;
     }
+    
+#if OVERRUN_WATCHDOG
+    blackBox.stageFinished(BlackBoxStageMidi);
+#endif
+
+    mainPianoSynth.renderNextBlock(buffer,midi,0, numSamples);
+    
+#if OVERRUN_WATCHDOG
+    blackBox.stageFinished(BlackBoxStageSynth);
+#endif
+    
+    finishBlock(buffer, numSamples);
+    
+#if OVERRUN_WATCHDOG
+    blackBox.stageFinished(BlackBoxStageOutput);
+    blackBox.blockFinished(mainPianoSynth.getNumBusyVoices());
+#endif
+    
+#if MIDI_CAPTURE
+    capture.blockDone(numSamples);
+#endif
+}
+
+void BKAudioProcessor::addMidiWithin(MidiBuffer& buffer, int& bytes, int maxBytes, const MidiMessage& m, int time)
+{
+    // What MidiBuffer keeps per event: its time, its size and its bytes
+    const int size = (int) (sizeof (int32) + sizeof (uint16)) + m.getRawDataSize();
+    
+    if (bytes + size > maxBytes)
+    {
+        ++numDroppedMidiEvents;
+        return;
+    }
+    
+    buffer.addEvent(m, time);
+    bytes += size;
+}
 
-    mainPianoSynth.renderNextBlock(buffer,midiMessages,0, numSamples);
-    hammerReleaseSynth.renderNextBlock(buffer,midiMessages,0, numSamples);
-    resonanceReleaseSynth.renderNextBlock(buffer,midiMessages,0, numSamples);
+MidiBuffer& BKAudioProcessor::mergeDeferredMidi(const MidiBuffer& midiMessages)
+{
+    // Not swapped with the host's buffer, which would leave deferredMidi with storage that isn't reserved
+    int bytes = deferredMidiBytes;
+    
+    mergedMidi.clear();
+    mergedMidi.addEvents(deferredMidi, 0, -1, 0);
+    
+    MidiMessage m;
+    int time;
     
+    for (MidiBuffer::Iterator i (midiMessages); i.getNextEvent (m, time);)
+        addMidiWithin(mergedMidi, bytes, maxDeferredMidiBytes * 2, m, time);
+    
+    deferredMidi.clear();
+    deferredMidiBytes = 0;
+    
+    return mergedMidi;
+}
+
+void BKAudioProcessor::finishBlock(AudioSampleBuffer& buffer, int numSamples)
+{
 #if JUCE_IOS
     buffer.applyGain(0, numSamples, 0.3 * gallery->getGeneralSettings()->getGlobalGain());
 #else
@@ -555,7 +753,6 @@ void BKAudioProcessor::processBlock (AudioSampleBuffer& buffer, MidiBuffer& midi
     // store buffer for level calculation when needed
     levelBuf.copyFrom(0, 0, buffer, 0, 0, numSamples);
     if(levelBuf.getNumChannels() == 2) levelBuf.copyFrom(1, 0, buffer, 1, 0, numSamples);
-    
 }
 
 double BKAudioProcessor::getLevelL()
@@ -601,6 +798,115 @@ void  BKAudioProcessor::setCurrentPiano(int which)
     gallery->setGalleryDirty(false);
 }
 
+bool BKAudioProcessor::swapInGallery(Gallery::Ptr& inGallery, Piano::Ptr& inPiano, Gallery::Ptr& outGallery, Piano::Ptr& outPiano)
+{
+    // Every slot in prevPianos is still sounding; wait for some of them to finish rather than allocate
+    if (noteOnCount && prevPianos.size() >= maxPrevPianos && !prevPianos.contains(currentPiano)) return false;
+    
+    // Hand back the references we drop so nothing is deleted here
+    outGallery = gallery;
+    outPiano = prevPiano;
+    
+    if (noteOnCount)  prevPianos.addIfNotAlreadyThere(currentPiano);
+    
+    prevPiano = currentPiano;
+    
+    gallery = inGallery;
+    currentPiano = inPiano;
+    
+#if OVERRUN_WATCHDOG
+    blackBox.record(BlackBoxSetlistAdvance, currentPiano->getId());
+    blackBoxPiano = currentPiano.get();
+#endif
+    
+    inGallery = nullptr;
+    inPiano = nullptr;
+    
+    if (sustainIsDown)
+    {
+        for (int p = currentPiano->activePMaps.size(); --p >= 0;)
+            currentPiano->activePMaps[p]->sustainPedalPressed();
+    }
+    
+    updateState->setlistDidAdvance = true;
+    
+    return true;
+}
+
+void BKAudioProcessor::setlistDidAdvance(void)
+{
+    File myFile (gallery->getURL());
+    
+    currentGallery = myFile.getFileName();
+    lastGalleryPath = myFile;
+    defaultLoaded = false;
+    
+    updateState->loadedJson = myFile.hasFileExtension(".json");
+    
+    galleryDidLoad = true;
+    
+    updateUI();
+    
+    updateGalleries();
+}
+
+void BKAudioProcessor::loadSetlistDialog(void)
+{
+    FileChooser myChooser ("Load setlist...",
+                           getGalleriesFolder(),
+                           "*.xml");
+    
+    if (myChooser.browseForFileToOpen())
+    {
+        if (!setlist.loadFromFile(myChooser.getResult()))
+        {
+            AlertWindow::showMessageBoxAsync (AlertWindow::WarningIcon,
+                                              "Setlist not loaded",
+                                              "That file isn't a setlist, or it has no entries.");
+        }
+    }
+}
+
+void BKAudioProcessor::reportMemory(BKMemoryReport& report) const
+{
+    loader.reportMemory(report.add("samples"));
+    
+    mainPianoSynth.reportMemory(report.add("synth"));
+    
+    if (gallery != nullptr) gallery->reportMemory(report.add("gallery " + gallery->getName()));
+    
+    setlist.reportMemory(report.add("setlist"));
+    
+    // Pianos switched away from while notes were still down
+    report.add("previous pianos", prevPianos.size() * (int64)sizeof(Piano::Ptr), prevPianos.size());
+    
+    // To see how much of the process the report accounts for
+    const int64 resident = getResidentMemory();
+    if (resident >= 0) report.add("resident (whole process)", resident).setShared(true);
+}
+
+void BKAudioProcessor::writeMemoryReport(void)
+{
+    BKMemoryReport report("bitKlavier");
+    
+    reportMemory(report);
+    
+    const String json = report.toJSON();
+    
+    if (memoryReportPath == "-")
+    {
+        std::cout << json << std::endl;
+    }
+    else
+    {
+        File file = File::getCurrentWorkingDirectory().getChildFile(memoryReportPath);
+        
+        if (!file.replaceWithText(json)) DBG("couldn't write memory report to " + file.getFullPathName());
+    }
+    
+    memoryReportPath = String();
+}
+
 // Reset
 void BKAudioProcessor::performResets(int noteNumber)
 {
@@ -629,6 +935,14 @@ void BKAudioProcessor::performResets(int noteNumber)
         currentPiano->getTempoProcessor(prep)->reset();
         updateState->tempoPreparationDidChange = true;
     }
+    
+#if OVERRUN_WATCHDOG
+    Modifications* mods = currentPiano->modificationMap.getUnchecked(noteNumber);
+    const int numResets = mods->directReset.size() + mods->synchronicReset.size() + mods->nostalgicReset.size()
+                        + mods->tuningReset.size() + mods->tempoReset.size();
+    
+    if (numResets > 0) blackBox.record(BlackBoxModification, noteNumber, 1, numResets);
+#endif
 }
 
 // Modification
@@ -765,6 +1079,12 @@ void BKAudioProcessor::performModifications(int noteNumber)
         
         updateState->synchronicPreparationDidChange = true;
     }
+    
+#if OVERRUN_WATCHDOG
+    const int numMods = tMod.size() + mMod.size() + dMod.size() + nMod.size() + sMod.size();
+    
+    if (numMods > 0) blackBox.record(BlackBoxModification, noteNumber, 0, numMods);
+#endif
 }
 
 void BKAudioProcessor::importCurrentGallery(void)
@@ -981,6 +1301,10 @@ void BKAudioProcessor::loadGalleryFromPath(String path)
     loadGalleryFromXml(xml);
     
     gallery->setURL(path);
+    
+#if BENCHMARK_ITEM_GRAPH
+    DBG(BKItemGraph::benchmark(*this));
+#endif
 }
 
 void BKAudioProcessor::loadJsonGalleryDialog(void)
@@ -1094,6 +1418,10 @@ void BKAudioProcessor::initializeGallery(void)
     {
         piano->configure();
         if (piano->getId() > gallery->getIdCount(PreparationTypePiano)) gallery->setIdCount(PreparationTypePiano, piano->getId());
+        
+#if TRY_UNDO
+        piano->getHistory()->clear();
+#endif
     }
     
     gallery->prepareToPlay(bkSampleRate);
@@ -1235,27 +1563,17 @@ void BKAudioProcessor::clear(BKPreparationType type, int Id)
 #if TRY_UNDO
 void BKAudioProcessor::updateHistory(void)
 {
-    for (int i = 0; i < NUM_EPOCHS; i++)
-    {
-        history.set(i+1, history.getUnchecked(i));
-    }
+    if (currentPiano == nullptr) return;
     
-    history.set(0, currentPiano->duplicate(true));
+    currentPiano->getHistory()->commit();
 }
 
 void BKAudioProcessor::timeTravel(bool forward)
 {
-    if (forward)    epoch--;
-    else            epoch++;
-    
-    if (epoch >= NUM_EPOCHS) epoch = NUM_EPOCHS-1;
-    if (epoch <  0 ) epoch = 0;
-    
-    Piano::Ptr newPiano = history.getUnchecked(epoch);
+    if (currentPiano == nullptr) return;
     
-    if (newPiano != nullptr) currentPiano = newPiano;
-    
-    updateState->pianoDidChangeForGraph = true;
+    if (forward)    currentPiano->getHistory()->redo();
+    else            currentPiano->getHistory()->undo();
 }
 #endif
 
@@ -10,8 +10,18 @@
 
 #include "BKSynthesiser.h"
 
+#include "BKVoiceRenderPool.h"
+
 #include "BKUpdateState.h"
 
+#include "BKBlackBox.h"
+
+#include "BKCapture.h"
+
+#include "BKSoak.h"
+
+#include "BKGolden.h"
+
 #include "Keymap.h"
 
 #include "Tuning.h"
@@ -24,12 +34,17 @@
 
 #include "Gallery.h"
 
+#include "GalleryIndex.h"
+
+#include "Setlist.h"
+
 #include "ItemMapper.h"
 //==============================================================================
 /**
 */
 class BKAudioProcessor  : public AudioProcessor,
-                           public ChangeListener
+                           public ChangeListener,
+                           public BKMemoryAccountable
 {
     
 public:
@@ -67,17 +82,46 @@ public:
     
     BKUpdateState::Ptr                  updateState;
 
-    // Synthesisers.
+    // Synthesiser. Hammer and resonance release sounds are sound sets of their own, played on the same voices.
     BKSynthesiser                       mainPianoSynth;
-    BKSynthesiser                       hammerReleaseSynth;
-    BKSynthesiser                       resonanceReleaseSynth;
+    
+    // Decoded samples are shared with every other instance in the process
+    SharedResourcePointer<BKSampleBank> sampleBank;
+    
+    // Worker threads the synths share to render voices (PARALLEL_VOICE_RENDERING)
+    ScopedPointer<BKVoiceRenderPool>    renderPool;
+    
+    // What the audio thread did lately, written to disk when a block overruns (OVERRUN_WATCHDOG)
+    BKBlackBox                          blackBox;
+    
+    // Incoming MIDI and the state it plays on, for replaying offline (MIDI_CAPTURE)
+    BKCapture                           capture;
+    
+    // Started by --replay=<capture> on the command line; see BKCapture.h
+    ScopedPointer<BKReplay>             replay;
+    
+    // Started by --soak on the command line; see BKSoak.h
+    ScopedPointer<BKSoak>               soak;
+    
+    // Started by --golden or --golden-record on the command line; see BKGolden.h
+    ScopedPointer<BKGolden>             golden;
     
     Piano::Ptr                          prevPiano;
     Piano::Ptr                          currentPiano;
     Piano::PtrArr                       prevPianos;
     
+    // prevPianos is allocated for this many up front, so switching on the audio thread never allocates
+    enum { maxPrevPianos = 32 };
+    
+    // Held by Piano while it (re)configures, so edits from the construction site are applied to the audio
+    // thread all at once. processBlock only tries it: when it's busy the block skips the pianos (see deferredMidi).
+    CriticalSection                     configurationLock;
+    
     StringArray mikroetudes, ns_etudes, bk_examples;
     
+    // Kept current by galleryIndex; galleryNames[i] is the path of galleries[i]
+    GalleryIndex                        galleryIndex;
+    Array<GalleryIndex::Entry>          galleries;
     StringArray                         galleryNames;
     String                              currentGallery;
     
@@ -85,9 +129,7 @@ public:
     String                              defaultName;
     
 #if TRY_UNDO
-    Piano::PtrArr                       history;
-    int epoch;
-    
+    // Records pending edits to the current piano as an undo step (see PianoHistory)
     void updateHistory(void);
     
     void timeTravel(bool forward);
@@ -96,7 +138,7 @@ public:
     void updateGalleries(void);
     
     void collectGalleries(void);
-    void collectGalleriesFromFolder(File folder);
+    File getGalleriesFolder(void);
     
     void updateUI(void);
     
@@ -127,6 +169,22 @@ public:
     void processBlock (AudioSampleBuffer&, MidiBuffer&) override;
     
     void  setCurrentPiano(int which);
+    
+    // Setlist: swapInGallery runs on the audio thread and only swaps pointers, handing back what it
+    // replaced so it can be released elsewhere. setlistDidAdvance catches the UI up afterwards.
+    // It refuses (returns false) rather than grow prevPianos past maxPrevPianos.
+    Setlist                             setlist;
+    bool  swapInGallery(Gallery::Ptr& inGallery, Piano::Ptr& inPiano, Gallery::Ptr& outGallery, Piano::Ptr& outPiano);
+    void  setlistDidAdvance(void);
+    void  loadSetlistDialog(void);
+    
+    // Where this instance's memory goes: samples, synth, gallery and prefetched setlist entries.
+    void  reportMemory(BKMemoryReport& report) const override;
+    
+    // Set by --memory-report=<file> on the command line ("-" for stdout). The report is written
+    // there as JSON once the first samples have loaded.
+    String memoryReportPath;
+    void  writeMemoryReport(void);
     void  performModifications(int noteNumber);
     void  performResets(int noteNumber);
     
@@ -275,21 +333,63 @@ public:
 
     
     inline bool getSustainInversion(void) { return sustainInverted; }
+    inline bool getSustainIsDown(void) { return sustainIsDown; }
+    
+    // The samples asked for are in and nothing else is loading
+    inline bool samplesAreLoaded(void)
+    {
+        return didLoadMainPianoSamples && !updateState->pianoSamplesAreLoading && loader.getLoadedType() == currentSampleType;
+    }
+    
+    // Main synth voices. 0 lets the pool grow from VOICE_POOL_MIN as needed; anything else pins it
+    // at that size, e.g. the peak use of a dense gallery. Saved with the plugin state.
+    void setVoicePoolSize(int numVoices);
+    inline int getVoicePoolSize(void) { return voicePoolSize; }
+    inline int getPeakVoiceUsage(void) { return mainPianoSynth.getPeakVoiceUsage(); }
+    
+    // Voices stopped for being too quiet to hear (VOICE_CULLING) and to stay within VOICE_CPU_BUDGET.
+    inline int getNumCulledVoices(void) { return mainPianoSynth.getNumCulledVoices(); }
+    inline int getNumDroppedVoices(void) { return mainPianoSynth.getNumDroppedVoices(); }
+    
+    // Blocks the render pool sent out without a chunk a worker didn't finish in time (PARALLEL_VOICE_RENDERING).
+    inline int getNumLateVoiceRenders(void) { return (renderPool != nullptr) ? renderPool->getNumLateRenders() : 0; }
+    
+    // MIDI events dropped because holding them over for the next block would have outgrown deferredMidi.
+    inline int getNumDroppedMidiEvents(void) { return numDroppedMidiEvents.get(); }
     
 private:
     
     int  currentPianoId;
     
+    int voicePoolSize;
+    
     bool sustainIsDown;
     bool sustainInverted;
    
     void sustainActivate(void);
     void sustainDeactivate(void);
     
+    void finishBlock(AudioSampleBuffer& buffer, int numSamples); // gain and metering
+    
+    // MIDI from blocks that couldn't get configurationLock, played at the start of the next block that does.
+    // Both buffers are reserved in prepareToPlay and never grow on the audio thread: events that don't fit are dropped.
+    enum { maxDeferredMidiBytes = 2048 };
+    MidiBuffer deferredMidi;
+    int deferredMidiBytes;
+    MidiBuffer mergedMidi;      // deferredMidi followed by the next block's own MIDI
+    MidiBuffer noMidi;
+    Atomic<int> numDroppedMidiEvents;
+    
+    // Adds m to buffer if it stays within maxBytes, counting bytes used; otherwise counts it as dropped.
+    void addMidiWithin(MidiBuffer& buffer, int& bytes, int maxBytes, const MidiMessage& m, int time);
+    MidiBuffer& mergeDeferredMidi(const MidiBuffer& midiMessages);
+    
     double bkSampleRate;
     
     BKSampleLoader loader;
     
+    Piano* blackBoxPiano; // last piano the black box was told about; only compared against
+    
     AudioSampleBuffer levelBuf; //for storing samples for metering/RMS calculation
     
     Array<float> tempoAlreadyLoaded;
@@ -32,7 +32,7 @@ void BKAudioProcessor::loadPianoSamples(BKSampleLoadType type)
     {
         currentSampleType = type;
         
-        didLoadMainPianoSamples = false;
+        // Once loaded, the old samples play on until the loader swaps in the new ones
         
         DBG("SAMPLE_SET: " + cBKSampleLoadTypes[type]);\
         int numSamplesPerLayer = 29;
@@ -44,48 +44,45 @@ void BKAudioProcessor::loadPianoSamples(BKSampleLoadType type)
                               (type == BKLoadMedium) ? (numSamplesPerLayer * 4) :
                               (type == BKLoadLite)   ? (numSamplesPerLayer * 2) :
                               (type == BKLoadLitest) ? (numSamplesPerLayer * 1) :
+                              (type == BKLoadTest)   ? (numSamplesPerLayer * 1) :
                                              1.0);
         
         DBG("progressInc: " + String(progressInc));
         
-        loader.startThread();
+        // The loader keeps running once started and picks up the new type
+        if (loader.isThreadRunning())   loader.notify();
+        else                            loader.startThread();
     }
     
 }
 
-void BKAudioProcessor::collectGalleriesFromFolder(File folder)
+void BKAudioProcessor::setVoicePoolSize(int numVoices)
 {
-    DirectoryIterator xmlIter (File (folder), true, "*.xml");
-    while (xmlIter.next())
-    {
-        File galleryFile (xmlIter.getFile());
-        
-        galleryNames.add(galleryFile.getFullPathName());
-    }
+    // Past VOICE_POOL_MAX the render pool would have to allocate on the audio thread
+    voicePoolSize = jlimit(0, VOICE_POOL_MAX, numVoices);
     
-    
-    DirectoryIterator jsonIter (File (folder), true, "*.json");
-    while (jsonIter.next())
-    {
-        File galleryFile (jsonIter.getFile());
-        
-        galleryNames.add(galleryFile.getFullPathName());
-    }
+    if (voicePoolSize > 0)  mainPianoSynth.setVoicePoolLimits(voicePoolSize, voicePoolSize);
+    else                    mainPianoSynth.setVoicePoolLimits(VOICE_POOL_MIN, VOICE_POOL_MAX);
 }
 
-void BKAudioProcessor::collectGalleries(void)
+File BKAudioProcessor::getGalleriesFolder(void)
 {
-    galleryNames.clear();
-    
-    File bkGalleries;
-    
 #if JUCE_IOS
-    bkGalleries = File::getSpecialLocation (File::userDocumentsDirectory);
+    return File::getSpecialLocation (File::userDocumentsDirectory);
 #else
-    bkGalleries = File::getSpecialLocation(File::userDocumentsDirectory).getChildFile("bitKlavier resources").getChildFile("galleries");
+    return File::getSpecialLocation(File::userDocumentsDirectory).getChildFile("bitKlavier resources").getChildFile("galleries");
 #endif
+}
+
+void BKAudioProcessor::collectGalleries(void)
+{
+    // No disk access here: the index is scanned on its own thread and only when files change
+    galleries = galleryIndex.getEntries();
+    
+    galleryNames.clear();
+    galleryNames.ensureStorageAllocated(galleries.size());
     
-    collectGalleriesFromFolder(bkGalleries);
+    for (auto& entry : galleries) galleryNames.add(entry.path);
 }
 
 String BKAudioProcessor::firstGallery(void)
@@ -105,8 +102,6 @@ void BKAudioProcessor::updateGalleries()
     
     gallery->getGeneralSettings();
     mainPianoSynth.updateGeneralSettings(gallery->getGeneralSettings());
-    hammerReleaseSynth.updateGeneralSettings(gallery->getGeneralSettings());
-    resonanceReleaseSynth.updateGeneralSettings(gallery->getGeneralSettings());
     
     clipboard.clear();
     
@@ -25,6 +25,15 @@ PreparationMap::~PreparationMap()
     
 }
 
+void PreparationMap::reportMemory(BKMemoryReport& report) const
+{
+    const int numProcessors = dprocessor.size() + sprocessor.size() + nprocessor.size() + mprocessor.size() + tprocessor.size();
+    
+    report.addBytes(sizeof(PreparationMap) + numProcessors * (int64)sizeof(void*), numProcessors);
+    
+    report.add("sustained notes", sustainedNotes.size() * (int64)sizeof(SustainedNote), sustainedNotes.size());
+}
+
 void PreparationMap::prepareToPlay (double sr)
 {
     sampleRate = sr;
@@ -62,6 +71,15 @@ void PreparationMap::addDirectProcessor(DirectProcessor::Ptr p)
     deactivateIfNecessary();
 }
 
+void PreparationMap::removeDirectProcessor(int Id)
+{
+    for (int i = dprocessor.size(); --i >= 0;)
+    {
+        if (dprocessor[i]->getId() == Id) dprocessor.remove(i);
+    }
+    deactivateIfNecessary();
+}
+
 
 bool PreparationMap::contains(DirectProcessor::Ptr thisOne)
 {
@@ -102,6 +120,15 @@ void PreparationMap::addNostalgicProcessor(NostalgicProcessor::Ptr p)
     deactivateIfNecessary();
 }
 
+void PreparationMap::removeNostalgicProcessor(int Id)
+{
+    for (int i = nprocessor.size(); --i >= 0;)
+    {
+        if (nprocessor[i]->getId() == Id) nprocessor.remove(i);
+    }
+    deactivateIfNecessary();
+}
+
 
 bool PreparationMap::contains(NostalgicProcessor::Ptr thisOne)
 {
@@ -142,6 +169,15 @@ void PreparationMap::addSynchronicProcessor(SynchronicProcessor::Ptr p)
     deactivateIfNecessary();
 }
 
+void PreparationMap::removeSynchronicProcessor(int Id)
+{
+    for (int i = sprocessor.size(); --i >= 0;)
+    {
+        if (sprocessor[i]->getId() == Id) sprocessor.remove(i);
+    }
+    deactivateIfNecessary();
+}
+
 bool PreparationMap::contains(SynchronicProcessor::Ptr thisOne)
 {
     for (auto p : sprocessor)
@@ -181,6 +217,15 @@ void PreparationMap::addTuningProcessor(TuningProcessor::Ptr p)
     deactivateIfNecessary();
 }
 
+void PreparationMap::removeTuningProcessor(int Id)
+{
+    for (int i = tprocessor.size(); --i >= 0;)
+    {
+        if (tprocessor[i]->getId() == Id) tprocessor.remove(i);
+    }
+    deactivateIfNecessary();
+}
+
 
 bool PreparationMap::contains(TuningProcessor::Ptr thisOne)
 {
@@ -221,6 +266,15 @@ void PreparationMap::addTempoProcessor(TempoProcessor::Ptr p)
     deactivateIfNecessary();
 }
 
+void PreparationMap::removeTempoProcessor(int Id)
+{
+    for (int i = mprocessor.size(); --i >= 0;)
+    {
+        if (mprocessor[i]->getId() == Id) mprocessor.remove(i);
+    }
+    deactivateIfNecessary();
+}
+
 
 bool PreparationMap::contains(TempoProcessor::Ptr thisOne)
 {
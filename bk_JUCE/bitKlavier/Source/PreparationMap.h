@@ -22,7 +22,8 @@
 #include "Tempo.h"
 #include "Tuning.h"
 
-class PreparationMap : public ReferenceCountedObject
+class PreparationMap : public ReferenceCountedObject,
+                       public BKMemoryAccountable
 {
 public:
     typedef ReferenceCountedObjectPtr<PreparationMap>    Ptr;
@@ -99,30 +100,35 @@ public:
     }
     
     void                        addDirectProcessor      (DirectProcessor::Ptr );
+    void                        removeDirectProcessor   (int Id);
     void                        setDirectProcessors     (DirectProcessor::PtrArr);
     DirectProcessor::PtrArr     getDirectProcessors     (void);
     DirectProcessor::Ptr        getDirectProcessor      (int Id);
     bool                        contains                (DirectProcessor::Ptr);
     
     void                        addNostalgicProcessor   (NostalgicProcessor::Ptr );
+    void                        removeNostalgicProcessor (int Id);
     void                        setNostalgicProcessors  (NostalgicProcessor::PtrArr);
     NostalgicProcessor::PtrArr  getNostalgicProcessors  (void);
     NostalgicProcessor::Ptr     getNostalgicProcessor   (int Id);
     bool                        contains                (NostalgicProcessor::Ptr);
     
     void                        addSynchronicProcessor  (SynchronicProcessor::Ptr );
+    void                        removeSynchronicProcessor (int Id);
     void                        setSynchronicProcessors (SynchronicProcessor::PtrArr);
     SynchronicProcessor::PtrArr getSynchronicProcessors (void);
     SynchronicProcessor::Ptr    getSynchronicProcessor  (int Id);
     bool                        contains                (SynchronicProcessor::Ptr);
     
     void                        addTuningProcessor      (TuningProcessor::Ptr );
+    void                        removeTuningProcessor   (int Id);
     void                        setTuningProcessors     (TuningProcessor::PtrArr);
     TuningProcessor::PtrArr     getTuningProcessors     (void);
     TuningProcessor::Ptr        getTuningProcessor      (int Id);
     bool                        contains                (TuningProcessor::Ptr);
     
     void                        addTempoProcessor       (TempoProcessor::Ptr );
+    void                        removeTempoProcessor    (int Id);
     void                        setTempoProcessors      (TempoProcessor::PtrArr);
     TempoProcessor::PtrArr      getTempoProcessors      (void);
     TempoProcessor::Ptr         getTempoProcessor       (int Id);
@@ -133,6 +139,9 @@ public:
     
     bool isActive;
     
+    // The processors it points to (the piano reports the processors themselves) and its sustained notes
+    void reportMemory(BKMemoryReport& report) const override;
+    
     void print(void)
     {
         DBG("PrepMapId: " + String(Id));
@@ -171,10 +180,8 @@ private:
     TempoProcessor::PtrArr               mprocessor;
     TuningProcessor::PtrArr              tprocessor;
     
-    // Pointers to synths (flown in from BKAudioProcessor)
+    // Pointer to synth (flown in from BKAudioProcessor)
     BKSynthesiser*              synth;
-    BKSynthesiser*              resonanceSynth;
-    BKSynthesiser*              hammerSynth;
     
     double                      sampleRate;
     
@@ -0,0 +1,478 @@
+/*
+  ==============================================================================
+
+    Setlist.cpp
+    Created: 19 Oct 2026 2:31:10pm
+    Author:
+
+  ==============================================================================
+*/
+
+#include "Setlist.h"
+
+#include "PluginProcessor.h"
+
+#define SETLIST_DEFAULT_PREFETCH 2
+#define SETLIST_DEFAULT_MEGABYTES 256
+#define SETLIST_POLL_MS 10
+
+Setlist::Setlist(BKAudioProcessor& p):
+Thread("setlist_loader"),
+processor(p),
+prefetchEntries(SETLIST_DEFAULT_PREFETCH),
+prefetchBytes((int64)SETLIST_DEFAULT_MEGABYTES << 20),
+rejectedIndex(-1),
+rejectedBytes(0)
+{
+    position.set(-1);
+    advanceKey.set(-1);
+
+    for (int i = 0; i < maxPrefetch; i++) slots.add(new Slot());
+}
+
+Setlist::~Setlist()
+{
+    clear();
+}
+
+int Setlist::getNumEntries(void) const
+{
+    const ScopedLock sl (lock);
+
+    return entries.size();
+}
+
+Setlist::Entry Setlist::getEntry(int index) const
+{
+    const ScopedLock sl (lock);
+
+    if (isPositiveAndBelow(index, entries.size())) return entries.getReference(index);
+
+    Entry none;
+    none.pianoId = 0;
+    return none;
+}
+
+void Setlist::setPrefetchLimit(int numEntries, int64 maxBytes)
+{
+    const ScopedLock sl (lock);
+
+    prefetchEntries = jlimit(1, (int)maxPrefetch, numEntries);
+    prefetchBytes = jmax((int64)0, maxBytes);
+}
+
+bool Setlist::loadFromFile(const File& file)
+{
+    ScopedPointer<XmlElement> xml (XmlDocument::parse(file));
+
+    if (xml == nullptr || !xml->hasTagName("setlist"))
+    {
+        DBG("not a setlist: " + file.getFullPathName());
+        return false;
+    }
+
+    Array<Entry> list;
+
+    forEachXmlChildElementWithTagName (*xml, e, "entry")
+    {
+        Entry entry;
+        entry.path = file.getSiblingFile(e->getStringAttribute("gallery")).getFullPathName();
+        entry.pianoId = e->getStringAttribute("piano").getIntValue();
+
+        list.add(entry);
+    }
+
+    if (list.size() == 0) return false;
+
+    setPrefetchLimit(xml->getIntAttribute("prefetch", SETLIST_DEFAULT_PREFETCH),
+                     (int64)xml->getIntAttribute("maxMegabytes", SETLIST_DEFAULT_MEGABYTES) << 20);
+
+    setAdvanceKey(xml->getIntAttribute("advanceKey", -1));
+
+    start(list);
+
+    return true;
+}
+
+void Setlist::start(const Array<Entry>& list)
+{
+    clear();
+
+    if (list.size() == 0) return;
+
+    {
+        const ScopedLock sl (lock);
+        entries = list;
+    }
+
+    // The first entry loads the normal way
+    const Entry& first = list.getReference(0);
+
+    if (first.path.endsWith(".json"))   processor.loadJsonGalleryFromPath(first.path);
+    else                                processor.loadGalleryFromPath(first.path);
+
+    if (first.pianoId > 0 && processor.gallery->getPiano(first.pianoId) != nullptr) processor.setCurrentPiano(first.pianoId);
+
+    position.set(0);
+    active.set(1);
+
+    startThread(3);
+}
+
+void Setlist::clear(void)
+{
+    active.set(0);
+
+    stopThread(4000);
+
+    {
+        // The audio thread may already be inside advance() with one of these slots; it only gets
+        // there holding configurationLock, so this waits for the swap to finish or keeps it out.
+        const ScopedLock sl (processor.configurationLock);
+
+        for (auto slot : slots) releaseSlot(*slot);
+    }
+
+    retiredGalleries.clear();
+    retiredPianos.clear();
+
+    rejectedIndex = -1;
+    rejectedBytes = 0;
+
+    position.set(-1);
+    advanceRequested.set(0);
+
+    const ScopedLock sl (lock);
+    entries.clear();
+}
+
+//==============================================================================
+bool Setlist::advance(void)
+{
+    if (!isActive()) return false;
+
+    const int next = position.get() + 1;
+
+    for (auto slot : slots)
+    {
+        if (!slot->state.compareAndSetBool(SlotSwapping, SlotReady)) continue;
+
+        if (slot->index != next)
+        {
+            slot->state.set(SlotReady);
+            continue;
+        }
+
+        if (!processor.swapInGallery(slot->gallery, slot->piano, slot->outGallery, slot->outPiano))
+        {
+            slot->state.set(SlotReady);
+            return false;
+        }
+
+        position.set(next);
+
+        slot->state.set(SlotTaken);
+
+        return true;
+    }
+
+    return false;
+}
+
+//==============================================================================
+void Setlist::run(void)
+{
+    while (!threadShouldExit())
+    {
+        collect();
+
+        prefetch();
+
+        wait(SETLIST_POLL_MS);
+    }
+}
+
+void Setlist::prefetch(void)
+{
+    Array<Entry> list;
+    int ahead;
+    int64 budget;
+
+    {
+        const ScopedLock sl (lock);
+        list = entries;
+        ahead = prefetchEntries;
+        budget = prefetchBytes;
+    }
+
+    const int current = position.get();
+
+    // Let go of anything we no longer need (behind us, or too far ahead after a limit change)
+    for (auto slot : slots)
+    {
+        if (slot->index > current && slot->index <= current + ahead) continue;
+
+        if (slot->state.compareAndSetBool(SlotLoading, SlotReady) ||
+            slot->state.compareAndSetBool(SlotLoading, SlotFailed))
+        {
+            releaseSlot(*slot);
+        }
+    }
+
+    int64 used = 0;
+    for (auto slot : slots) if (slot->state.get() == SlotReady) used += slot->bytes;
+
+    for (int k = 1; k <= ahead && !threadShouldExit(); k++)
+    {
+        const int index = current + k;
+
+        if (index >= list.size()) break;
+
+        Slot* free = nullptr;
+        bool have = false;
+
+        for (auto slot : slots)
+        {
+            const int state = slot->state.get();
+
+            if (slot->index == index && state != SlotEmpty && state != SlotTaken) have = true;
+            if (state == SlotEmpty && free == nullptr) free = slot;
+        }
+
+        if (have) continue;
+        if (free == nullptr) break;
+
+        // Beyond the next entry, stay within the memory budget. An entry we've already had to let go of is
+        // judged by what it came to last time; it only loads again once the position or the budget leaves room.
+        if (k > 1 && used >= budget) break;
+        if (k > 1 && index == rejectedIndex && used + rejectedBytes > budget) break;
+
+        free->state.set(SlotLoading);
+        free->index = index;
+
+        if (!load(list.getReference(index), *free))
+        {
+            DBG("setlist: could not load " + list.getReference(index).path);
+
+            free->state.set(SlotFailed);
+            continue;
+        }
+
+        if (k > 1 && used + free->bytes > budget)
+        {
+            DBG("setlist: " + String(index) + " (" + String(free->bytes >> 10) + " KB) is over budget");
+
+            rejectedIndex = index;
+            rejectedBytes = free->bytes;
+
+            releaseSlot(*free);
+            break;
+        }
+
+        if (index == rejectedIndex) rejectedIndex = -1;
+
+        used += free->bytes;
+
+        free->state.set(SlotReady);
+
+        DBG("setlist: prefetched " + String(index) + " (" + String(free->bytes >> 10) + " KB)");
+
+        // The audio thread moved on while we were loading; start over from the new position
+        if (position.get() != current) return;
+    }
+}
+
+bool Setlist::load(const Entry& entry, Slot& slot)
+{
+    File file (entry.path);
+
+    if (!file.existsAsFile()) return false;
+
+    Gallery::Ptr gallery;
+
+    // Reading and parsing happen without any lock. Building the gallery creates components
+    // (its graph items), so that part holds the message manager lock.
+    if (file.hasFileExtension(".json"))
+    {
+        var json = JSON::parse(file);
+
+        const MessageManagerLock mml (this);
+        if (!mml.lockWasGained()) return false;
+
+        gallery = new Gallery(json, processor);
+    }
+    else
+    {
+        ScopedPointer<XmlElement> xml (XmlDocument::parse(file));
+
+        if (xml == nullptr) return false;
+
+        const MessageManagerLock mml (this);
+        if (!mml.lockWasGained()) return false;
+
+        gallery = new Gallery(xml, processor);
+    }
+
+    gallery->setURL(file.getFullPathName());
+
+    if (gallery->getPianos().size() == 0)
+    {
+        Gallery::PtrArr galleries;
+        Piano::PtrArr none;
+
+        galleries.add(gallery);
+
+        gallery = nullptr;
+        release(galleries, none);
+
+        return false;
+    }
+
+    // The gallery isn't playing, so its pianos configure against their own lock (see Piano::getConfigurationLock)
+    for (auto piano : gallery->getPianos())
+    {
+        piano->configure();
+
+        if (piano->getId() > gallery->getIdCount(PreparationTypePiano)) gallery->setIdCount(PreparationTypePiano, piano->getId());
+
+#if TRY_UNDO
+        piano->getHistory()->clear();
+#endif
+    }
+
+    gallery->prepareToPlay(processor.getSampleRate());
+    gallery->resetPreparations();
+    gallery->setGalleryDirty(false);
+
+    int which = (entry.pianoId > 0) ? entry.pianoId : gallery->getDefaultPiano();
+
+    Piano::Ptr piano = gallery->getPiano(which);
+    if (piano == nullptr) piano = gallery->getPianos().getFirst();
+
+    gallery->setDefaultPiano(piano->getId());
+
+    slot.gallery = gallery;
+    slot.piano = piano;
+    slot.bytes = estimateMemory(gallery);
+
+    return true;
+}
+
+void Setlist::collect(void)
+{
+    for (auto slot : slots)
+    {
+        if (slot->state.get() != SlotTaken) continue;
+
+        if (slot->outGallery != nullptr)    retiredGalleries.add(slot->outGallery);
+        if (slot->outPiano != nullptr)      retiredPianos.add(slot->outPiano);
+
+        slot->outGallery = nullptr;
+        slot->outPiano = nullptr;
+        slot->index = -1;
+        slot->bytes = 0;
+
+        slot->state.set(SlotEmpty);
+    }
+
+    if (retiredGalleries.size() == 0 && retiredPianos.size() == 0) return;
+
+    Gallery::PtrArr galleries;
+    Piano::PtrArr pianos;
+
+    {
+        // processBlock holds this for the whole block, so the processor's pianos can't change while we look
+        const ScopedLock sl (processor.configurationLock);
+
+        for (int i = retiredGalleries.size(); --i >= 0;)
+        {
+            if (isInUse(retiredGalleries.getUnchecked(i))) continue;
+
+            galleries.add(retiredGalleries.getUnchecked(i));
+            retiredGalleries.remove(i);
+        }
+
+        for (int i = retiredPianos.size(); --i >= 0;)
+        {
+            if (isInUse(retiredPianos.getUnchecked(i))) continue;
+
+            pianos.add(retiredPianos.getUnchecked(i));
+            retiredPianos.remove(i);
+        }
+    }
+
+    release(galleries, pianos);
+}
+
+void Setlist::release(Gallery::PtrArr& galleries, Piano::PtrArr& pianos)
+{
+    if (galleries.size() == 0 && pianos.size() == 0) return;
+
+    // Galleries own graph items, which are components and must be deleted under the message manager lock
+    const MessageManagerLock mml (Thread::getCurrentThread());
+
+    if (!mml.lockWasGained())
+    {
+        // Shutting down: hand them back so the destructor deletes them on the message thread
+        retiredGalleries.addArray(galleries);
+        retiredPianos.addArray(pianos);
+    }
+
+    galleries.clear();
+    pianos.clear();
+}
+
+void Setlist::releaseSlot(Slot& slot)
+{
+    Gallery::PtrArr galleries;
+    Piano::PtrArr pianos;
+
+    if (slot.gallery != nullptr)    galleries.add(slot.gallery);
+    if (slot.piano != nullptr)      pianos.add(slot.piano);
+    if (slot.outGallery != nullptr) galleries.add(slot.outGallery);
+    if (slot.outPiano != nullptr)   pianos.add(slot.outPiano);
+
+    slot.gallery = nullptr;
+    slot.piano = nullptr;
+    slot.outGallery = nullptr;
+    slot.outPiano = nullptr;
+    slot.index = -1;
+    slot.bytes = 0;
+
+    slot.state.set(SlotEmpty);
+
+    if (Thread::getCurrentThread() == this) release(galleries, pianos);
+}
+
+bool Setlist::isInUse(Piano::Ptr piano)
+{
+    return (piano == processor.currentPiano || piano == processor.prevPiano || processor.prevPianos.contains(piano));
+}
+
+bool Setlist::isInUse(Gallery::Ptr gallery)
+{
+    if (gallery == processor.gallery) return true;
+
+    for (auto piano : gallery->getPianos()) if (isInUse(piano)) return true;
+
+    return false;
+}
+
+int64 Setlist::estimateMemory(Gallery::Ptr gallery)
+{
+    // Rough: the objects a gallery and its pianos allocate. Good enough to bound how many we keep around.
+    BKMemoryReport report(gallery->getName());
+
+    gallery->reportMemory(report);
+
+    return report.getTotalBytes();
+}
+
+void Setlist::reportMemory(BKMemoryReport& report) const
+{
+    // Estimated when they were loaded; the loader leaves ready slots alone
+    for (auto slot : slots)
+    {
+        if (slot->state.get() == SlotReady) report.add("entry " + String(slot->index + 1), slot->bytes, 1);
+    }
+}
@@ -0,0 +1,150 @@
+/*
+  ==============================================================================
+
+    Setlist.h
+    Created: 19 Oct 2026 2:31:10pm
+    Author:
+
+    An ordered list of (gallery, piano) entries for performance. While one
+    entry plays, the next ones are loaded, configured and prepared on a
+    background thread, so stepping forward (program change, the advance
+    key, or Gallery > Next in Setlist) is just a pointer swap on the audio
+    thread. Galleries that are swapped out are released on the background
+    thread once nothing sounding still points into them.
+
+    Setlist files are xml:
+
+        <setlist prefetch="2" maxMegabytes="256" advanceKey="-1">
+            <entry gallery="NS_1_Prelude.xml" piano="1"/>
+            ...
+        </setlist>
+
+    Gallery paths may be absolute or relative to the setlist file. A piano
+    of 0 (or none) plays the gallery's default piano.
+
+  ==============================================================================
+*/
+
+#ifndef SETLIST_H_INCLUDED
+#define SETLIST_H_INCLUDED
+
+#include "BKUtilities.h"
+
+#include "Gallery.h"
+
+class BKAudioProcessor;
+
+class Setlist : public Thread,
+                public BKMemoryAccountable
+{
+public:
+    struct Entry
+    {
+        String path;
+        int pianoId;
+    };
+
+    Setlist(BKAudioProcessor& p);
+    ~Setlist();
+
+    // Message thread. Loads the first entry right away and starts prefetching the ones after it.
+    bool loadFromFile(const File& file);
+    void start(const Array<Entry>& entries);
+    void clear(void);
+
+    inline bool isActive(void) const noexcept { return active.get() != 0; }
+
+    // Index of the entry playing, -1 if none
+    inline int getPosition(void) const noexcept { return position.get(); }
+    int getNumEntries(void) const;
+    Entry getEntry(int index) const;
+
+    // How many entries ahead to prefetch (1 to maxPrefetch), and roughly how much memory they may use.
+    // The next entry is always prefetched, whatever its size.
+    void setPrefetchLimit(int numEntries, int64 maxBytes);
+
+    // MIDI note that advances the setlist instead of playing, -1 for none
+    inline void setAdvanceKey(int noteNumber) noexcept { advanceKey.set(noteNumber); }
+    inline int getAdvanceKey(void) const noexcept { return advanceKey.get(); }
+
+    // Any thread. The audio thread picks it up at the start of the next block.
+    inline void requestAdvance(void) noexcept { advanceRequested.set(1); }
+    inline bool takeAdvanceRequest(void) noexcept { return advanceRequested.compareAndSetBool(0, 1); }
+
+    // Audio thread. Swaps in the next entry if it has been prefetched; false if it isn't ready (or there isn't one),
+    // or if too many previous pianos are still sounding to keep track of another.
+    bool advance(void);
+
+    // Galleries prefetched and waiting to be swapped in
+    void reportMemory(BKMemoryReport& report) const override;
+
+    enum { maxPrefetch = 4 };
+
+private:
+    enum SlotState
+    {
+        SlotEmpty = 0,
+        SlotLoading,    // owned by the loader thread
+        SlotReady,      // may be taken by the audio thread
+        SlotSwapping,   // being taken by the audio thread
+        SlotTaken,      // swapped in; the loader collects what was swapped out
+        SlotFailed      // couldn't load this entry, don't keep trying
+    };
+
+    struct Slot
+    {
+        Slot(void): index(-1), bytes(0) {}
+
+        Atomic<int> state;
+        int index;
+
+        Gallery::Ptr gallery;
+        Piano::Ptr piano;
+        int64 bytes;
+
+        // what the audio thread swapped out for this slot
+        Gallery::Ptr outGallery;
+        Piano::Ptr outPiano;
+    };
+
+    BKAudioProcessor& processor;
+
+    CriticalSection lock;           // guards entries and the limits
+    Array<Entry> entries;
+    int prefetchEntries;
+    int64 prefetchBytes;
+
+    Atomic<int> position;
+    Atomic<int> active;
+    Atomic<int> advanceKey;
+    Atomic<int> advanceRequested;
+
+    OwnedArray<Slot> slots;
+
+    // Swapped out of the processor but maybe still sounding (loader thread only)
+    Gallery::PtrArr retiredGalleries;
+    Piano::PtrArr retiredPianos;
+
+    // The last entry that was loaded and didn't fit in the budget, and what it came to, so it isn't
+    // loaded again every poll only to be let go (loader thread only; reset by clear)
+    int rejectedIndex;
+    int64 rejectedBytes;
+
+    void run(void) override;
+
+    void prefetch(void);
+    bool load(const Entry& entry, Slot& slot);
+    void collect(void);
+    void releaseSlot(Slot& slot);
+    void release(Gallery::PtrArr& galleries, Piano::PtrArr& pianos);
+
+    bool isInUse(Piano::Ptr piano);
+    bool isInUse(Gallery::Ptr gallery);
+
+    static int64 estimateMemory(Gallery::Ptr gallery);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Setlist)
+};
+
+
+#endif  // SETLIST_H_INCLUDED
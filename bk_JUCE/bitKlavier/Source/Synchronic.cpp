@@ -19,7 +19,9 @@ synth(main),
 general(general),
 synchronic(synchronic),
 tuner(tuning),
-tempo(tempo)
+tempo(tempo),
+editorEvents(nullptr),
+blackBox(nullptr)
 {
     velocities.ensureStorageAllocated(128);
     for (int i = 0; i < 128; i++)
@@ -100,6 +102,7 @@ void SynchronicProcessor::resetPhase(int skipBeats)
     
     beatCounter = 0;
 
+    if (editorEvents != nullptr) editorEvents->push(EditorEventCountersMoved, PreparationTypeSynchronic, getId());
 }
 
 void SynchronicProcessor::keyPressed(int noteNumber, float velocity)
@@ -302,6 +305,10 @@ void SynchronicProcessor::processBlock(int numSamples, int channel)
             //increment beat and beatMultiplier counters, for next beat; check maxes and adjust
             if (++beatMultiplierCounter >= synchronic->aPrep->getBeatMultipliers().size()) beatMultiplierCounter = 0;
             if (++beatCounter >= synchronic->aPrep->getNumBeats()) shouldPlay = false; //done with pulses
+            
+            if (blackBox != nullptr) blackBox->record(BlackBoxPulse, getId(), beatCounter);
+            
+            if (editorEvents != nullptr) editorEvents->push(EditorEventCountersMoved, PreparationTypeSynchronic, getId());
 
         }
         
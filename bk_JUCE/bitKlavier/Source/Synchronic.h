@@ -17,6 +17,7 @@
 #include "Tempo.h"
 #include "General.h"
 #include "Keymap.h"
+#include "BKBlackBox.h"
 
 class SynchronicPreparation : public ReferenceCountedObject
 {
@@ -894,6 +895,10 @@ public:
     inline const int getAccentMultiplierCounter() const noexcept { return accentMultiplierCounter; }
     inline const int getLengthMultiplierCounter() const noexcept { return lengthMultiplierCounter; }
     inline const int getTranspCounter() const noexcept { return transpCounter; }
+    
+    inline void setEditorEvents(BKEditorEventQueue* events) { editorEvents = events; }
+    inline void setBlackBox(BKBlackBox* box) { blackBox = box; }
+    
     inline const SynchronicSyncMode getMode() const noexcept {return synchronic->aPrep->getMode(); }
 
     inline int getId(void) const noexcept { return synchronic->getId(); }
@@ -972,6 +977,9 @@ private:
     int lengthMultiplierCounter; //note length (sounding length) multipliers (multiples of 50ms, at least for now)
     int transpCounter;     //transposition offsets
     
+    BKEditorEventQueue* editorEvents; // not owned; told when the counters move
+    BKBlackBox* blackBox; // not owned; told about every pulse (OVERRUN_WATCHDOG)
+    
     //reset the phase, including of all the parameter fields
     void resetPhase(int skipBeats);
     
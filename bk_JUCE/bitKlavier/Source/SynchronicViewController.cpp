@@ -240,11 +240,9 @@ SynchronicViewController(p, theGraph)
 
     gainSlider->addMyListener(this);
     
-    startTimer(30);
-    
 }
 
-void SynchronicPreparationEditor::timerCallback()
+void SynchronicPreparationEditor::updateCounters(void)
 {
     if (processor.updateState->currentDisplay == DisplaySynchronic)
     {
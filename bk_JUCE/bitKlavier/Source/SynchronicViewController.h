@@ -78,8 +78,7 @@ class SynchronicPreparationEditor :
 public SynchronicViewController,
 public BKSingleSlider::Listener,
 public BKRangeSlider::Listener,
-public BKEditableComboBoxListener,
-public Timer
+public BKEditableComboBoxListener
 {
 public:
     SynchronicPreparationEditor(BKAudioProcessor&, BKItemGraph* theGraph);
@@ -89,7 +88,8 @@ public:
     
     void update(NotificationType notify);
     
-    void timerCallback() override;
+    // Moves the sliders to where the processor's counters are; called when they step
+    void updateCounters(void);
     
     void fillSelectCB(int last, int current);
     
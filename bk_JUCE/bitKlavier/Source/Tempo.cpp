@@ -11,7 +11,8 @@
 #include "Tempo.h"
 
 TempoProcessor::TempoProcessor(Tempo::Ptr t):
-tempo(t)
+tempo(t),
+editorEvents(nullptr)
 {
     atTimer = 0;
     atLastTime = 0;
@@ -86,6 +87,8 @@ void TempoProcessor::atCalculatePeriodMultiplier()
                                             tempo->aPrep->getAdaptiveTempo1Subdivisions();
             
             DBG("adaptiveTempoPeriodMultiplier = " + String(adaptiveTempoPeriodMultiplier));
+            
+            if (editorEvents != nullptr) editorEvents->push(EditorEventPreparationChanged, PreparationTypeTempo, getId());
         }
     }
 }
@@ -97,4 +100,6 @@ void TempoProcessor::adaptiveReset()
         atDeltaHistory.insert(0, (60000.0/tempo->aPrep->getTempo()));
     }
     adaptiveTempoPeriodMultiplier = 1.;
+    
+    if (editorEvents != nullptr) editorEvents->push(EditorEventPreparationChanged, PreparationTypeTempo, getId());
 }
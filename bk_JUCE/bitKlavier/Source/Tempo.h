@@ -521,6 +521,7 @@ public:
     uint64 getAtTimer() { return atTimer; }
     uint64 getAtLastTime() { return atLastTime; }
     Array<int> getAtDeltaHistory() { return atDeltaHistory; }
+    inline int getNumAtDeltas(void) const noexcept { return atDeltaHistory.size(); }
     float getAdaptiveTempoPeriodMultiplier() { return adaptiveTempoPeriodMultiplier; }
     
     void setAtTimer(uint64 newval) { atTimer = newval; }
@@ -534,6 +535,8 @@ public:
         }
     }
     void setAdaptiveTempoPeriodMultiplier(float val) { adaptiveTempoPeriodMultiplier = val; }
+    
+    inline void setEditorEvents(BKEditorEventQueue* events) { editorEvents = events; }
     
 private:
     GeneralSettings::Ptr general;
@@ -551,6 +554,8 @@ private:
     void atCalculatePeriodMultiplier();
     float adaptiveTempoPeriodMultiplier;
     
+    BKEditorEventQueue* editorEvents; // not owned; told when the tempo adapts
+    
     
     JUCE_LEAK_DETECTOR(TempoProcessor);
 };
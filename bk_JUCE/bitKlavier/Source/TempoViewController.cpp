@@ -247,12 +247,10 @@ TempoViewController(p, theGraph)
     AT1SubdivisionsSlider->addMyListener(this);
     AT1MinMaxSlider->addMyListener(this);
     
-    startTimer(50);
-    
     update();
 }
 
-void TempoPreparationEditor::timerCallback()
+void TempoPreparationEditor::updateAdaptedTempo(void)
 {
     if (processor.updateState->currentDisplay == DisplayTempo)
     {
@@ -71,15 +71,15 @@ class TempoPreparationEditor :
 public TempoViewController,
 public BKEditableComboBoxListener,
 public BKRangeSlider::Listener,
-public BKSingleSlider::Listener,
-public Timer
+public BKSingleSlider::Listener
 {
 public:
     
     TempoPreparationEditor(BKAudioProcessor&, BKItemGraph* theGraph);
     ~TempoPreparationEditor(){};
     
-    void timerCallback() override;
+    // Shows the adapted tempo; called when the processor adapts it
+    void updateAdaptedTempo(void);
     
     void update(void) override;
     
@@ -14,7 +14,8 @@
 TuningProcessor::TuningProcessor(Tuning::Ptr tuning):
 tuning(tuning),
 lastNoteTuning(0),
-lastIntervalTuning(0)
+lastIntervalTuning(0),
+editorEvents(nullptr)
 {
 }
 
@@ -34,6 +35,7 @@ float TuningProcessor::getOffset(int midiNoteNumber)
         float lastNoteOffset = adaptiveCalculate(midiNoteNumber);
         lastNoteTuning = midiNoteNumber + lastNoteOffset;
         lastIntervalTuning = lastNoteTuning - lastNoteTuningTemp;
+        lastNoteTuningDidChange(lastNoteTuningTemp);
         return lastNoteOffset;
     }
     
@@ -50,11 +52,18 @@ float TuningProcessor::getOffset(int midiNoteNumber)
     
     lastNoteTuning = midiNoteNumber + lastNoteOffset;
     lastIntervalTuning = lastNoteTuning - lastNoteTuningTemp;
+    lastNoteTuningDidChange(lastNoteTuningTemp);
     
     return lastNoteOffset;
     
 }
 
+void TuningProcessor::lastNoteTuningDidChange(float previous)
+{
+    if (editorEvents != nullptr && lastNoteTuning != previous)
+        editorEvents->push(EditorEventPreparationChanged, PreparationTypeTuning, getId());
+}
+
 
 //for keeping track of current cluster size
 void TuningProcessor::processBlock(int numSamples)
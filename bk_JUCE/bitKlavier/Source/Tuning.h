@@ -13,6 +13,7 @@
 
 #include "BKUtilities.h"
 #include "AudioConstants.h"
+#include "BKEditorEvents.h"
 
 #include "Keymap.h"
 
@@ -569,6 +570,8 @@ public:
     void setAdaptiveFundamentalFreq(float newFreq) { adaptiveFundamentalFreq = newFreq;}
     void setAdaptiveHistoryCounter(int newCounter) { adaptiveHistoryCounter = newCounter;}
     
+    inline void setEditorEvents(BKEditorEventQueue* events) { editorEvents = events; }
+    
     //reset adaptive tuning
     void adaptiveReset();
     
@@ -588,6 +591,9 @@ private:
     float lastNoteTuning;
     float lastIntervalTuning;
     
+    BKEditorEventQueue* editorEvents; // not owned; told when the last note's tuning changes
+    void lastNoteTuningDidChange(float previous);
+    
     //adaptive tuning functions
     float   adaptiveCalculate(int midiNoteNumber) const;
     void    newNote(int midiNoteNumber, TuningSystem tuningType);
@@ -383,12 +383,10 @@ TuningViewController(p, theGraph)
     
     offsetSlider->addMyListener(this);
     
-    startTimer(50);
-    
     update();
 }
 
-void TuningPreparationEditor::timerCallback()
+void TuningPreparationEditor::updateLastNote(void)
 {
     if (processor.updateState->currentDisplay == DisplayTuning)
     {
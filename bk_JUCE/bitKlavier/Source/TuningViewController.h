@@ -99,15 +99,15 @@ class TuningPreparationEditor :
 public TuningViewController,
 public BKEditableComboBoxListener,
 public BKSingleSlider::Listener,
-public BKKeyboardSlider::Listener,
-public Timer
+public BKKeyboardSlider::Listener
 {
 public:
     
     TuningPreparationEditor(BKAudioProcessor&, BKItemGraph* theGraph);
     ~TuningPreparationEditor() {setLookAndFeel(nullptr);};
     
-    void timerCallback() override;
+    // Shows the last note and interval; called when the processor tunes a new one
+    void updateLastNote(void);
     
     void update(void) override;
     